@@ -7,7 +7,7 @@
 
 namespace code {
 
-	Arena::Arena() {}
+	Arena::Arena() : peephole(true), optimize(true) {}
 
 	Ref Arena::external(const wchar *name, const void *ptr) const {
 		return Ref(externalSource(name, ptr));
@@ -20,6 +20,10 @@ namespace code {
 	}
 
 	Listing *Arena::transform(Listing *src, Binary *owner) const {
+		return transform(src, owner, false);
+	}
+
+	Listing *Arena::transform(Listing *src, Binary *owner, Bool fast) const {
 		assert(false);
 		return src;
 	}
@@ -33,7 +33,11 @@ namespace code {
 
 		// Transform the code in preparation for this backend's code generation. This is
 		// backend-specific. 'owner' is the binary object that will be called to handle exceptions.
-		virtual Listing *STORM_FN transform(Listing *src, MAYBE(Binary *) owner) const;
+		Listing *STORM_FN transform(Listing *src, MAYBE(Binary *) owner) const;
+
+		// Same as above, but if 'fast' is true, optimizations are skipped in order to generate
+		// code quickly.
+		virtual Listing *STORM_FN transform(Listing *src, MAYBE(Binary *) owner, Bool fast) const;
 
 		// Translate a previously transformed listing into machine code for this arena.
 		virtual void STORM_FN output(Listing *src, Output *to) const;
@@ -94,6 +98,18 @@ namespace code {
 		// Access the location of the first parameter in a function size. The returned Operand is
 		// always pointer-sized.
 		virtual Operand STORM_FN firstParamLoc(Nat id);
+
+		/**
+		 * Optimizations.
+		 */
+
+		// Apply peephole optimizations in 'transform'? Backends that do not support peephole
+		// optimizations ignore this flag. Mainly useful to measure the effect of the optimizations.
+		Bool peephole;
+
+		// Apply backend-independent optimizations (constant folding, removal of dead code, etc.)
+		// in 'transform'?
+		Bool optimize;
 	};
 
 	// Create an arena for this platform.
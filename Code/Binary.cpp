@@ -1,20 +1,63 @@
 #include "stdafx.h"
 #include "Binary.h"
 #include "Exception.h"
+#include "Reference.h"
+#include "Recording.h"
 #include "Core/StrBuf.h"
+#include "Core/Str.h"
+#include "Gc/PerfMap.h"
 
 namespace code {
 
-	Binary::Binary(Arena *arena, Listing *listing) {
-		compile(arena, listing, false);
+	Binary::Binary(Arena *arena, Listing *listing) : pending(null) {
+		compile(arena, listing, false, false, null);
 	}
 
-	Binary::Binary(Arena *arena, Listing *listing, Bool debug) {
-		compile(arena, listing, debug);
+	Binary::Binary(Arena *arena, Listing *listing, Bool debug) : pending(null) {
+		compile(arena, listing, debug, false, null);
 	}
 
-	void Binary::compile(Arena *arena, Listing *listing, Bool debug) {
-		Listing *tfm = arena->transform(listing, this);
+	Binary::Binary(Arena *arena, Listing *listing, Bool debug, Bool fast) : pending(null) {
+		compile(arena, listing, debug, fast, null);
+	}
+
+	Binary::Binary(Arena *arena, Listing *listing, Bool fast, Array<Reference *> *pending, Recording *record) : pending(pending) {
+		compile(arena, listing, false, fast, record);
+	}
+
+	Binary::Binary(Arena *arena, Recording *from) : pending(null) {
+		loadBlocks(from);
+		tryBlocks = null;
+		metaOffset = from->metaOffset;
+		replay(arena, from);
+	}
+
+	Binary *Binary::detached(Arena *arena, Listing *listing, Bool fast) {
+		return detached(arena, listing, fast, null);
+	}
+
+	Binary *Binary::detached(Arena *arena, Listing *listing, Bool fast, MAYBE(Recording *) record) {
+		return new (arena) Binary(arena, listing, fast, new (arena) Array<Reference *>(), record);
+	}
+
+	void Binary::attach() {
+		if (!pending)
+			return;
+
+		for (Nat i = 0; i < pending->count(); i++)
+			pending->at(i)->attach();
+		pending = null;
+	}
+
+	void Binary::addReference(Reference *ref) {
+		if (pending)
+			pending->push(ref);
+		else
+			ref->attach();
+	}
+
+	void Binary::compile(Arena *arena, Listing *listing, Bool debug, Bool fast, Recording *record) {
+		Listing *tfm = arena->transform(listing, this, fast);
 		if (debug)
 			PVAR(tfm);
 
@@ -34,12 +77,189 @@ namespace code {
 		}
 
 		CodeOutput *output = arena->codeOutput(this, labels);
-		arena->output(tfm, output);
+		if (record && !tryBlocks) {
+			RecordOutput *r = new (this) RecordOutput(output, this, record);
+			arena->output(tfm, r);
+			r->done();
+
+			record->size = labels->size;
+			record->refs = labels->refs;
+			record->metaOffset = metaOffset;
+			saveBlocks(record);
+		} else {
+			arena->output(tfm, output);
+			if (record)
+				record->portable = false;
+		}
 
 		runtime::codeUpdatePtrs(output->codePtr());
 		set(output->codePtr(), output->tell());
 	}
 
+	static void malformed(Recording *r) {
+		throw new (r) InvalidValue(S("Malformed code recording."));
+	}
+
+	// Read data from a recording.
+	template <class T>
+	static T read(Recording *r, Nat &pos) {
+		T result;
+		if (pos + sizeof(T) > r->ops.filled())
+			malformed(r);
+		memcpy(&result, r->ops.dataPtr() + pos, sizeof(T));
+		pos += sizeof(T);
+		return result;
+	}
+
+	static RefSource *readSource(Recording *r, Nat &pos) {
+		Nat id = read<Nat>(r, pos);
+		if (id >= r->sources->count())
+			malformed(r);
+		return r->sources->at(id);
+	}
+
+	// Make sure there is room for 'bytes' more bytes in the output, so that a malformed recording
+	// can not write outside of the allocation.
+	static void reserve(CodeOutput *out, Recording *r, Nat bytes) {
+		if (out->tell() + bytes > r->size)
+			malformed(r);
+	}
+
+	void Binary::replay(Arena *arena, Recording *from) {
+		CodeOutput *output = arena->codeOutput(this, new (this) Array<Nat>(), from->size, from->refs);
+		Word start = Word(output->codePtr());
+		Nat refs = 0;
+
+		Nat pos = 0;
+		while (pos < from->ops.filled()) {
+			switch (read<Byte>(from, pos)) {
+			case Recording::opByte:
+				reserve(output, from, 1);
+				output->putByte(read<Byte>(from, pos));
+				break;
+			case Recording::opInt:
+				reserve(output, from, 4);
+				output->putInt(read<Nat>(from, pos));
+				break;
+			case Recording::opLong:
+				reserve(output, from, 8);
+				output->putLong(read<Word>(from, pos));
+				break;
+			case Recording::opPtr:
+				reserve(output, from, sizeof(void *));
+				output->putPtr(read<Word>(from, pos));
+				break;
+			case Recording::opAlign:
+				output->align(read<Nat>(from, pos));
+				reserve(output, from, 0);
+				break;
+			case Recording::opPtrSelf:
+				reserve(output, from, sizeof(void *));
+				output->putPtrSelf(start + read<Nat>(from, pos));
+				refs++;
+				break;
+			case Recording::opGcRef: {
+				Nat kind = read<Nat>(from, pos);
+				Nat size = read<Nat>(from, pos);
+				reserve(output, from, size);
+				output->putGc(GcCodeRef::Kind(kind), size, Ref(readSource(from, pos)));
+				refs++;
+				break;
+			}
+			case Recording::opGcPtrRef:
+				reserve(output, from, sizeof(void *));
+				output->putAddress(Ref(readSource(from, pos)));
+				refs++;
+				break;
+			case Recording::opGcRelRef:
+				reserve(output, from, sizeof(void *));
+				output->putRelative(Ref(readSource(from, pos)));
+				refs++;
+				break;
+			case Recording::opOwner:
+				reserve(output, from, sizeof(void *));
+				output->putObject(this);
+				refs++;
+				break;
+			case Recording::opProlog:
+				output->markProlog();
+				break;
+			case Recording::opEpilog:
+				output->markEpilog();
+				break;
+			case Recording::opSaved: {
+				Nat reg = read<Nat>(from, pos);
+				Int offset = Int(read<Nat>(from, pos));
+				output->markSaved(Reg(reg), Offset(offset));
+				break;
+			}
+			default:
+				malformed(from);
+			}
+
+			if (refs > from->refs)
+				malformed(from);
+		}
+
+		runtime::codeUpdatePtrs(output->codePtr());
+		set(output->codePtr(), output->tell());
+	}
+
+	void Binary::saveBlocks(Recording *to) {
+		for (size_t i = 0; i < blocks->count; i++) {
+			Block *b = blocks->v[i];
+			to->blocks->push(Nat(b->parent));
+			to->blocks->push(Nat(b->count));
+			for (size_t j = 0; j < b->count; j++) {
+				to->blocks->push(b->vars[j].id);
+				to->blocks->push(b->vars[j].flags);
+			}
+		}
+	}
+
+	void Binary::loadBlocks(Recording *from) {
+		Array<Nat> *src = from->blocks;
+
+		// Count the blocks first.
+		Nat count = 0;
+		for (Nat at = 0; at + 1 < src->count(); at += 2 + 2*src->at(at + 1))
+			count++;
+
+		blocks = runtime::allocArray<Block *>(engine(), &blockArrayType, count);
+
+		Nat at = 0;
+		for (Nat i = 0; i < count; i++) {
+			Nat vars = src->at(at + 1);
+			if (at + 2 + 2*vars > src->count())
+				malformed(from);
+
+			Block *b = (Block *)runtime::allocArray(engine(), &blockType, vars);
+			blocks->v[i] = b;
+			b->parent = src->at(at);
+			at += 2;
+
+			for (Nat j = 0; j < vars; j++) {
+				b->vars[j].id = src->at(at++);
+				b->vars[j].flags = src->at(at++);
+			}
+		}
+
+		// Make sure the hierarchy does not refer to blocks that do not exist.
+		for (Nat i = 0; i < count; i++) {
+			Nat parent = Nat(blocks->v[i]->parent);
+			if (parent != code::Block().key() && parent >= count)
+				malformed(from);
+		}
+	}
+
+	void Binary::named() {
+		if (!storm::perfMap().enabled() || !address())
+			return;
+
+		if (Str *name = ownerName())
+			storm::perfMap().name((void *)address(), name->utf8_str());
+	}
+
 	void Binary::toS(StrBuf *to) const {
 		*to << S("Binary object:");
 
@@ -1,6 +1,7 @@
 #pragma once
 #include "Core/TObject.h"
 #include "Core/GcType.h"
+#include "Core/Array.h"
 #include "Arena.h"
 #include "Listing.h"
 #include "RefSource.h"
@@ -9,6 +10,9 @@
 namespace code {
 	STORM_PKG(core.asm);
 
+	class Reference;
+	class Recording;
+
 	/**
 	 * A Binary represents a Listing that has been translated into machine code, along with any
 	 * extra information needed (such as descriptions of exception handlers or similar).
@@ -28,6 +32,28 @@ namespace code {
 		// Output the transformed ASM code for debugging.
 		Binary(Arena *arena, Listing *src, Bool debug);
 
+		// Translate a listing. If 'fast' is true, optimizations are skipped to reduce the time
+		// needed for compilation.
+		Binary(Arena *arena, Listing *src, Bool debug, Bool fast);
+
+		// Translate a listing without attaching the References in the generated code to their
+		// RefSources. This makes it possible to translate the listing on another thread than the
+		// Compiler thread. Call 'attach' on the Compiler thread before the code is used.
+		static Binary *detached(Arena *arena, Listing *src, Bool fast);
+
+		// Translate a listing detached, and record the output into 'record' if it is not null.
+		static Binary *detached(Arena *arena, Listing *src, Bool fast, MAYBE(Recording *) record);
+
+		// Re-create the code from a recording. The RefSources in the recording may be replaced
+		// before calling this function. Throws an exception if the recording is malformed.
+		Binary(Arena *arena, Recording *from);
+
+		// Attach all References if we were created by 'detached'.
+		void attach();
+
+		// Called by the backends for each Reference in the generated code.
+		void addReference(Reference *ref);
+
 		// Clean up a stack frame from this function.
 		void cleanup(StackFrame &frame);
 
@@ -56,7 +82,14 @@ namespace code {
 		// Output to string.
 		virtual void STORM_FN toS(StrBuf *to) const;
 
+	protected:
+		// Report the code to the perf map when we get a name.
+		virtual void named();
+
 	private:
+		// Create a detached binary. References are stored in 'pending'.
+		Binary(Arena *arena, Listing *src, Bool fast, Array<Reference *> *pending, Recording *record);
+
 		// Information about a single variable.
 		struct Variable {
 			Nat id;
@@ -108,8 +141,18 @@ namespace code {
 		// (perhaps using a binary search).
 		GcArray<TryInfo> *tryBlocks;
 
-		// Compile the Listing object.
-		void compile(Arena *arena, Listing *src, Bool debug);
+		// References that are not yet attached, if created detached.
+		MAYBE(Array<Reference *> *) pending;
+
+		// Compile the Listing object. Records the output to 'record' if it is not null.
+		void compile(Arena *arena, Listing *src, Bool debug, Bool fast, Recording *record);
+
+		// Save and restore 'blocks' to and from a recording.
+		void saveBlocks(Recording *to);
+		void loadBlocks(Recording *from);
+
+		// Replay the operations in a recording.
+		void replay(Arena *arena, Recording *from);
 
 		// Fill the 'blocks' array.
 		void fillBlocks(Listing *src);
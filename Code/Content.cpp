@@ -30,6 +30,8 @@ namespace code {
 			return null;
 	}
 
+	void Content::named() {}
+
 	StaticContent::StaticContent(const void *addr) {
 		set(addr, 0);
 	}
@@ -26,6 +26,11 @@ namespace code {
 
 		// Get the name of the owning RefSource (if any).
 		MAYBE(Str *) STORM_FN ownerName() const;
+
+	protected:
+		// Called when this content has been added to a RefSource.
+		virtual void named();
+
 	private:
 		friend class RefSource;
 
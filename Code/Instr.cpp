@@ -367,6 +367,148 @@ namespace code {
 		return instrLoose(e, op::ucast, dest, src);
 	}
 
+	static bool fpSize(const Operand &op) {
+		return op.size() == Size::sFloat || op.size() == Size::sDouble;
+	}
+
+	static bool fpIntSize(const Operand &op) {
+		return op.size() == Size::sInt || op.size() == Size::sLong;
+	}
+
+	static Instr *fpInstr(EnginePtr e, op::OpCode op, Operand dest, Operand src) {
+		if (!fpSize(dest))
+			throw new (e.v) InvalidValue(TO_S(e.v, S("For ") << name(op) << S(": Invalid size: ") << dest));
+		return instrDestSrc(e, op, dest, src);
+	}
+
+	Instr *fadd(EnginePtr e, Operand dest, Operand src) {
+		return fpInstr(e, op::fadd, dest, src);
+	}
+
+	Instr *fsub(EnginePtr e, Operand dest, Operand src) {
+		return fpInstr(e, op::fsub, dest, src);
+	}
+
+	Instr *fneg(EnginePtr e, Operand dest, Operand src) {
+		return fpInstr(e, op::fneg, dest, src);
+	}
+
+	Instr *fmul(EnginePtr e, Operand dest, Operand src) {
+		return fpInstr(e, op::fmul, dest, src);
+	}
+
+	Instr *fdiv(EnginePtr e, Operand dest, Operand src) {
+		return fpInstr(e, op::fdiv, dest, src);
+	}
+
+	Instr *fcmp(EnginePtr e, Operand a, Operand b) {
+		return fpInstr(e, op::fcmp, a, b);
+	}
+
+	Instr *fcast(EnginePtr e, Operand dest, Operand src) {
+		if (!fpSize(dest) || !fpSize(src))
+			throw new (e.v) InvalidValue(S("Invalid size for 'fcast'."));
+		dest.ensureWritable(op::fcast);
+		src.ensureReadable(op::fcast);
+		return instrLoose(e, op::fcast, dest, src);
+	}
+
+	Instr *fcasti(EnginePtr e, Operand dest, Operand src) {
+		if (!fpIntSize(dest) || !fpSize(src))
+			throw new (e.v) InvalidValue(S("Invalid size for 'fcasti'."));
+		dest.ensureWritable(op::fcasti);
+		src.ensureReadable(op::fcasti);
+		return instrLoose(e, op::fcasti, dest, src);
+	}
+
+	Instr *icastf(EnginePtr e, Operand dest, Operand src) {
+		if (!fpSize(dest) || !fpIntSize(src))
+			throw new (e.v) InvalidValue(S("Invalid size for 'icastf'."));
+		dest.ensureWritable(op::icastf);
+		src.ensureReadable(op::icastf);
+		return instrLoose(e, op::icastf, dest, src);
+	}
+
+	static Instr *vecInstr(EnginePtr e, op::OpCode op, Operand dest, Operand src) {
+		if (dest.size() != Size::sVec)
+			throw new (e.v) InvalidValue(TO_S(e.v, S("For ") << name(op) << S(": Invalid size: ") << dest));
+		if (src.type() == opConstant)
+			throw new (e.v) InvalidValue(TO_S(e.v, S("For ") << name(op) << S(": Constants are not supported.")));
+		return instrDestSrc(e, op, dest, src);
+	}
+
+	Instr *vadd(EnginePtr e, Operand dest, Operand src) {
+		return vecInstr(e, op::vadd, dest, src);
+	}
+
+	Instr *vsub(EnginePtr e, Operand dest, Operand src) {
+		return vecInstr(e, op::vsub, dest, src);
+	}
+
+	Instr *vand(EnginePtr e, Operand dest, Operand src) {
+		return vecInstr(e, op::vand, dest, src);
+	}
+
+	Instr *vor(EnginePtr e, Operand dest, Operand src) {
+		return vecInstr(e, op::vor, dest, src);
+	}
+
+	Instr *vxor(EnginePtr e, Operand dest, Operand src) {
+		return vecInstr(e, op::vxor, dest, src);
+	}
+
+	Instr *vcmpeq(EnginePtr e, Operand dest, Operand src) {
+		return vecInstr(e, op::vcmpeq, dest, src);
+	}
+
+	Instr *vcmpgt(EnginePtr e, Operand dest, Operand src) {
+		return vecInstr(e, op::vcmpgt, dest, src);
+	}
+
+	Instr *vfadd(EnginePtr e, Operand dest, Operand src) {
+		return vecInstr(e, op::vfadd, dest, src);
+	}
+
+	Instr *vfsub(EnginePtr e, Operand dest, Operand src) {
+		return vecInstr(e, op::vfsub, dest, src);
+	}
+
+	Instr *vfmul(EnginePtr e, Operand dest, Operand src) {
+		return vecInstr(e, op::vfmul, dest, src);
+	}
+
+	Instr *vfdiv(EnginePtr e, Operand dest, Operand src) {
+		return vecInstr(e, op::vfdiv, dest, src);
+	}
+
+	Instr *vfmin(EnginePtr e, Operand dest, Operand src) {
+		return vecInstr(e, op::vfmin, dest, src);
+	}
+
+	Instr *vfmax(EnginePtr e, Operand dest, Operand src) {
+		return vecInstr(e, op::vfmax, dest, src);
+	}
+
+	Instr *vfcmpeq(EnginePtr e, Operand dest, Operand src) {
+		return vecInstr(e, op::vfcmpeq, dest, src);
+	}
+
+	Instr *vfcmplt(EnginePtr e, Operand dest, Operand src) {
+		return vecInstr(e, op::vfcmplt, dest, src);
+	}
+
+	Instr *vfcmple(EnginePtr e, Operand dest, Operand src) {
+		return vecInstr(e, op::vfcmple, dest, src);
+	}
+
+	Instr *vshuffle(EnginePtr e, Operand dest, Byte order) {
+		if (dest.size() != Size::sVec)
+			throw new (e.v) InvalidValue(TO_S(e.v, S("For vshuffle: Invalid size: ") << dest));
+		dest.ensureReadable(op::vshuffle);
+		dest.ensureWritable(op::vshuffle);
+		return instrLoose(e, op::vshuffle, dest, byteConst(order));
+	}
+
 	Instr *fstp(EnginePtr e, Operand dest) {
 		if (dest.type() == opRegister)
 			throw new (e.v) InvalidValue(S("Can not store to register."));
@@ -177,7 +177,48 @@ namespace code {
 	Instr *STORM_FN icast(EnginePtr e, Operand dest, Operand src);
 	Instr *STORM_FN ucast(EnginePtr e, Operand dest, Operand src);
 
-	// Floating point math.
+	// Scalar floating point math. Operands are either Float or Double sized. 'fcmp' sets the flags
+	// as 'cmp' does, use the 'ifF*' conditions (and ifEqual, ifNotEqual) to examine the result.
+	Instr *STORM_FN fadd(EnginePtr e, Operand dest, Operand src);
+	Instr *STORM_FN fsub(EnginePtr e, Operand dest, Operand src);
+	Instr *STORM_FN fneg(EnginePtr e, Operand dest, Operand src); // dest = -src
+	Instr *STORM_FN fmul(EnginePtr e, Operand dest, Operand src);
+	Instr *STORM_FN fdiv(EnginePtr e, Operand dest, Operand src);
+	Instr *STORM_FN fcmp(EnginePtr e, Operand a, Operand b);
+
+	// Conversions. 'fcast' converts between float and double, 'fcasti' converts a floating point
+	// value to a signed integer (truncating), and 'icastf' converts a signed integer to a floating
+	// point value. Integers are either Int or Long sized.
+	Instr *STORM_FN fcast(EnginePtr e, Operand dest, Operand src);
+	Instr *STORM_FN fcasti(EnginePtr e, Operand dest, Operand src);
+	Instr *STORM_FN icastf(EnginePtr e, Operand dest, Operand src);
+
+	// Packed operations. Operands are Vec sized (see Size::sVec), and contain either 4 Int or 4
+	// Float values that are processed independently. Vectors may be moved using 'mov'. The
+	// comparisons set each element of 'dest' to all ones if the comparison is true, and to all zeros
+	// otherwise. Not supported on X86.
+	Instr *STORM_FN vadd(EnginePtr e, Operand dest, Operand src);
+	Instr *STORM_FN vsub(EnginePtr e, Operand dest, Operand src);
+	Instr *STORM_FN vand(EnginePtr e, Operand dest, Operand src);
+	Instr *STORM_FN vor(EnginePtr e, Operand dest, Operand src);
+	Instr *STORM_FN vxor(EnginePtr e, Operand dest, Operand src);
+	Instr *STORM_FN vcmpeq(EnginePtr e, Operand dest, Operand src); // dest = dest == src
+	Instr *STORM_FN vcmpgt(EnginePtr e, Operand dest, Operand src); // dest = dest > src (signed)
+	Instr *STORM_FN vfadd(EnginePtr e, Operand dest, Operand src);
+	Instr *STORM_FN vfsub(EnginePtr e, Operand dest, Operand src);
+	Instr *STORM_FN vfmul(EnginePtr e, Operand dest, Operand src);
+	Instr *STORM_FN vfdiv(EnginePtr e, Operand dest, Operand src);
+	Instr *STORM_FN vfmin(EnginePtr e, Operand dest, Operand src);
+	Instr *STORM_FN vfmax(EnginePtr e, Operand dest, Operand src);
+	Instr *STORM_FN vfcmpeq(EnginePtr e, Operand dest, Operand src); // dest = dest == src
+	Instr *STORM_FN vfcmplt(EnginePtr e, Operand dest, Operand src); // dest = dest < src
+	Instr *STORM_FN vfcmple(EnginePtr e, Operand dest, Operand src); // dest = dest <= src
+
+	// Rearrange the elements in 'dest'. Element 'i' is set to the element in 'dest' indicated by
+	// bits 2i and 2i+1 in 'order'.
+	Instr *STORM_FN vshuffle(EnginePtr e, Operand dest, Byte order);
+
+	// Floating point math using the x87 stack.
 	Instr *STORM_FN fstp(EnginePtr e, Operand dest);
 	Instr *STORM_FN fistp(EnginePtr e, Operand dest); // Truncates results.
 	Instr *STORM_FN fld(EnginePtr e, Operand src);
@@ -148,6 +148,32 @@ namespace code {
 	PROXY2(sar, Operand, Operand);
 	PROXY2(icast, Operand, Operand);
 	PROXY2(ucast, Operand, Operand);
+	PROXY2(fadd, Operand, Operand);
+	PROXY2(fsub, Operand, Operand);
+	PROXY2(fneg, Operand, Operand);
+	PROXY2(fmul, Operand, Operand);
+	PROXY2(fdiv, Operand, Operand);
+	PROXY2(fcmp, Operand, Operand);
+	PROXY2(fcast, Operand, Operand);
+	PROXY2(fcasti, Operand, Operand);
+	PROXY2(icastf, Operand, Operand);
+	PROXY2(vadd, Operand, Operand);
+	PROXY2(vsub, Operand, Operand);
+	PROXY2(vand, Operand, Operand);
+	PROXY2(vor, Operand, Operand);
+	PROXY2(vxor, Operand, Operand);
+	PROXY2(vcmpeq, Operand, Operand);
+	PROXY2(vcmpgt, Operand, Operand);
+	PROXY2(vfadd, Operand, Operand);
+	PROXY2(vfsub, Operand, Operand);
+	PROXY2(vfmul, Operand, Operand);
+	PROXY2(vfdiv, Operand, Operand);
+	PROXY2(vfmin, Operand, Operand);
+	PROXY2(vfmax, Operand, Operand);
+	PROXY2(vfcmpeq, Operand, Operand);
+	PROXY2(vfcmplt, Operand, Operand);
+	PROXY2(vfcmple, Operand, Operand);
+	PROXY2(vshuffle, Operand, Byte);
 	PROXY1(fstp, Operand);
 	PROXY1(fistp, Operand);
 	PROXY1(fld, Operand);
@@ -1,5 +1,6 @@
 #include "stdafx.h"
 #include "Layout.h"
+#include "Instr.h"
 
 namespace code {
 
@@ -54,4 +55,128 @@ namespace code {
 		return result;
 	}
 
+	// Does 'op' refer to 'v'?
+	static Bool refers(const Operand &op, Var v) {
+		return op.type() == opVariable && op.var().key() == v.key();
+	}
+
+	// Instructions that end a straight line of code.
+	static Bool barrier(op::OpCode op) {
+		switch (op) {
+		case op::jmp:
+		case op::call:
+		case op::ret:
+		case op::fnCall:
+		case op::fnCallRef:
+		case op::fnRet:
+		case op::fnRetRef:
+		case op::prolog:
+		case op::epilog:
+		case op::beginBlock:
+		case op::endBlock:
+		case op::jmpBlock:
+		case op::activate:
+		case op::dat:
+		case op::lblOffset:
+		case op::align:
+			return true;
+		default:
+			return false;
+		}
+	}
+
+	// Maximum number of instructions to examine after the start of a block.
+	static const Nat maxScan = 128;
+
+	// Is 'v' entirely overwritten before it may be read, when starting at 'line'?
+	static Bool writtenFirst(Listing *src, Nat line, Var v) {
+		for (Nat i = line; i < src->count() && i < line + maxScan; i++) {
+			// Someone might jump here.
+			if (src->labels(i))
+				return false;
+
+			Instr *instr = src->at(i);
+			if (barrier(instr->op()))
+				return false;
+
+			if (refers(instr->src(), v))
+				return false;
+
+			if (refers(instr->dest(), v)) {
+				const Operand &dest = instr->dest();
+				return instr->mode() == destWrite
+					&& dest.offset() == Offset()
+					&& dest.size() == v.size();
+			}
+		}
+
+		return false;
+	}
+
+	static void markUsed(Array<Bool> *used, const Operand &op) {
+		if (op.type() == opVariable && op.var().key() < used->count())
+			used->at(op.var().key()) = true;
+	}
+
+	Array<Bool> *zeroVars(Listing *src) {
+		Array<Var> *all = src->allVars();
+		Array<Bool> *result = new (src) Array<Bool>(all->count(), true);
+
+		// Find variables that are used at all.
+		Array<Bool> *used = new (src) Array<Bool>(all->count(), false);
+		for (Nat i = 0; i < src->count(); i++) {
+			Instr *instr = src->at(i);
+			markUsed(used, instr->src());
+			markUsed(used, instr->dest());
+		}
+
+		// A block may be entered in more than one place. All of them need to agree.
+		Array<Bool> *seen = new (src) Array<Bool>(all->count(), false);
+
+		for (Nat i = 0; i < src->count(); i++) {
+			Instr *instr = src->at(i);
+			Block block;
+			if (instr->op() == op::prolog)
+				block = src->root();
+			else if (instr->op() == op::beginBlock)
+				block = instr->src().block();
+			else
+				continue;
+
+			Array<Var> *vars = src->allVars(block);
+			for (Nat j = 0; j < vars->count(); j++) {
+				Var v = vars->at(j);
+				Nat id = v.key();
+				if (src->isParam(v) || id >= result->count())
+					continue;
+
+				Bool zero = true;
+				if (src->freeFn(v).empty())
+					zero = used->at(id) && !writtenFirst(src, i + 1, v);
+
+				if (seen->at(id))
+					result->at(id) |= zero;
+				else
+					result->at(id) = zero;
+				seen->at(id) = true;
+			}
+		}
+
+		return result;
+	}
+
+	Bool exceptionBlock(Listing *src, Block block) {
+		Array<Listing::CatchInfo> *catchInfo = src->catchInfo(block);
+		if (catchInfo && catchInfo->any())
+			return true;
+
+		// Same criteria as the variables in the block table of Binary.
+		Array<Var> *vars = src->allVars(block);
+		for (Nat i = 0; i < vars->count(); i++)
+			if (src->freeOpt(vars->at(i)) & freeOnException)
+				return true;
+
+		return false;
+	}
+
 }
@@ -15,4 +15,23 @@ namespace code {
 	 */
 	Array<Offset> *STORM_FN layout(Listing *src);
 
+	/**
+	 * Find which variables need to be zeroed when the block they are declared in is entered. A
+	 * variable needs to be zeroed unless it has no destructor and it is either never used, or
+	 * entirely overwritten before it is read or control flow leaves the straight line of code after
+	 * the start of the block (labels, jumps and calls). The latter makes sure that the GC never sees
+	 * stale pointers in the variable while something else is executing.
+	 *
+	 * The returned array is indexed by the key of each variable.
+	 */
+	Array<Bool> *STORM_FN zeroVars(Listing *src);
+
+	/**
+	 * Check if entering or leaving 'block' changes what happens when an exception is thrown, ie. if
+	 * the block contains variables that are destroyed during stack unwinding, or if it catches
+	 * exceptions. If not, the block behaves exactly like its parent during unwinding, and backends
+	 * do not need to record that the block was entered or left.
+	 */
+	Bool STORM_FN exceptionBlock(Listing *src, Block block);
+
 }
@@ -463,6 +463,15 @@ namespace code {
 		vars->at(v.id).freeOpt = opt;
 	}
 
+	void Listing::removeStorage(Var v) {
+		if (v.id >= vars->count())
+			return;
+
+		IVar &var = vars->at(v.id);
+		if (!var.param)
+			var.size = Size();
+	}
+
 	static bool checkFree(Engine &e, const Operand &free, FreeOpt &when) {
 		if (when & freePtr)
 			if (max(free.size(), Size::sLong) != Size::sLong)
@@ -225,6 +225,11 @@ namespace code {
 		FreeOpt STORM_FN freeOpt(Var v) const;
 		void STORM_FN freeOpt(Var v, FreeOpt opt);
 
+		// Remove the storage of a variable that is not used by any instruction, so that it does not
+		// occupy any space in the stack frame. The variable is kept, but its size is zero. Does
+		// nothing for parameters.
+		void STORM_FN removeStorage(Var v);
+
 		/**
 		 * Information of how to catch exceptions.
 		 *
@@ -55,6 +55,32 @@ namespace code {
 		OP_CODE(sar, destRead | destWrite),
 		OP_CODE(icast, destWrite),
 		OP_CODE(ucast, destWrite),
+		OP_CODE(fadd, destRead | destWrite),
+		OP_CODE(fsub, destRead | destWrite),
+		OP_CODE(fneg, destWrite),
+		OP_CODE(fmul, destRead | destWrite),
+		OP_CODE(fdiv, destRead | destWrite),
+		OP_CODE(fcmp, destRead),
+		OP_CODE(fcast, destWrite),
+		OP_CODE(fcasti, destWrite),
+		OP_CODE(icastf, destWrite),
+		OP_CODE(vadd, destRead | destWrite),
+		OP_CODE(vsub, destRead | destWrite),
+		OP_CODE(vand, destRead | destWrite),
+		OP_CODE(vor, destRead | destWrite),
+		OP_CODE(vxor, destRead | destWrite),
+		OP_CODE(vcmpeq, destRead | destWrite),
+		OP_CODE(vcmpgt, destRead | destWrite),
+		OP_CODE(vfadd, destRead | destWrite),
+		OP_CODE(vfsub, destRead | destWrite),
+		OP_CODE(vfmul, destRead | destWrite),
+		OP_CODE(vfdiv, destRead | destWrite),
+		OP_CODE(vfmin, destRead | destWrite),
+		OP_CODE(vfmax, destRead | destWrite),
+		OP_CODE(vfcmpeq, destRead | destWrite),
+		OP_CODE(vfcmplt, destRead | destWrite),
+		OP_CODE(vfcmple, destRead | destWrite),
+		OP_CODE(vshuffle, destRead | destWrite),
 		OP_CODE(fstp, destWrite),
 		OP_CODE(fistp, destWrite),
 		OP_CODE(fld, destNone),
@@ -49,7 +49,37 @@ namespace code {
 			icast,
 			ucast,
 
-			// Floating point.
+			// Floating point (scalar).
+			fadd,
+			fsub,
+			fneg,
+			fmul,
+			fdiv,
+			fcmp,
+			fcast,
+			fcasti,
+			icastf,
+
+			// Packed operations on vectors of 4 Int or 4 Float values.
+			vadd,
+			vsub,
+			vand,
+			vor,
+			vxor,
+			vcmpeq,
+			vcmpgt,
+			vfadd,
+			vfsub,
+			vfmul,
+			vfdiv,
+			vfmin,
+			vfmax,
+			vfcmpeq,
+			vfcmplt,
+			vfcmple,
+			vshuffle,
+
+			// Floating point (x87 stack).
 			fstp,
 			fistp,
 			fld,
@@ -0,0 +1,716 @@
+#include "stdafx.h"
+#include "Optimize.h"
+#include "Listing.h"
+
+namespace code {
+
+	// Number of bits in a value of 'size' on the current platform.
+	static Nat bits(Size size) {
+		return size.current() * 8;
+	}
+
+	// Truncate 'v' to 'size'.
+	static Word truncate(Word v, Size size) {
+		Nat b = bits(size);
+		if (b >= 64)
+			return v;
+		return v & ((Word(1) << b) - 1);
+	}
+
+	// Sign-extend 'v' from 'size'.
+	static Long signExtend(Word v, Size size) {
+		Nat b = bits(size);
+		if (b >= 64)
+			return Long(v);
+		Nat shift = 64 - b;
+		return Long(v << shift) >> shift;
+	}
+
+	// Evaluate an arithmetic operation on two constants. Returns false if the result is not known
+	// at compile time.
+	static bool foldArith(op::OpCode op, Word a, Word b, Size size, Word &out) {
+		Long sa = signExtend(a, size);
+		Long sb = signExtend(b, size);
+		a = truncate(a, size);
+		b = truncate(b, size);
+
+		switch (op) {
+		case op::add:
+			out = a + b;
+			break;
+		case op::sub:
+			out = a - b;
+			break;
+		case op::mul:
+			out = a * b;
+			break;
+		case op::band:
+			out = a & b;
+			break;
+		case op::bor:
+			out = a | b;
+			break;
+		case op::bxor:
+			out = a ^ b;
+			break;
+		case op::shl:
+		case op::shr:
+		case op::sar:
+			// The behavior of large shifts depends on the backend.
+			if (b >= bits(size))
+				return false;
+			if (op == op::shl)
+				out = a << b;
+			else if (op == op::shr)
+				out = a >> b;
+			else
+				out = Word(sa >> b);
+			break;
+		case op::udiv:
+		case op::umod:
+			// Division by zero shall fail at runtime.
+			if (b == 0)
+				return false;
+			out = (op == op::udiv) ? a / b : a % b;
+			break;
+		case op::idiv:
+		case op::imod:
+			if (sb == 0)
+				return false;
+			// Overflows, and shall fail at runtime.
+			if (sb == -1 && sa == signExtend(Word(1) << (bits(size) - 1), size))
+				return false;
+			out = Word((op == op::idiv) ? sa / sb : sa % sb);
+			break;
+		default:
+			return false;
+		}
+
+		out = truncate(out, size);
+		return true;
+	}
+
+	// Evaluate the condition 'cond' after comparing 'a' and 'b'. Returns false if not possible.
+	static bool evalCond(CondFlag cond, Word a, Word b, Size size, bool &out) {
+		Long sa = signExtend(a, size);
+		Long sb = signExtend(b, size);
+		a = truncate(a, size);
+		b = truncate(b, size);
+
+		switch (cond) {
+		case ifEqual:
+			out = a == b;
+			return true;
+		case ifNotEqual:
+			out = a != b;
+			return true;
+		case ifBelow:
+			out = a < b;
+			return true;
+		case ifBelowEqual:
+			out = a <= b;
+			return true;
+		case ifAboveEqual:
+			out = a >= b;
+			return true;
+		case ifAbove:
+			out = a > b;
+			return true;
+		case ifLess:
+			out = sa < sb;
+			return true;
+		case ifLessEqual:
+			out = sa <= sb;
+			return true;
+		case ifGreaterEqual:
+			out = sa >= sb;
+			return true;
+		case ifGreater:
+			out = sa > sb;
+			return true;
+		default:
+			return false;
+		}
+	}
+
+	// Does 'instr' read the flags?
+	static bool readsFlags(Instr *instr) {
+		switch (instr->op()) {
+		case op::jmp:
+		case op::setCond: {
+			CondFlag c = instr->src().condFlag();
+			return c != ifAlways && c != ifNever;
+		}
+		case op::adc:
+		case op::sbb:
+		case op::pushFlags:
+			return true;
+		default:
+			return false;
+		}
+	}
+
+	// Does 'instr' overwrite the flags, so that the previous flags are no longer visible? Note that
+	// shifts leave the flags untouched if the shift is zero.
+	static bool writesFlags(Instr *instr) {
+		switch (instr->op()) {
+		case op::add:
+		case op::adc:
+		case op::sub:
+		case op::sbb:
+		case op::cmp:
+		case op::test:
+		case op::bor:
+		case op::band:
+		case op::bxor:
+		case op::mul:
+		case op::idiv:
+		case op::udiv:
+		case op::imod:
+		case op::umod:
+		case op::fcmp:
+		case op::call:
+		case op::fnCall:
+		case op::fnCallRef:
+			return true;
+		default:
+			return false;
+		}
+	}
+
+	// Are the flags after instruction 'id' possibly used by some later instruction? Conservatively
+	// assumes that the flags are used if a label is found.
+	static bool flagsUsed(Listing *src, Array<Instr *> *replace, Nat id) {
+		for (Nat i = id + 1; i < src->count(); i++) {
+			if (src->labels(i))
+				return true;
+
+			Instr *instr = replace->at(i);
+			if (!instr)
+				continue;
+			if (readsFlags(instr))
+				return true;
+			if (writesFlags(instr))
+				return false;
+		}
+		return false;
+	}
+
+	// Does execution continue with the next instruction after 'instr' (at least sometimes)?
+	static bool fallsThrough(Instr *instr) {
+		switch (instr->op()) {
+		case op::jmp:
+			return instr->src().condFlag() != ifAlways;
+		case op::jmpBlock:
+		case op::ret:
+		case op::fnRet:
+		case op::fnRetRef:
+			return false;
+		default:
+			return true;
+		}
+	}
+
+	// May 'instr' be removed if it is never executed? Instructions that describe the structure of
+	// the listing, or contain data, are needed by the backends even if they are not executed.
+	static bool removable(Instr *instr) {
+		switch (instr->op()) {
+		case op::prolog:
+		case op::epilog:
+		case op::beginBlock:
+		case op::endBlock:
+		case op::activate:
+		case op::preserve:
+		case op::location:
+		case op::dat:
+		case op::lblOffset:
+		case op::align:
+			return false;
+		default:
+			return true;
+		}
+	}
+
+	// Does 'instr' only write to its destination, without any other side effects?
+	static bool pureWrite(Instr *instr) {
+		switch (instr->op()) {
+		case op::mov:
+		case op::lea:
+		case op::setCond:
+		case op::icast:
+		case op::ucast:
+		case op::fneg:
+		case op::fcast:
+		case op::fcasti:
+		case op::icastf:
+			return true;
+		default:
+			return false;
+		}
+	}
+
+	// Is instruction 'id' modified by a prefix?
+	static bool prefixed(Listing *src, Nat id) {
+		return id > 0 && src->at(id - 1)->op() == op::threadLocal;
+	}
+
+	/**
+	 * Variables known to contain constant values at some point in the listing.
+	 */
+	class Values {
+	public:
+		Values(Listing *src) {
+			Array<Var> *all = src->allVars();
+			Nat count = 0;
+			for (Nat i = 0; i < all->count(); i++)
+				count = max(count, all->at(i).key() + 1);
+
+			vars = new (src) Array<Var>(count, Var());
+			values = new (src) Array<Operand>(count, Operand());
+			for (Nat i = 0; i < all->count(); i++) {
+				Var v = all->at(i);
+				// Variables with destructors are accessed by the exception handling.
+				if (src->freeFn(v).empty() && v.size().current() <= sizeof(Word))
+					vars->at(v.key()) = v;
+			}
+
+			// Variables whose address is taken may be modified through pointers.
+			for (Nat i = 0; i < src->count(); i++) {
+				Instr *instr = src->at(i);
+				if (instr->op() == op::lea && instr->src().type() == opVariable)
+					forget(instr->src().var());
+			}
+		}
+
+		// Get the constant value of 'op', or an empty operand if not known.
+		Operand get(const Operand &op) const {
+			if (op.type() == opConstant)
+				return op;
+			if (!whole(op))
+				return Operand();
+			return values->at(op.var().key());
+		}
+
+		// Replace 'op' with a constant if it is known to contain one.
+		Operand resolve(const Operand &op) const {
+			Operand r = get(op);
+			return r.empty() ? op : r;
+		}
+
+		// Remember that 'op' contains 'value' (if it is tracked).
+		void set(const Operand &op, Word value) {
+			write(op);
+			if (whole(op))
+				values->at(op.var().key()) = xConst(op.size(), value);
+		}
+
+		// Forget anything known about the variable 'op' refers to (if any).
+		void write(const Operand &op) {
+			if (op.type() == opVariable && op.var().key() < values->count())
+				values->at(op.var().key()) = Operand();
+		}
+
+		// Forget all variables in 'block'.
+		void clear(Listing *src, Block block) {
+			Array<Var> *in = src->allVars(block);
+			for (Nat i = 0; i < in->count(); i++)
+				write(in->at(i));
+		}
+
+		// Forget everything.
+		void clear() {
+			for (Nat i = 0; i < values->count(); i++)
+				values->at(i) = Operand();
+		}
+
+	private:
+		// All tracked variables. Indexed by their key.
+		Array<Var> *vars;
+
+		// Known values of all variables. Indexed by their key.
+		Array<Operand> *values;
+
+		// Does 'op' refer to an entire variable that is tracked?
+		bool whole(const Operand &op) const {
+			if (op.type() != opVariable || op.offset() != Offset())
+				return false;
+
+			Nat key = op.var().key();
+			if (key >= vars->count() || vars->at(key) == Var())
+				return false;
+			return vars->at(key).size() == op.size();
+		}
+
+		// Stop tracking 'v'.
+		void forget(Var v) {
+			if (v.key() < vars->count()) {
+				vars->at(v.key()) = Var();
+				values->at(v.key()) = Operand();
+			}
+		}
+	};
+
+	/**
+	 * The result of the last comparison, if known.
+	 */
+	class Flags {
+	public:
+		Flags() : known(false), a(0), b(0) {}
+
+		// Is the result known?
+		bool known;
+
+		// Values compared.
+		Word a;
+		Word b;
+		Size size;
+
+		// Set the compared values.
+		void set(Word a, Word b, Size size) {
+			known = true;
+			this->a = a;
+			this->b = b;
+			this->size = size;
+		}
+
+		// Evaluate 'cond'. Returns false if not known.
+		bool eval(CondFlag cond, bool &out) const {
+			return known && evalCond(cond, a, b, size, out);
+		}
+	};
+
+	// Simplify a single instruction based on what is known at that point, and update 'values' and
+	// 'flags' with its effects. Returns null if the instruction can be removed.
+	static Instr *simplify(Engine &e, Listing *src, Array<Instr *> *replace, Nat id, Values &values, Flags &flags) {
+		Instr *instr = src->at(id);
+		Operand dest = instr->dest();
+
+		switch (instr->op()) {
+		case op::mov: {
+			Operand from = values.resolve(instr->src());
+			if (from.type() == opConstant)
+				values.set(dest, from.constant());
+			else
+				values.write(dest);
+			return from == instr->src() ? instr : instr->alterSrc(from);
+		}
+		case op::add:
+		case op::sub:
+		case op::mul:
+		case op::band:
+		case op::bor:
+		case op::bxor:
+		case op::shl:
+		case op::shr:
+		case op::sar:
+		case op::idiv:
+		case op::udiv:
+		case op::imod:
+		case op::umod: {
+			Operand from = values.resolve(instr->src());
+			Operand current = values.get(dest);
+			Word result;
+			flags.known = false;
+			if (current.any() && from.type() == opConstant
+				&& foldArith(instr->op(), current.constant(), from.constant(), dest.size(), result)
+				&& !flagsUsed(src, replace, id)) {
+				values.set(dest, result);
+				return mov(e, dest, xConst(dest.size(), result));
+			}
+
+			values.write(dest);
+			return from == instr->src() ? instr : instr->alterSrc(from);
+		}
+		case op::adc:
+		case op::sbb:
+		case op::test: {
+			Operand from = values.resolve(instr->src());
+			flags.known = false;
+			if (instr->mode() & destWrite)
+				values.write(dest);
+			return from == instr->src() ? instr : instr->alterSrc(from);
+		}
+		case op::cmp: {
+			Operand from = values.resolve(instr->src());
+			Operand to = values.get(dest);
+			if (to.any() && from.type() == opConstant)
+				flags.set(to.constant(), from.constant(), dest.size());
+			else
+				flags.known = false;
+			return from == instr->src() ? instr : instr->alterSrc(from);
+		}
+		case op::icast:
+		case op::ucast: {
+			Operand from = values.get(instr->src());
+			if (from.empty()) {
+				values.write(dest);
+				return instr;
+			}
+
+			Word value = from.constant();
+			if (instr->op() == op::icast)
+				value = Word(signExtend(value, from.size()));
+			else
+				value = truncate(value, from.size());
+			value = truncate(value, dest.size());
+			values.set(dest, value);
+			return mov(e, dest, xConst(dest.size(), value));
+		}
+		case op::setCond: {
+			bool result;
+			if (flags.eval(instr->src().condFlag(), result)) {
+				values.set(dest, result ? 1 : 0);
+				return mov(e, dest, byteConst(result ? 1 : 0));
+			}
+			values.write(dest);
+			return instr;
+		}
+		case op::jmp: {
+			CondFlag cond = instr->src().condFlag();
+			bool result;
+			if (dest.type() == opLabel && flags.eval(cond, result)) {
+				if (!result)
+					return null;
+				instr = jmp(e, dest.label(), ifAlways);
+				cond = ifAlways;
+			}
+			if (cond == ifAlways) {
+				values.clear();
+				flags.known = false;
+			}
+			return instr;
+		}
+		case op::beginBlock:
+		case op::endBlock:
+			values.clear(src, instr->src().block());
+			return instr;
+		case op::location:
+		case op::preserve:
+		case op::nop:
+			return instr;
+		default:
+			// Some other instruction. Only assume that it writes to its operands as described. Note
+			// that 'fnCall' writes its result to 'dest' even though the operand is marked as read.
+			if ((instr->mode() & destWrite) || instr->op() == op::fnCall)
+				values.write(dest);
+			if (instr->op() == op::swap)
+				values.write(instr->src());
+			if (instr->op() == op::jmpBlock)
+				values.clear();
+			flags.known = false;
+			return instr;
+		}
+	}
+
+	Optimize::Optimize() {}
+
+	void Optimize::before(Listing *dest, Listing *src) {
+		replace = new (this) Array<Instr *>(src->count(), null);
+		for (Nat i = 0; i < src->count(); i++)
+			replace->at(i) = src->at(i);
+
+		fold(src);
+		removeUnreachable(src);
+		while (removeDeadStores(src))
+			;
+		removeDeadCompares(src);
+	}
+
+	void Optimize::during(Listing *dest, Listing *src, Nat id) {
+		if (Instr *instr = replace->at(id))
+			*dest << instr;
+	}
+
+	void Optimize::after(Listing *dest, Listing *src) {
+		removeUnusedVars(dest, src);
+	}
+
+	void Optimize::fold(Listing *src) {
+		Engine &e = engine();
+		Values values(src);
+		Flags flags;
+
+		for (Nat i = 0; i < src->count(); i++) {
+			if (src->labels(i)) {
+				values.clear();
+				flags.known = false;
+			}
+
+			if (prefixed(src, i)) {
+				// The previous instruction modifies this one. Leave it alone.
+				values.write(src->at(i)->dest());
+				flags.known = false;
+			} else {
+				replace->at(i) = simplify(e, src, replace, i, values, flags);
+			}
+		}
+	}
+
+	// Add the position of 'label' to 'to', if it is known.
+	static void addLabel(Array<Nat> *to, Array<Nat> *positions, Label label) {
+		if (label.key() < positions->count())
+			to->push(positions->at(label.key()));
+	}
+
+	// Add labels that are referred to by 'op' to 'to'.
+	static void addLabel(Array<Nat> *to, Array<Nat> *positions, const Operand &op) {
+		if (op.type() == opLabel || op.type() == opRelativeLbl)
+			addLabel(to, positions, op.label());
+	}
+
+	void Optimize::removeUnreachable(Listing *src) {
+		Nat count = src->count();
+
+		// Find the position of all labels.
+		Array<Nat> *positions = new (this) Array<Nat>();
+		for (Nat i = 0; i <= count; i++) {
+			Array<Label> *labels = src->labels(i);
+			if (!labels)
+				continue;
+
+			for (Nat j = 0; j < labels->count(); j++) {
+				Nat key = labels->at(j).key();
+				while (positions->count() <= key)
+					positions->push(count);
+				positions->at(key) = i;
+			}
+		}
+
+		// Places where execution may start.
+		Array<Nat> *work = new (this) Array<Nat>();
+		work->push(0);
+		addLabel(work, positions, src->meta());
+
+		// Labels used for other things than jumps may be reached in other ways.
+		for (Nat i = 0; i < count; i++) {
+			Instr *instr = src->at(i);
+			if (instr->op() != op::jmp && instr->op() != op::jmpBlock)
+				addLabel(work, positions, instr->dest());
+			addLabel(work, positions, instr->src());
+		}
+
+		// Exception handlers resume at these labels.
+		Array<Block> *blocks = src->allBlocks();
+		for (Nat i = 0; i < blocks->count(); i++) {
+			Array<Listing::CatchInfo> *info = src->catchInfo(blocks->at(i));
+			if (!info)
+				continue;
+			for (Nat j = 0; j < info->count(); j++)
+				addLabel(work, positions, info->at(j).resume);
+		}
+
+		Array<Bool> *reached = new (this) Array<Bool>(count, false);
+		while (work->any()) {
+			Nat start = work->last();
+			work->pop();
+
+			for (Nat i = start; i < count && !reached->at(i); i++) {
+				reached->at(i) = true;
+
+				Instr *instr = replace->at(i);
+				if (!instr)
+					continue;
+
+				if (instr->op() == op::jmp || instr->op() == op::jmpBlock)
+					addLabel(work, positions, instr->dest());
+
+				if (!fallsThrough(instr))
+					break;
+			}
+		}
+
+		for (Nat i = 0; i < count; i++) {
+			Instr *instr = replace->at(i);
+			if (!reached->at(i) && instr && removable(instr))
+				replace->at(i) = null;
+		}
+	}
+
+	// Mark the variable 'op' refers to, if any.
+	static void markVar(Array<Bool> *marked, const Operand &op) {
+		if (op.type() == opVariable && op.var().key() < marked->count())
+			marked->at(op.var().key()) = true;
+	}
+
+	Bool Optimize::removeDeadStores(Listing *src) {
+		Array<Var> *all = src->allVars();
+		Nat count = 0;
+		for (Nat i = 0; i < all->count(); i++)
+			count = max(count, all->at(i).key() + 1);
+
+		// Find variables that are read. Variables with destructors are read when they are freed.
+		Array<Bool> *read = new (this) Array<Bool>(count, false);
+		for (Nat i = 0; i < all->count(); i++)
+			if (src->freeFn(all->at(i)).any())
+				read->at(all->at(i).key()) = true;
+
+		for (Nat i = 0; i < replace->count(); i++) {
+			Instr *instr = replace->at(i);
+			if (!instr)
+				continue;
+
+			markVar(read, instr->src());
+			if (instr->mode() & destRead)
+				markVar(read, instr->dest());
+		}
+
+		Bool changed = false;
+		for (Nat i = 0; i < replace->count(); i++) {
+			Instr *instr = replace->at(i);
+			if (!instr || !pureWrite(instr) || prefixed(src, i))
+				continue;
+
+			Operand dest = instr->dest();
+			if (dest.type() != opVariable || dest.var().key() >= read->count())
+				continue;
+
+			if (!read->at(dest.var().key())) {
+				replace->at(i) = null;
+				changed = true;
+			}
+		}
+
+		return changed;
+	}
+
+	void Optimize::removeDeadCompares(Listing *src) {
+		for (Nat i = 0; i < replace->count(); i++) {
+			Instr *instr = replace->at(i);
+			if (!instr || prefixed(src, i))
+				continue;
+
+			if (instr->op() != op::cmp && instr->op() != op::test)
+				continue;
+
+			if (!flagsUsed(src, replace, i))
+				replace->at(i) = null;
+		}
+	}
+
+	void Optimize::removeUnusedVars(Listing *dest, Listing *src) {
+		Array<Var> *all = src->allVars();
+		Array<Bool> *used = new (this) Array<Bool>(all->count(), false);
+
+		for (Nat i = 0; i < replace->count(); i++) {
+			Instr *instr = replace->at(i);
+			if (!instr)
+				continue;
+
+			markVar(used, instr->src());
+			markVar(used, instr->dest());
+		}
+
+		for (Nat i = 0; i < all->count(); i++) {
+			Var v = all->at(i);
+			if (used->at(v.key()) || src->isParam(v))
+				continue;
+
+			// Destructors and debuggers access the variable without any instructions referring to it.
+			if (src->freeFn(v).any() || src->varInfo(v))
+				continue;
+
+			dest->removeStorage(v);
+		}
+	}
+
+}
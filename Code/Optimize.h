@@ -0,0 +1,63 @@
+#pragma once
+#include "Transform.h"
+#include "Instr.h"
+#include "Core/Array.h"
+
+namespace code {
+	STORM_PKG(core.asm);
+
+	/**
+	 * Backend-independent optimizations of a listing. Performs the following optimizations:
+	 *
+	 * - constant propagation and folding: variables known to contain a constant are replaced by
+	 *   the constant where possible, and arithmetic on constants is computed at compile time.
+	 * - branch folding: conditional jumps and 'setCond' instructions that depend on a comparison
+	 *   between two constants are replaced by unconditional jumps or constants.
+	 * - removal of unreachable instructions, for example after 'jmp' or 'fnRet'.
+	 * - removal of writes to variables that are never read, and of comparisons whose result is
+	 *   never used.
+	 * - removal of the storage of variables that are no longer used by any instruction. Variables
+	 *   with destructors or debug information are kept, as they are accessed from outside the code.
+	 *
+	 * Constants are only tracked within basic blocks, and only for variables whose address is
+	 * never taken and that do not have a destructor. Instructions that affect the structure of
+	 * the listing (eg. 'beginBlock', 'prolog' and data) are always kept, even if they are not
+	 * reachable. Labels are always kept.
+	 *
+	 * Intended to run before any backend-specific transforms.
+	 */
+	class Optimize : public Transform {
+		STORM_CLASS;
+	public:
+		STORM_CTOR Optimize();
+
+		// Start transform.
+		virtual void STORM_FN before(Listing *dest, Listing *src);
+
+		// Transform a single instruction.
+		virtual void STORM_FN during(Listing *dest, Listing *src, Nat id);
+
+		// End transform.
+		virtual void STORM_FN after(Listing *dest, Listing *src);
+
+	private:
+		// Replacement for each instruction in the source listing. 'null' if removed.
+		Array<Instr *> *replace;
+
+		// Fold constants and branches.
+		void fold(Listing *src);
+
+		// Remove unreachable instructions.
+		void removeUnreachable(Listing *src);
+
+		// Remove writes to variables that are never read. Returns true if anything was removed.
+		Bool removeDeadStores(Listing *src);
+
+		// Remove comparisons whose result is never used.
+		void removeDeadCompares(Listing *src);
+
+		// Remove the storage of variables that are not used in 'dest'.
+		void removeUnusedVars(Listing *dest, Listing *src);
+	};
+
+}
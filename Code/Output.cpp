@@ -244,7 +244,7 @@ namespace code {
 	 */
 
 	CodeUpdater::CodeUpdater(Ref src, Content *inside, void *code, Nat slot) :
-		Reference(src, inside), code(code), slot(slot) {
+		Reference(src, inside, false), code(code), slot(slot) {
 
 		moved(address());
 	}
@@ -16,6 +16,7 @@ namespace code {
 	 */
 	class Output : public ObjectOn<Compiler> {
 		STORM_CLASS;
+		friend class RecordOutput;
 	public:
 		/**
 		 * Low-level output.
@@ -154,7 +155,8 @@ namespace code {
 
 	/**
 	 * Reference which will update a reference in a code segment. Make sure to keep these alive as
-	 * long as the code segement is alive somehow.
+	 * long as the code segement is alive somehow. Created detached, the backends pass them to
+	 * 'Binary::addReference' which attaches them when appropriate.
 	 */
 	class CodeUpdater : public Reference {
 		STORM_CLASS;
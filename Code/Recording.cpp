@@ -0,0 +1,197 @@
+#include "stdafx.h"
+#include "Recording.h"
+#include "Binary.h"
+
+namespace code {
+
+	Recording::Recording() : portable(true), size(0), refs(0), metaOffset(0) {
+		blocks = new (this) Array<Nat>();
+		sources = new (this) Array<RefSource *>();
+		ops = buffer(engine(), 256);
+	}
+
+	static void put(Recording *to, const void *data, Nat size) {
+		Buffer &b = to->ops;
+		if (b.filled() + size > b.count())
+			b = grow(to->engine(), b, max(b.count() * 2, b.filled() + size));
+
+		memcpy(b.dataPtr() + b.filled(), data, size);
+		b.filled(b.filled() + size);
+	}
+
+	void Recording::putOp(Op op) {
+		Byte b = Byte(op);
+		put(this, &b, sizeof(b));
+	}
+
+	void Recording::putNat(Nat v) {
+		put(this, &v, sizeof(v));
+	}
+
+	void Recording::putWord(Word v) {
+		put(this, &v, sizeof(v));
+	}
+
+	Nat Recording::sourceId(RefSource *source) {
+		for (Nat i = 0; i < sources->count(); i++)
+			if (sources->at(i) == source)
+				return i;
+
+		sources->push(source);
+		return sources->count() - 1;
+	}
+
+
+	/**
+	 * Record output.
+	 */
+
+	RecordOutput::RecordOutput(CodeOutput *to, Binary *owner, Recording *into)
+		: to(to), owner(owner), into(into), pending(false), pendingOp(0), pendingKind(0), pendingSize(0) {}
+
+	void RecordOutput::flush() {
+		// A GC pointer that was not a reference. We can not describe that.
+		if (pending)
+			into->portable = false;
+		pending = false;
+	}
+
+	void RecordOutput::done() {
+		flush();
+	}
+
+	void RecordOutput::putByte(Byte b) {
+		flush();
+		to->putByte(b);
+		into->putOp(Recording::opByte);
+		put(into, &b, sizeof(b));
+	}
+
+	void RecordOutput::putInt(Nat w) {
+		flush();
+		to->putInt(w);
+		into->putOp(Recording::opInt);
+		into->putNat(w);
+	}
+
+	void RecordOutput::putLong(Word w) {
+		flush();
+		to->putLong(w);
+		into->putOp(Recording::opLong);
+		into->putWord(w);
+	}
+
+	void RecordOutput::putPtr(Word w) {
+		flush();
+		to->putPtr(w);
+		into->putOp(Recording::opPtr);
+		into->putWord(w);
+	}
+
+	void RecordOutput::align(Nat alignTo) {
+		flush();
+		to->align(alignTo);
+		into->putOp(Recording::opAlign);
+		into->putNat(alignTo);
+	}
+
+	void RecordOutput::putGc(GcCodeRef::Kind kind, Nat size, Word w) {
+		flush();
+		to->putGc(kind, size, w);
+		pending = true;
+		pendingOp = Recording::opGcRef;
+		pendingKind = Nat(kind);
+		pendingSize = size;
+	}
+
+	void RecordOutput::putGcPtr(Word w) {
+		flush();
+		to->putGcPtr(w);
+
+		if (w == Word(owner)) {
+			into->putOp(Recording::opOwner);
+		} else {
+			pending = true;
+			pendingOp = Recording::opGcPtrRef;
+		}
+	}
+
+	void RecordOutput::putGcRelative(Word w) {
+		flush();
+		to->putGcRelative(w);
+		pending = true;
+		pendingOp = Recording::opGcRelRef;
+	}
+
+	void RecordOutput::putRelativeStatic(Word w) {
+		// Static addresses are not the same in another process.
+		flush();
+		to->putRelativeStatic(w);
+		into->portable = false;
+	}
+
+	void RecordOutput::putPtrSelf(Word w) {
+		flush();
+		to->putPtrSelf(w);
+		into->putOp(Recording::opPtrSelf);
+		into->putNat(Nat(w - Word(to->codePtr())));
+	}
+
+	Nat RecordOutput::tell() const {
+		return to->tell();
+	}
+
+	void RecordOutput::markProlog() {
+		flush();
+		to->markProlog();
+		into->putOp(Recording::opProlog);
+	}
+
+	void RecordOutput::markEpilog() {
+		flush();
+		to->markEpilog();
+		into->putOp(Recording::opEpilog);
+	}
+
+	void RecordOutput::markSaved(Reg reg, Offset offset) {
+		flush();
+		to->markSaved(reg, offset);
+		into->putOp(Recording::opSaved);
+		into->putNat(Nat(reg));
+		into->putNat(Nat(offset.current()));
+	}
+
+	void *RecordOutput::codePtr() const {
+		return to->codePtr();
+	}
+
+	void RecordOutput::markLabel(Nat id) {
+		// Labels are already resolved when we record them.
+		to->markLabel(id);
+	}
+
+	void RecordOutput::markGcRef(Ref ref) {
+		to->markGcRef(ref);
+
+		if (!pending)
+			return;
+		pending = false;
+
+		Nat id = into->sourceId(ref.source());
+		into->putOp(Recording::Op(pendingOp));
+		if (pendingOp == Recording::opGcRef) {
+			into->putNat(pendingKind);
+			into->putNat(pendingSize);
+		}
+		into->putNat(id);
+	}
+
+	Nat RecordOutput::labelOffset(Nat id) {
+		return to->labelOffset(id);
+	}
+
+	Nat RecordOutput::toRelative(Nat offset) {
+		return to->toRelative(offset);
+	}
+
+}
@@ -0,0 +1,135 @@
+#pragma once
+#include "Core/TObject.h"
+#include "Core/Array.h"
+#include "Core/Io/Buffer.h"
+#include "Output.h"
+#include "RefSource.h"
+
+namespace code {
+	STORM_PKG(core.asm);
+
+	class Binary;
+
+	/**
+	 * A recording of the output of a Binary, so that the same machine code can be produced again
+	 * later without translating the Listing. Used to store code on disk between runs.
+	 *
+	 * The recording contains the calls made to the CodeOutput by the backend, with labels already
+	 * resolved. Pointers to RefSources are stored as indices into 'sources', so that they can be
+	 * replaced with the RefSources in another process before the recording is replayed. Any other
+	 * pointers to GC:d objects (except to the Binary itself) can not be described like that, and
+	 * make the recording non-portable.
+	 *
+	 * Code containing catch clauses is not recorded either, as the types to catch are not stored.
+	 */
+	class Recording : public ObjectOn<Compiler> {
+		STORM_CLASS;
+	public:
+		// Create an empty recording.
+		STORM_CTOR Recording();
+
+		// Can the recording be used in another process?
+		Bool portable;
+
+		// Size of the code and number of references, as reported by the LabelOutput.
+		Nat size;
+		Nat refs;
+
+		// Offset of the metadata in the code.
+		Nat metaOffset;
+
+		// The block hierarchy in the Binary. For each block: the parent, the number of variables
+		// and a pair of id and flags for each variable.
+		Array<Nat> *blocks;
+
+		// RefSources referred to by the code.
+		Array<RefSource *> *sources;
+
+		// Recorded operations. Only 'filled' bytes are valid.
+		Buffer ops;
+
+		// Operations in 'ops'. Each operation is followed by its parameters in native byte order.
+		enum Op {
+			opByte,       // Byte
+			opInt,        // Nat
+			opLong,       // Word
+			opPtr,        // Word
+			opAlign,      // Nat
+			opPtrSelf,    // Nat: offset from the start of the code
+			opGcRef,      // Nat: kind, Nat: size, Nat: source index
+			opGcPtrRef,   // Nat: source index
+			opGcRelRef,   // Nat: source index
+			opOwner,      // A pointer to the Binary itself.
+			opProlog,
+			opEpilog,
+			opSaved,      // Nat: register, Int: offset
+		};
+
+		// Append data.
+		void putOp(Op op);
+		void putNat(Nat v);
+		void putWord(Word v);
+
+		// Get the index of 'source' in 'sources', adding it if needed.
+		Nat sourceId(RefSource *source);
+	};
+
+
+	/**
+	 * Output that forwards everything to another output and records the operations in a
+	 * Recording.
+	 */
+	class RecordOutput : public CodeOutput {
+		STORM_CLASS;
+	public:
+		// Create. 'owner' is the Binary being created.
+		RecordOutput(CodeOutput *to, Binary *owner, Recording *into);
+
+		virtual void STORM_FN putByte(Byte b);
+		virtual void STORM_FN putInt(Nat w);
+		virtual void STORM_FN putLong(Word w);
+		virtual void STORM_FN putPtr(Word w);
+		virtual void STORM_FN align(Nat to);
+		virtual void putGc(GcCodeRef::Kind kind, Nat size, Word w);
+		virtual void STORM_FN putGcPtr(Word w);
+		virtual void STORM_FN putGcRelative(Word w);
+		virtual void STORM_FN putRelativeStatic(Word w);
+		virtual void STORM_FN putPtrSelf(Word w);
+		virtual Nat STORM_FN tell() const;
+		virtual void STORM_FN markProlog();
+		virtual void STORM_FN markEpilog();
+		virtual void STORM_FN markSaved(Reg reg, Offset offset);
+		virtual void *codePtr() const;
+
+		// Called when the output is done.
+		void done();
+
+	protected:
+		virtual void STORM_FN markLabel(Nat id);
+		virtual void STORM_FN markGcRef(Ref ref);
+		virtual Nat STORM_FN labelOffset(Nat id);
+		virtual Nat STORM_FN toRelative(Nat offset);
+
+	private:
+		// Output to forward to.
+		CodeOutput *to;
+
+		// Binary being created.
+		Binary *owner;
+
+		// Recording.
+		Recording *into;
+
+		// A GC pointer waiting for a call to 'markGcRef'?
+		Bool pending;
+
+		// Operation to record for the pending GC pointer.
+		Nat pendingOp;
+		Nat pendingKind;
+		Nat pendingSize;
+
+		// Called before each new operation.
+		void flush();
+	};
+
+}
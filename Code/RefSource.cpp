@@ -25,6 +25,9 @@ namespace code {
 			if (to)
 				to->owner = this;
 			cont = to;
+
+			if (to)
+				to->named();
 		}
 
 		update();
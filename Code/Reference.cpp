@@ -13,6 +13,16 @@ namespace code {
 		this->to->refs->put(this);
 	}
 
+	Reference::Reference(Ref to, Content *inside, Bool attach) : owner(inside), to(to.to) {
+		if (attach)
+			this->to->refs->put(this);
+	}
+
+	void Reference::attach() {
+		to->refs->put(this);
+		moved(address());
+	}
+
 	void Reference::moved(const void *addr) {}
 
 	void Reference::toS(StrBuf *t) const {
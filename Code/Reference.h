@@ -61,6 +61,14 @@ namespace code {
 		STORM_CTOR Reference(RefSource *to, Content *inside);
 		STORM_CTOR Reference(Ref to, Content *inside);
 
+		// Create, but only register the reference in 'to' if 'attach' is true. Otherwise, call
+		// 'attach' later. Creating detached references does not modify 'to', so it can be done on
+		// other threads than the Compiler thread.
+		Reference(Ref to, Content *inside, Bool attach);
+
+		// Register in the RefSource, and update to its current address.
+		void attach();
+
 		// Get the content we're associated with, ie. who's referring to something.
 		inline Content *referrer() const { return owner; }
 
@@ -59,6 +59,8 @@ namespace code {
 			return Size::sNat;
 		case 8:
 			return Size::sLong;
+		case 2:
+			return Size::sVec;
 		default:
 			assert(false, L"Unknown size for register: " + ::toS(name(r)));
 			return Size::sPtr;
@@ -78,6 +80,8 @@ namespace code {
 			s = 4;
 		} else if (size == Size::sLong) {
 			s = 8;
+		} else if (size == Size::sVec) {
+			s = 2;
 		} else {
 			return noReg;
 		}
@@ -369,6 +373,8 @@ namespace code {
 		case 0x4:
 			return 1;
 		case 0x8:
+		case 0x2:
+			// Vector registers are tracked as 64-bit registers.
 			return 3;
 		default:
 			WARNING(L"Unknown size!");
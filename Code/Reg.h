@@ -10,7 +10,7 @@ namespace code {
 	 * Registers available for all backends.
 	 *
 	 * Format: 0xABC where:
-	 * A is the size (0 = pointer size)
+	 * A is the size (0 = pointer size, 2 = 16 bytes, otherwise the size in bytes)
 	 * B is the backend id (0 = general, 1 = x86, etc)
 	 * C is specific identifier to the backend
 	 */
@@ -99,6 +99,8 @@ namespace code {
 	Size Size::sFloat = Size(4);
 	Size Size::sDouble = Size(8);
 
+	Size Size::sVec = Size(16);
+
 	nat Size::current() const {
 		switch (sizeof(void *)) {
 		case 4:
@@ -47,6 +47,11 @@ namespace code {
 		static Size sFloat;
 		static Size sDouble;
 
+		// Vector size. 16 bytes, used by the packed operations (for example 4 Int or 4 Float
+		// values). Only aligned as a Long, so vectors are always loaded and stored as unaligned
+		// values.
+		static Size sVec;
+
 		// Addition (note that we do not have subtraction).
 		Size &STORM_FN operator +=(const Size &o);
 		Size STORM_FN operator +(const Size &o) const;
@@ -94,6 +99,7 @@ namespace code {
 	inline Size STORM_FN sWord() { return Size::sWord; }
 	inline Size STORM_FN sFloat() { return Size::sFloat; }
 	inline Size STORM_FN sDouble() { return Size::sDouble; }
+	inline Size STORM_FN sVec() { return Size::sVec; }
 
 	/**
 	 * Output.
@@ -3,7 +3,10 @@
 #include "Output.h"
 #include "Asm.h"
 #include "AsmOut.h"
+#include "../Optimize.h"
+#include "Peephole.h"
 #include "RemoveInvalid.h"
+#include "RegAlloc.h"
 #include "Layout.h"
 #include "PosixEh.h"
 #include "../Exception.h"
@@ -13,14 +16,25 @@ namespace code {
 
 		Arena::Arena() {}
 
-		Listing *Arena::transform(Listing *l, Binary *owner) const {
+		Listing *Arena::transform(Listing *l, Binary *owner, Bool fast) const {
 #if defined(POSIX) && defined(X64)
 			activateInfo();
 #endif
 
+			// Constant folding and dead code elimination.
+			if (optimize && !fast)
+				l = code::transform(l, this, new (this) Optimize());
+
+			// Remove redundant instructions.
+			if (peephole && !fast)
+				l = code::transform(l, this, new (this) Peephole());
+
 			// Remove unsupported OP-codes, replacing them with their equivalents.
 			l = code::transform(l, this, new (this) RemoveInvalid());
 
+			// Keep frequently used variables in registers.
+			l = code::transform(l, this, new (this) RegAlloc());
+
 			// Expand variables and function calls as well as function prolog and epilog.
 			l = code::transform(l, this, new (this) Layout(owner));
 
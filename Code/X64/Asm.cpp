@@ -70,6 +70,14 @@ namespace code {
 		const Reg xmm5 = Reg(0x82D);
 		const Reg xmm6 = Reg(0x82E);
 		const Reg xmm7 = Reg(0x82F);
+		const Reg vmm0 = Reg(0x228);
+		const Reg vmm1 = Reg(0x229);
+		const Reg vmm2 = Reg(0x22A);
+		const Reg vmm3 = Reg(0x22B);
+		const Reg vmm4 = Reg(0x22C);
+		const Reg vmm5 = Reg(0x22D);
+		const Reg vmm6 = Reg(0x22E);
+		const Reg vmm7 = Reg(0x22F);
 
 		static const Reg pmm0 = Reg(0x028);
 		static const Reg pmm1 = Reg(0x029);
@@ -146,6 +154,14 @@ namespace code {
 				CASE_REG(xmm5);
 				CASE_REG(xmm6);
 				CASE_REG(xmm7);
+				CASE_REG(vmm0);
+				CASE_REG(vmm1);
+				CASE_REG(vmm2);
+				CASE_REG(vmm3);
+				CASE_REG(vmm4);
+				CASE_REG(vmm5);
+				CASE_REG(vmm6);
+				CASE_REG(vmm7);
 
 				// Only for completeness.
 				CASE_REG(pmm0);
@@ -299,6 +315,18 @@ namespace code {
 			return noReg;
 		}
 
+		Reg unusedFpReg(RegSet *in) {
+			static const Reg candidates[] = {
+				xmm7, xmm6, xmm5, xmm4, xmm3, xmm2, xmm1, xmm0,
+			};
+			for (nat i = 0; i < ARRAY_COUNT(candidates); i++) {
+				if (!in->has(candidates[i]))
+					return candidates[i];
+			}
+
+			throw new (in) InvalidValue(S("We should never run out of xmm registers on X86-64!"));
+		}
+
 		RegSet *fnDirtyRegs(EnginePtr e) {
 			RegSet *r = new (e.v) RegSet();
 			r->put(rax);
@@ -471,8 +499,12 @@ namespace code {
 				break;
 			case opRelative:
 				if (dest.reg() == noReg) {
-					// TODO: Remove this in one of the transforms!
-					assert(false, L"Absolute addresses are not supported on X86-64!");
+					// Absolute address. Only useful together with a segment prefix (i.e. 'threadLocal'),
+					// as the address is limited to 32 bits. Encoded as a SIB byte without a base or an
+					// index, since 'rm = 5' means RIP relative addressing.
+					modRm(to, op, flags, mode, 0, 4);
+					sib(to, 5);
+					to->putInt(Nat(dest.offset().v64()));
 				} else {
 					byte mod = 2;
 					nat reg = registerId(dest.reg());
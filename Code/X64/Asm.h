@@ -82,6 +82,18 @@ namespace code {
 		extern const Reg xmm6;
 		extern const Reg xmm7;
 
+		/**
+		 * The full 16 bytes of the xmm registers, used by the packed operations.
+		 */
+		extern const Reg vmm0;
+		extern const Reg vmm1;
+		extern const Reg vmm2;
+		extern const Reg vmm3;
+		extern const Reg vmm4;
+		extern const Reg vmm5;
+		extern const Reg vmm6;
+		extern const Reg vmm7;
+
 		// Convert to names.
 		const wchar *nameX64(Reg r);
 
@@ -109,6 +121,9 @@ namespace code {
 		// As above, but returns 'noReg' instead of throwing if no registers are available.
 		Reg unusedRegUnsafe(RegSet *in);
 
+		// Find an unused xmm register given a set of used registers.
+		Reg unusedFpReg(RegSet *in);
+
 		// Get the set of registers that can be left dirty through a function call.
 		RegSet *STORM_FN fnDirtyRegs(EnginePtr e);
 
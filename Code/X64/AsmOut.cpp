@@ -83,7 +83,9 @@ namespace code {
 		}
 
 		static OpCode fpOp(const Operand &size, byte op) {
-			if (size.size() == Size::sWord)
+			if (size.size() == Size::sVec)
+				return opCode(0x0F, op);
+			else if (size.size() == Size::sWord)
 				return prefixOpCode(0xF2, 0x0F, op);
 			else
 				return prefixOpCode(0xF3, 0x0F, op);
@@ -480,6 +482,10 @@ namespace code {
 			jmpCall(to, true, instr->src());
 		}
 
+		void threadLocalOut(Output *to, Instr *instr) {
+			to->putByte(0x64); // FS segment
+		}
+
 		void retOut(Output *to, Instr *instr) {
 			to->putByte(0xC3);
 		}
@@ -564,6 +570,143 @@ namespace code {
 			}
 		}
 
+		void faddOut(Output *to, Instr *instr) {
+			// addss/addsd
+			modRm(to, fpOp(instr->dest(), 0x58), rmNone, instr->dest(), instr->src());
+		}
+
+		void fsubOut(Output *to, Instr *instr) {
+			// subss/subsd
+			modRm(to, fpOp(instr->dest(), 0x5C), rmNone, instr->dest(), instr->src());
+		}
+
+		void fmulOut(Output *to, Instr *instr) {
+			// mulss/mulsd
+			modRm(to, fpOp(instr->dest(), 0x59), rmNone, instr->dest(), instr->src());
+		}
+
+		void fdivOut(Output *to, Instr *instr) {
+			// divss/divsd
+			modRm(to, fpOp(instr->dest(), 0x5E), rmNone, instr->dest(), instr->src());
+		}
+
+		void fcmpOut(Output *to, Instr *instr) {
+			// ucomiss/ucomisd. Sets CF and ZF like an unsigned comparison.
+			if (instr->dest().size() == Size::sDouble)
+				modRm(to, prefixOpCode(0x66, 0x0F, 0x2E), rmNone, instr->dest(), instr->src());
+			else
+				modRm(to, opCode(0x0F, 0x2E), rmNone, instr->dest(), instr->src());
+		}
+
+		void fcastOut(Output *to, Instr *instr) {
+			// cvtss2sd/cvtsd2ss
+			modRm(to, fpOp(instr->src(), 0x5A), rmNone, instr->dest(), instr->src());
+		}
+
+		void fcastiOut(Output *to, Instr *instr) {
+			// cvttss2si/cvttsd2si
+			modRm(to, fpOp(instr->src(), 0x2C), wide(instr->dest()), instr->dest(), instr->src());
+		}
+
+		void icastfOut(Output *to, Instr *instr) {
+			// cvtsi2ss/cvtsi2sd
+			modRm(to, fpOp(instr->dest(), 0x2A), wide(instr->src()), instr->dest(), instr->src());
+		}
+
+		// Packed operations. RemoveInvalid makes sure that 'dest' is a register.
+		static void vecOp(Output *to, Instr *instr, OpCode op) {
+			modRm(to, op, rmNone, instr->dest(), instr->src());
+		}
+
+		void vaddOut(Output *to, Instr *instr) {
+			// paddd
+			vecOp(to, instr, prefixOpCode(0x66, 0x0F, 0xFE));
+		}
+
+		void vsubOut(Output *to, Instr *instr) {
+			// psubd
+			vecOp(to, instr, prefixOpCode(0x66, 0x0F, 0xFA));
+		}
+
+		void vandOut(Output *to, Instr *instr) {
+			// pand
+			vecOp(to, instr, prefixOpCode(0x66, 0x0F, 0xDB));
+		}
+
+		void vorOut(Output *to, Instr *instr) {
+			// por
+			vecOp(to, instr, prefixOpCode(0x66, 0x0F, 0xEB));
+		}
+
+		void vxorOut(Output *to, Instr *instr) {
+			// pxor
+			vecOp(to, instr, prefixOpCode(0x66, 0x0F, 0xEF));
+		}
+
+		void vcmpeqOut(Output *to, Instr *instr) {
+			// pcmpeqd
+			vecOp(to, instr, prefixOpCode(0x66, 0x0F, 0x76));
+		}
+
+		void vcmpgtOut(Output *to, Instr *instr) {
+			// pcmpgtd
+			vecOp(to, instr, prefixOpCode(0x66, 0x0F, 0x66));
+		}
+
+		void vfaddOut(Output *to, Instr *instr) {
+			// addps
+			vecOp(to, instr, opCode(0x0F, 0x58));
+		}
+
+		void vfsubOut(Output *to, Instr *instr) {
+			// subps
+			vecOp(to, instr, opCode(0x0F, 0x5C));
+		}
+
+		void vfmulOut(Output *to, Instr *instr) {
+			// mulps
+			vecOp(to, instr, opCode(0x0F, 0x59));
+		}
+
+		void vfdivOut(Output *to, Instr *instr) {
+			// divps
+			vecOp(to, instr, opCode(0x0F, 0x5E));
+		}
+
+		void vfminOut(Output *to, Instr *instr) {
+			// minps
+			vecOp(to, instr, opCode(0x0F, 0x5D));
+		}
+
+		void vfmaxOut(Output *to, Instr *instr) {
+			// maxps
+			vecOp(to, instr, opCode(0x0F, 0x5F));
+		}
+
+		// cmpps with the predicate 'pred'.
+		static void vfcmpOp(Output *to, Instr *instr, byte pred) {
+			vecOp(to, instr, opCode(0x0F, 0xC2));
+			to->putByte(pred);
+		}
+
+		void vfcmpeqOut(Output *to, Instr *instr) {
+			vfcmpOp(to, instr, 0);
+		}
+
+		void vfcmpltOut(Output *to, Instr *instr) {
+			vfcmpOp(to, instr, 1);
+		}
+
+		void vfcmpleOut(Output *to, Instr *instr) {
+			vfcmpOp(to, instr, 2);
+		}
+
+		void vshuffleOut(Output *to, Instr *instr) {
+			// pshufd <dest>, <dest>, <order>
+			modRm(to, prefixOpCode(0x66, 0x0F, 0x70), rmNone, instr->dest(), instr->dest());
+			to->putByte(byte(instr->src().constant()));
+		}
+
 		void fstpOut(Output *to, Instr *instr) {
 			if (instr->size() == Size::sDouble) {
 				modRm(to, opCode(0xDD), rmNone, 3, instr->dest());
@@ -707,6 +850,14 @@ namespace code {
 			OUTPUT(location),
 
 			// Floating point.
+			OUTPUT(fadd),
+			OUTPUT(fsub),
+			OUTPUT(fmul),
+			OUTPUT(fdiv),
+			OUTPUT(fcmp),
+			OUTPUT(fcast),
+			OUTPUT(fcasti),
+			OUTPUT(icastf),
 			OUTPUT(fstp),
 			OUTPUT(fistp),
 			OUTPUT(fld),
@@ -719,6 +870,26 @@ namespace code {
 			OUTPUT(fcompp),
 			OUTPUT(fwait),
 
+			// Packed operations.
+			OUTPUT(vadd),
+			OUTPUT(vsub),
+			OUTPUT(vand),
+			OUTPUT(vor),
+			OUTPUT(vxor),
+			OUTPUT(vcmpeq),
+			OUTPUT(vcmpgt),
+			OUTPUT(vfadd),
+			OUTPUT(vfsub),
+			OUTPUT(vfmul),
+			OUTPUT(vfdiv),
+			OUTPUT(vfmin),
+			OUTPUT(vfmax),
+			OUTPUT(vfcmpeq),
+			OUTPUT(vfcmplt),
+			OUTPUT(vfcmple),
+			OUTPUT(vshuffle),
+
+			OUTPUT(threadLocal),
 			OUTPUT(dat),
 			OUTPUT(lblOffset),
 			OUTPUT(align),
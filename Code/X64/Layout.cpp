@@ -69,6 +69,9 @@ namespace code {
 
 			layout = code::x64::layout(src, params, spilled);
 
+			// Variables that need to be zeroed when their block is entered.
+			zero = zeroVars(src);
+
 			// Initialize the 'activated' array.
 			Array<Var> *vars = src->allVars();
 			activated = new (this) Array<Nat>(vars->count(), 0);
@@ -328,12 +331,12 @@ namespace code {
 			for (Nat i = vars->count(); i > 0; i--) {
 				Var v = vars->at(i - 1);
 
-				if (!dest->isParam(v))
+				if (!dest->isParam(v) && zero->at(v.key()))
 					zeroVar(dest, layout->at(v.key()), v.size(), initEax);
 			}
 
-			if (usingEH) {
-				// Remember where the block started.
+			// Remember where the block started, unless it behaves like its parent during unwinding.
+			if (usingEH && exceptionBlock(dest, init)) {
 				Label lbl = dest->label();
 				*dest << lbl;
 				activeBlocks->push(Active(block, activationId, lbl));
@@ -390,7 +393,7 @@ namespace code {
 			}
 
 			block = dest->parent(block);
-			if (usingEH && table) {
+			if (usingEH && table && exceptionBlock(dest, destroy)) {
 				Label lbl = dest->label();
 				*dest << lbl;
 				activeBlocks->push(Active(block, activationId, lbl));
@@ -51,6 +51,9 @@ namespace code {
 			// Layout of the stack. The stack offset of all variables in the listings.
 			Array<Offset> *layout;
 
+			// Variables to zero when their block is entered (see 'zeroVars').
+			Array<Bool> *zero;
+
 			// Index where each variable was activated.
 			Array<Nat> *activated;
 
@@ -1,6 +1,7 @@
 #include "stdafx.h"
 #include "Output.h"
 #include "Gc/DwarfTable.h"
+#include "Gc/PerfMap.h"
 #include "../Binary.h"
 #include "Utils/Bitwise.h"
 
@@ -14,10 +15,11 @@ namespace code {
 			// Initialize our members.
 			this->owner = owner;
 			codeRefs = new (this) Array<Reference *>();
-			code = (byte *)runtime::allocCode(engine(), size + sizeof(void *), numRefs + 2);
+			Nat reserved = perfMap().enabled() ? 3 : 2;
+			code = (byte *)runtime::allocCode(engine(), size + sizeof(void *), numRefs + reserved);
 			labels = lbls;
 			pos = 0;
-			ref = 2;
+			ref = reserved;
 
 			GcCode *refs = runtime::codeRefs(code);
 
@@ -32,6 +34,13 @@ namespace code {
 			refs->refs[1].offset = size;
 			refs->refs[1].kind = GcCodeRef::rawPtr;
 			refs->refs[1].pointer = codeRefs;
+
+			// An entry for the perf map, if enabled.
+			if (reserved > 2) {
+				refs->refs[2].offset = 0;
+				refs->refs[2].kind = GcCodeRef::perfMap;
+				refs->refs[2].pointer = perfMap().add(code, size);
+			}
 		}
 
 		void CodeOut::putByte(Byte b) {
@@ -136,7 +145,9 @@ namespace code {
 			if (ref == 0)
 				return;
 
-			codeRefs->push(new (this) CodeUpdater(r, owner, code, ref - 1));
+			CodeUpdater *updater = new (this) CodeUpdater(r, owner, code, ref - 1);
+			codeRefs->push(updater);
+			owner->addReference(updater);
 		}
 
 		Nat CodeOut::labelOffset(Nat id) {
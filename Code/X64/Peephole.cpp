@@ -0,0 +1,310 @@
+#include "stdafx.h"
+#include "Peephole.h"
+#include "../Listing.h"
+#include "Utils/Bitwise.h"
+
+namespace code {
+	namespace x64 {
+
+		// May writing to 'write' change the value of 'op'?
+		static bool mayAlias(const Operand &write, const Operand &op) {
+			switch (write.type()) {
+			case opRegister:
+				if (op.type() == opRegister || op.type() == opRelative)
+					return same(write.reg(), op.reg());
+				return false;
+			case opVariable:
+				if (op.type() == opVariable)
+					return write.var() == op.var();
+				// We do not know where the register points.
+				return op.type() == opRelative;
+			default:
+				// Some other kind of memory. It may point anywhere.
+				return op.type() == opVariable
+					|| op.type() == opRelative
+					|| op.type() == opRelativeLbl;
+			}
+		}
+
+		/**
+		 * Operands known to contain the same value at some point in the listing. Each pair
+		 * (a[i], b[i]) is known to be equal.
+		 */
+		class Known {
+		public:
+			Known(Listing *l) : a(new (l) Array<Operand>()), b(new (l) Array<Operand>()) {}
+
+			// Are 'x' and 'y' known to be equal?
+			bool equal(const Operand &x, const Operand &y) const {
+				if (x == y)
+					return true;
+
+				for (Nat i = 0; i < a->count(); i++) {
+					if (a->at(i) == x && b->at(i) == y)
+						return true;
+					if (a->at(i) == y && b->at(i) == x)
+						return true;
+				}
+				return false;
+			}
+
+			// Replace 'x' with a constant if it is known to contain one.
+			Operand resolve(const Operand &x) const {
+				if (x.type() != opRegister && x.type() != opVariable)
+					return x;
+
+				for (Nat i = 0; i < a->count(); i++) {
+					if (a->at(i) == x && b->at(i).type() == opConstant)
+						return b->at(i);
+					if (b->at(i) == x && a->at(i).type() == opConstant)
+						return a->at(i);
+				}
+				return x;
+			}
+
+			// Remember that 'x' and 'y' are equal.
+			void add(const Operand &x, const Operand &y) {
+				a->push(x);
+				b->push(y);
+			}
+
+			// Forget everything that may be affected by writing to 'op'.
+			void write(const Operand &op) {
+				for (Nat i = a->count(); i > 0; i--) {
+					if (mayAlias(op, a->at(i - 1)) || mayAlias(op, b->at(i - 1))) {
+						a->remove(i - 1);
+						b->remove(i - 1);
+					}
+				}
+			}
+
+			// Forget everything.
+			void clear() {
+				a->clear();
+				b->clear();
+			}
+
+		private:
+			Array<Operand> *a;
+			Array<Operand> *b;
+		};
+
+		// Does 'instr' read the flags?
+		static bool readsFlags(Instr *instr) {
+			switch (instr->op()) {
+			case op::jmp:
+			case op::setCond: {
+				CondFlag c = instr->src().condFlag();
+				return c != ifAlways && c != ifNever;
+			}
+			case op::adc:
+			case op::sbb:
+			case op::pushFlags:
+				return true;
+			default:
+				return false;
+			}
+		}
+
+		// Is 'label' attached to instruction 'id'?
+		static bool hasLabel(Listing *src, Nat id, Label label) {
+			Array<Label> *labels = src->labels(id);
+			if (!labels)
+				return false;
+
+			for (Nat i = 0; i < labels->count(); i++)
+				if (labels->at(i) == label)
+					return true;
+			return false;
+		}
+
+		// Replace multiplication and unsigned division or modulo by powers of two with cheaper
+		// operations. Returns null if the instruction is not needed at all.
+		static Instr *strengthReduce(Engine &e, Instr *instr) {
+			Operand src = instr->src();
+			Operand dest = instr->dest();
+			if (src.type() != opConstant)
+				return instr;
+
+			Nat bits = dest.size().size64() * 8;
+			Word value = src.constant();
+			if (bits < 64)
+				value &= (Word(1) << bits) - 1;
+
+			if (value == 0) {
+				// Division by zero should still fail.
+				if (instr->op() == op::mul)
+					return mov(e, dest, xConst(dest.size(), 0));
+				return instr;
+			}
+
+			if (!isPowerOfTwo(value))
+				return instr;
+
+			Byte shift = Byte(trailingZeros(value));
+			switch (instr->op()) {
+			case op::mul:
+				if (shift == 0)
+					return null;
+				return shl(e, dest, byteConst(shift));
+			case op::udiv:
+				if (shift == 0)
+					return null;
+				return shr(e, dest, byteConst(shift));
+			case op::umod:
+				if (shift == 0)
+					return mov(e, dest, xConst(dest.size(), 0));
+				return band(e, dest, xConst(dest.size(), value - 1));
+			default:
+				return instr;
+			}
+		}
+
+		// Simplify a single instruction based on what is known at that point, and update 'known'
+		// with its effects. Returns null if the instruction can be removed.
+		static Instr *simplify(Engine &e, Listing *src, Nat id, Known &known) {
+			Instr *instr = src->at(id);
+			Operand dest = instr->dest();
+
+			switch (instr->op()) {
+			case op::mov: {
+				Operand from = known.resolve(instr->src());
+				if (known.equal(dest, from))
+					return null;
+
+				known.write(dest);
+				if (!mayAlias(dest, from))
+					known.add(dest, from);
+				return from == instr->src() ? instr : instr->alterSrc(from);
+			}
+			case op::add:
+			case op::adc:
+			case op::sub:
+			case op::sbb:
+			case op::bor:
+			case op::band:
+			case op::bxor:
+			case op::cmp: {
+				Operand from = known.resolve(instr->src());
+				if (from != instr->src())
+					instr = instr->alterSrc(from);
+				if (instr->mode() & destWrite)
+					known.write(dest);
+				return instr;
+			}
+			case op::mul:
+			case op::udiv:
+			case op::umod: {
+				Operand from = known.resolve(instr->src());
+				if (from != instr->src())
+					instr = instr->alterSrc(from);
+				known.write(dest);
+				return strengthReduce(e, instr);
+			}
+			case op::bnot:
+			case op::shl:
+			case op::shr:
+			case op::sar:
+			case op::setCond:
+			case op::lea:
+			case op::icast:
+			case op::ucast:
+				known.write(dest);
+				return instr;
+			case op::swap:
+				known.write(dest);
+				known.write(instr->src());
+				return instr;
+			case op::jmp: {
+				CondFlag cond = instr->src().condFlag();
+				if (cond == ifNever)
+					return null;
+				if (dest.type() == opLabel && hasLabel(src, id + 1, dest.label()))
+					return null;
+				if (cond == ifAlways)
+					known.clear();
+				return instr;
+			}
+			case op::location:
+				return instr;
+			default:
+				// Unknown instruction, it may do anything.
+				known.clear();
+				return instr;
+			}
+		}
+
+		// Try to fuse 'setCond', 'cmp' and 'jmp' starting at 'id' into a single jump. Returns the
+		// new jump, or null if not possible.
+		static Instr *fuseCondJmp(Engine &e, Listing *src, Nat id) {
+			if (id + 2 >= src->count())
+				return null;
+
+			Instr *set = src->at(id);
+			Instr *cmp = src->at(id + 1);
+			Instr *jmp = src->at(id + 2);
+			if (set->op() != op::setCond || cmp->op() != op::cmp || jmp->op() != op::jmp)
+				return null;
+
+			// Nothing may jump in between.
+			if (src->labels(id + 1) || src->labels(id + 2))
+				return null;
+
+			if (cmp->dest() != set->dest() || cmp->src().type() != opConstant || cmp->src().constant() != 0)
+				return null;
+			if (jmp->dest().type() != opLabel)
+				return null;
+
+			// The flags after the jump will differ, make sure nothing uses them.
+			if (id + 3 < src->count() && readsFlags(src->at(id + 3)))
+				return null;
+
+			CondFlag cond = set->src().condFlag();
+			switch (jmp->src().condFlag()) {
+			case ifEqual:
+				return code::jmp(e, jmp->dest().label(), inverse(cond));
+			case ifNotEqual:
+				return code::jmp(e, jmp->dest().label(), cond);
+			default:
+				return null;
+			}
+		}
+
+		Peephole::Peephole() {}
+
+		void Peephole::before(Listing *dest, Listing *src) {
+			Engine &e = engine();
+			replace = new (this) Array<Instr *>(src->count(), null);
+
+			Known known(src);
+			bool prefix = false;
+			for (Nat i = 0; i < src->count(); i++) {
+				Instr *instr = src->at(i);
+				if (src->labels(i))
+					known.clear();
+
+				if (prefix) {
+					// The previous instruction modifies this one. Leave it alone.
+					replace->at(i) = instr;
+					known.clear();
+				} else if (Instr *fused = fuseCondJmp(e, src, i)) {
+					known.write(instr->dest());
+					replace->at(i) = instr;
+					replace->at(i + 1) = null;
+					replace->at(i + 2) = fused;
+					i += 2;
+				} else {
+					replace->at(i) = simplify(e, src, i, known);
+				}
+
+				prefix = instr->op() == op::threadLocal;
+			}
+		}
+
+		void Peephole::during(Listing *dest, Listing *src, Nat id) {
+			if (Instr *instr = replace->at(id))
+				*dest << instr;
+		}
+
+	}
+}
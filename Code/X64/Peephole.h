@@ -0,0 +1,46 @@
+#pragma once
+#include "../Transform.h"
+#include "../Instr.h"
+#include "Core/Array.h"
+
+namespace code {
+	namespace x64 {
+		STORM_PKG(core.asm.x64);
+
+		/**
+		 * Peephole optimizations of a listing. Removes some redundant instruction sequences that
+		 * are commonly generated by the front-end:
+		 *
+		 * - 'mov' instructions that copy a value that is already known to be in the destination,
+		 *   for example moving a value to a temporary and back again, or loading the same
+		 *   variable into the same register multiple times.
+		 * - 'setCond' followed by 'cmp' against zero and a conditional jump. The jump is made
+		 *   directly on the original condition instead.
+		 * - jumps to the next instruction.
+		 * - operands known to contain a constant are replaced with the constant itself, so that the
+		 *   immediate forms of instructions are used.
+		 * - multiplications, unsigned divisions and unsigned modulo by powers of two are replaced
+		 *   by shifts and masks.
+		 *
+		 * Values are only tracked within basic blocks, and all instructions not known by the
+		 * transform are assumed to clobber everything. Runs before RemoveInvalid, so that any
+		 * operand combinations introduced here are legalized later on.
+		 */
+		class Peephole : public Transform {
+			STORM_CLASS;
+		public:
+			STORM_CTOR Peephole();
+
+			// Start transform.
+			virtual void STORM_FN before(Listing *dest, Listing *src);
+
+			// Transform a single instruction.
+			virtual void STORM_FN during(Listing *dest, Listing *src, Nat id);
+
+		private:
+			// Replacement for each instruction in the source listing. 'null' if removed.
+			Array<Instr *> *replace;
+		};
+
+	}
+}
@@ -0,0 +1,618 @@
+#include "stdafx.h"
+#include "RegAlloc.h"
+#include "Asm.h"
+#include "../Listing.h"
+
+namespace code {
+	namespace x64 {
+
+		// Marker for positions that are not known.
+		static const Nat none = Nat(-1);
+
+		// Maximum loop depth that affects the weight of variables.
+		static const Nat maxDepth = 6;
+
+		// Registers usable for variables that do not live across function calls. 'rax', 'rcx',
+		// 'rdx', 'rsi' and 'rdi' are left out since they are used implicitly by some instructions
+		// and by the code emitted by the Layout transform.
+		static const Reg *scratchRegs(Nat &count) {
+			static const Reg regs[] = { ptr8, ptr9, ptr10, ptr11 };
+			count = ARRAY_COUNT(regs);
+			return regs;
+		}
+
+		// Registers preserved through function calls, usable for any variable.
+		static const Reg *preservedRegs(Nat &count) {
+			static const Reg regs[] = { ptrB, ptr12, ptr13, ptr14, ptr15 };
+			count = ARRAY_COUNT(regs);
+			return regs;
+		}
+
+		// Registers usable for vectors. All xmm registers are clobbered by function calls, so these
+		// are only used for variables that do not live across function calls.
+		static const Reg *vectorRegs(Nat &count) {
+			static const Reg regs[] = { vmm0, vmm1, vmm2, vmm3, vmm4, vmm5, vmm6, vmm7 };
+			count = ARRAY_COUNT(regs);
+			return regs;
+		}
+
+		// May the operand 'src' or 'dest' of 'instr' be a register instead of a variable? All
+		// instructions here have already passed through RemoveInvalid, so replacing a memory
+		// operand with a register always produces a valid instruction for these op-codes.
+		static bool allowRegister(Listing *l, Instr *instr, bool src) {
+			// RemoveInvalid loads all vector operands of the packed operations into registers, so
+			// vectors only need to be considered in 'mov'.
+			if (instr->size() == Size::sVec)
+				return instr->op() == op::mov;
+
+			switch (instr->op()) {
+			case op::mov:
+			case op::swap:
+			case op::add:
+			case op::adc:
+			case op::sub:
+			case op::sbb:
+			case op::bor:
+			case op::band:
+			case op::bxor:
+			case op::cmp:
+				return true;
+			case op::bnot:
+			case op::shl:
+			case op::shr:
+			case op::sar:
+			case op::setCond:
+			case op::pop:
+				return !src;
+			case op::mul:
+			case op::idiv:
+			case op::udiv:
+			case op::imod:
+			case op::umod:
+			case op::icast:
+			case op::ucast:
+			case op::push:
+			case op::fnRetRef:
+				return src;
+			case op::fnRet:
+				// Layout needs the address of non-primitive values.
+				return src && as<PrimitiveDesc>(l->result) != null;
+			default:
+				return false;
+			}
+		}
+
+		// Is 'v' possible to store in a register at all?
+		static bool candidate(Listing *l, Var v) {
+			// Vectors are kept in xmm registers. Parameters are left in memory.
+			if (v.size() == Size::sVec)
+				return !l->isParam(v) && l->freeFn(v).empty();
+
+			if (asSize(ptrA, v.size()) == noReg)
+				return false;
+
+			// Variables with destructors need to be in memory so that they can be cleaned up
+			// during exception handling.
+			if (l->freeFn(v).any())
+				return false;
+			if (l->freeOpt(v) & (freeIndirection | freeInactive | freePtr))
+				return false;
+
+			// Only plain primitives are candidates among the parameters.
+			if (l->isParam(v))
+				return as<PrimitiveDesc>(l->paramDesc(v)) != null;
+
+			return true;
+		}
+
+		// Does 'instr' clobber registers not preserved through function calls? This includes
+		// pseudo-instructions that Layout expands into destructor calls.
+		static bool clobbers(Instr *instr) {
+			switch (instr->op()) {
+			case op::call:
+			case op::fnCall:
+			case op::fnCallRef:
+			case op::endBlock:
+			case op::jmpBlock:
+			case op::epilog:
+			case op::fnRet:
+			case op::fnRetRef:
+				return true;
+			default:
+				return false;
+			}
+		}
+
+		static void addRegs(RegSet *to, const Operand &op) {
+			if (op.type() == opRegister || op.type() == opRelative)
+				if (op.reg() != noReg)
+					to->put(op.reg());
+		}
+
+		/**
+		 * Liveness information for all variables in a listing. Positions refer to instruction
+		 * indices in the listing, and live intervals are approximated as a single contiguous
+		 * range. The approximation is made conservative by extending intervals that are live
+		 * across the back-edges of loops to cover the entire loop.
+		 */
+		class Liveness {
+		public:
+			Liveness(Listing *src);
+
+			// Listing.
+			Listing *src;
+
+			// Start and end of the interval for each variable. 'none' if not a candidate.
+			Array<Nat> *from;
+			Array<Nat> *to;
+
+			// Is the variable initialized at the start of its interval? If so, its value does not
+			// survive through the back-edges of loops that contain the entire interval.
+			Array<Bool> *fresh;
+
+			// Weight of each variable (approximately the number of accesses at runtime).
+			Array<Nat> *weight;
+
+			// Positions of instructions that clobber scratch registers.
+			Array<Nat> *clobbered;
+
+			// Registers used explicitly somewhere in the listing.
+			RegSet *used;
+
+			// Is it possible to allocate registers at all?
+			Bool valid;
+
+			// Does the interval for 'v' cross a function call?
+			Bool crossesCall(Nat v) const;
+
+		private:
+			// Back edges: jumps from 'edgeFrom' to 'edgeTo' where 'edgeTo <= edgeFrom'.
+			Array<Nat> *edgeFrom;
+			Array<Nat> *edgeTo;
+
+			// Loop depth at each instruction.
+			Array<Nat> *depth;
+
+			// Position of all labels.
+			Array<Nat> *labels;
+
+			// Collect information about labels and control flow. Returns 'false' if we do not
+			// understand the control flow of the listing.
+			void findLabels();
+			bool findEdges();
+
+			// Record uses of variables.
+			void findUses();
+			void use(const Operand &op, Nat pos);
+
+			// Extend intervals around loops.
+			void extendLoops();
+		};
+
+		Liveness::Liveness(Listing *src) : src(src), valid(false) {
+			Nat vars = src->allVars()->count();
+			from = new (src) Array<Nat>(vars, none);
+			to = new (src) Array<Nat>(vars, none);
+			fresh = new (src) Array<Bool>(vars, false);
+			weight = new (src) Array<Nat>(vars, 0);
+			clobbered = new (src) Array<Nat>();
+			used = new (src) RegSet();
+			edgeFrom = new (src) Array<Nat>();
+			edgeTo = new (src) Array<Nat>();
+			depth = new (src) Array<Nat>(src->count() + 1, 0);
+
+			findLabels();
+			if (!findEdges())
+				return;
+
+			findUses();
+			extendLoops();
+			valid = true;
+		}
+
+		void Liveness::findLabels() {
+			Nat maxLabel = 0;
+			for (Nat i = 0; i <= src->count(); i++) {
+				if (Array<Label> *l = src->labels(i))
+					for (Nat j = 0; j < l->count(); j++)
+						maxLabel = max(maxLabel, l->at(j).key() + 1);
+			}
+
+			labels = new (src) Array<Nat>(maxLabel, none);
+			for (Nat i = 0; i <= src->count(); i++) {
+				if (Array<Label> *l = src->labels(i))
+					for (Nat j = 0; j < l->count(); j++)
+						labels->at(l->at(j).key()) = i;
+			}
+		}
+
+		bool Liveness::findEdges() {
+			bool indirect = false;
+			bool addressTaken = false;
+			Nat lastCall = none;
+
+			for (Nat i = 0; i < src->count(); i++) {
+				Instr *instr = src->at(i);
+				Operand target;
+
+				switch (instr->op()) {
+				case op::threadLocal:
+				{
+					// Alters the meaning of the next memory access. Don't bother with these, unless
+					// the access does not involve any variables (e.g. absolute addresses).
+					Instr *next = i + 1 < src->count() ? src->at(i + 1) : null;
+					if (!next || next->src().type() == opVariable || next->dest().type() == opVariable)
+						return false;
+					break;
+				}
+				case op::jmp:
+				case op::jmpBlock:
+					target = instr->dest();
+					if (target.type() == opLabel)
+						break;
+					if (target.type() != opReference && target.type() != opObjReference)
+						indirect = true;
+					target = Operand();
+					break;
+				case op::call:
+					if (instr->src().type() == opLabel)
+						return false;
+					lastCall = i;
+					break;
+				default:
+					if (instr->src().type() == opLabel || instr->dest().type() == opLabel)
+						addressTaken = true;
+					break;
+				}
+
+				if (target.type() == opLabel) {
+					Nat to = labels->at(target.label().key());
+					if (to <= i) {
+						edgeFrom->push(i);
+						edgeTo->push(to);
+					}
+				}
+
+				if (clobbers(instr))
+					clobbered->push(i);
+
+				addRegs(used, instr->src());
+				addRegs(used, instr->dest());
+			}
+
+			// We can not follow jumps to computed addresses.
+			if (indirect && addressTaken)
+				return false;
+
+			// Any function call may throw an exception that is caught, in which case execution
+			// resumes at the label indicated in the catch clause. Treat those as jumps from the
+			// last call in the listing.
+			if (src->exceptionCaught() && lastCall != none) {
+				Array<Block> *blocks = src->allBlocks();
+				for (Nat i = 0; i < blocks->count(); i++) {
+					Array<Listing::CatchInfo> *info = src->catchInfo(blocks->at(i));
+					if (!info)
+						continue;
+
+					for (Nat j = 0; j < info->count(); j++) {
+						Nat to = labels->at(info->at(j).resume.key());
+						if (to <= lastCall) {
+							edgeFrom->push(lastCall);
+							edgeTo->push(to);
+						}
+					}
+				}
+			}
+
+			// Compute the loop depth of each instruction.
+			for (Nat i = 0; i < edgeFrom->count(); i++) {
+				depth->at(edgeTo->at(i))++;
+				depth->at(edgeFrom->at(i) + 1)--;
+			}
+			Nat d = 0;
+			for (Nat i = 0; i < depth->count(); i++) {
+				d += depth->at(i);
+				depth->at(i) = d;
+			}
+
+			return true;
+		}
+
+		void Liveness::findUses() {
+			Array<Var> *vars = src->allVars();
+			Array<Bool> *ok = new (src) Array<Bool>(vars->count(), false);
+			for (Nat i = 0; i < vars->count(); i++)
+				ok->at(i) = candidate(src, vars->at(i));
+
+			// Find where each block begins, which is where variables are initialized.
+			Array<Nat> *blockStart = new (src) Array<Nat>(src->allBlocks()->count(), none);
+			Nat prolog = none;
+
+			for (Nat i = 0; i < src->count(); i++) {
+				Instr *instr = src->at(i);
+				switch (instr->op()) {
+				case op::prolog:
+					prolog = i;
+					blockStart->at(src->root().key()) = i;
+					break;
+				case op::beginBlock:
+					blockStart->at(instr->src().block().key()) = i;
+					break;
+				}
+
+				Operand s = instr->src();
+				if (s.type() == opVariable) {
+					Nat id = s.var().key();
+					bool allowed = allowRegister(src, instr, true)
+						&& s.offset() == Offset()
+						&& s.size() == vars->at(id).size();
+					ok->at(id) &= allowed;
+					use(s, i);
+				}
+
+				Operand d = instr->dest();
+				if (d.type() == opVariable) {
+					Nat id = d.var().key();
+					bool allowed = allowRegister(src, instr, false)
+						&& d.offset() == Offset()
+						&& d.size() == vars->at(id).size();
+					ok->at(id) &= allowed;
+					use(d, i);
+				}
+			}
+
+			// Remove variables that were not suitable, and variables that are not used frequently
+			// enough to be worth a register.
+			for (Nat i = 0; i < vars->count(); i++) {
+				Var v = vars->at(i);
+				if (!ok->at(i) || from->at(i) == none || weight->at(i) < 2) {
+					from->at(i) = to->at(i) = none;
+					continue;
+				}
+
+				// The variable is initialized at the start of the block, make sure the interval
+				// contains that position as well.
+				Nat start = src->isParam(v) ? prolog : blockStart->at(src->parent(v).key());
+				if (start != none && start <= from->at(i)) {
+					from->at(i) = start;
+					fresh->at(i) = true;
+				}
+			}
+		}
+
+		void Liveness::use(const Operand &op, Nat pos) {
+			Nat id = op.var().key();
+			if (from->at(id) == none)
+				from->at(id) = pos;
+			to->at(id) = pos;
+
+			Nat w = 1 << (3 * min(depth->at(pos), maxDepth));
+			weight->at(id) += w;
+		}
+
+		void Liveness::extendLoops() {
+			bool changed = true;
+			while (changed) {
+				changed = false;
+
+				for (Nat i = 0; i < from->count(); i++) {
+					Nat &f = from->at(i);
+					Nat &t = to->at(i);
+					if (f == none)
+						continue;
+
+					for (Nat e = 0; e < edgeFrom->count(); e++) {
+						Nat loopStart = edgeTo->at(e);
+						Nat loopEnd = edgeFrom->at(e);
+
+						// Overlap?
+						if (f > loopEnd || t < loopStart)
+							continue;
+
+						// Initialized inside the loop, so the value is not used in the next iteration.
+						if (fresh->at(i) && f >= loopStart)
+							continue;
+
+						if (f > loopStart) {
+							f = loopStart;
+							changed = true;
+						}
+						if (t < loopEnd) {
+							t = loopEnd;
+							changed = true;
+						}
+					}
+				}
+			}
+		}
+
+		Bool Liveness::crossesCall(Nat v) const {
+			Nat f = from->at(v);
+			Nat t = to->at(v);
+			for (Nat i = 0; i < clobbered->count(); i++) {
+				Nat at = clobbered->at(i);
+				if (at > f && at < t)
+					return true;
+			}
+			return false;
+		}
+
+
+		/**
+		 * Linear scan over the intervals.
+		 */
+
+		// Is 'r' preserved through function calls?
+		static bool preserved(Reg r) {
+			Nat count = 0;
+			const Reg *regs = preservedRegs(count);
+			for (Nat i = 0; i < count; i++)
+				if (same(regs[i], r))
+					return true;
+			return false;
+		}
+
+		// Find a free register in 'regs'.
+		static Reg freeReg(const Reg *regs, Nat count, RegSet *busy, RegSet *used) {
+			for (Nat i = 0; i < count; i++)
+				if (!busy->has(regs[i]) && !used->has(regs[i]))
+					return regs[i];
+			return noReg;
+		}
+
+		static void linearScan(Liveness &l, Array<Nat> *result) {
+			Nat vars = l.from->count();
+
+			// Sort all intervals on their start position (counting sort, positions are small).
+			Array<Nat> *start = new (l.src) Array<Nat>(l.src->count() + 2, 0);
+			for (Nat i = 0; i < vars; i++)
+				if (l.from->at(i) != none)
+					start->at(l.from->at(i) + 1)++;
+			for (Nat i = 1; i < start->count(); i++)
+				start->at(i) += start->at(i - 1);
+
+			Array<Nat> *order = new (l.src) Array<Nat>(start->last(), 0);
+			for (Nat i = 0; i < vars; i++)
+				if (l.from->at(i) != none)
+					order->at(start->at(l.from->at(i))++) = i;
+
+			Nat scratchCount = 0, preservedCount = 0, vectorCount = 0;
+			const Reg *scratch = scratchRegs(scratchCount);
+			const Reg *saved = preservedRegs(preservedCount);
+			const Reg *vectors = vectorRegs(vectorCount);
+			Array<Var> *allVars = l.src->allVars();
+
+			// Currently active intervals, and the registers they occupy.
+			Array<Nat> *active = new (l.src) Array<Nat>();
+			RegSet *busy = new (l.src) RegSet();
+
+			for (Nat i = 0; i < order->count(); i++) {
+				Nat v = order->at(i);
+				Nat pos = l.from->at(v);
+
+				// Expire old intervals.
+				for (Nat j = active->count(); j > 0; j--) {
+					Nat a = active->at(j - 1);
+					if (l.to->at(a) < pos) {
+						busy->remove(Reg(result->at(a)));
+						active->remove(j - 1);
+					}
+				}
+
+				bool call = l.crossesCall(v);
+				bool vector = allVars->at(v).size() == Size::sVec;
+				Reg r = noReg;
+				if (vector) {
+					// No xmm registers are preserved through function calls.
+					if (call)
+						continue;
+					r = freeReg(vectors, vectorCount, busy, l.used);
+				} else {
+					if (!call)
+						r = freeReg(scratch, scratchCount, busy, l.used);
+					if (r == noReg)
+						r = freeReg(saved, preservedCount, busy, l.used);
+				}
+
+				if (r == noReg) {
+					// Spill the interval with the lowest weight that occupies a suitable register.
+					Nat spill = none;
+					for (Nat j = 0; j < active->count(); j++) {
+						Nat a = active->at(j);
+						if (vector != (allVars->at(a).size() == Size::sVec))
+							continue;
+						if (call && !preserved(Reg(result->at(a))))
+							continue;
+						if (spill == none || l.weight->at(a) < l.weight->at(active->at(spill)))
+							spill = j;
+					}
+
+					if (spill == none || l.weight->at(active->at(spill)) >= l.weight->at(v))
+						continue;
+
+					Nat a = active->at(spill);
+					r = Reg(result->at(a));
+					result->at(a) = noReg;
+					active->remove(spill);
+					busy->remove(r);
+				}
+
+				result->at(v) = r;
+				busy->put(r);
+				active->push(v);
+			}
+		}
+
+
+		/**
+		 * The transform.
+		 */
+
+		RegAlloc::RegAlloc() {}
+
+		void RegAlloc::before(Listing *dest, Listing *src) {
+			assigned = new (this) Array<Nat>(src->allVars()->count(), noReg);
+
+			Liveness l(src);
+			if (l.valid)
+				linearScan(l, assigned);
+		}
+
+		void RegAlloc::during(Listing *dest, Listing *src, Nat line) {
+			Instr *i = src->at(line);
+
+			switch (i->op()) {
+			case op::prolog:
+				*dest << i;
+				initBlock(dest, dest->root());
+				break;
+			case op::beginBlock:
+				*dest << i;
+				initBlock(dest, i->src().block());
+				break;
+			default:
+				*dest << i->alter(resolve(i->dest()), resolve(i->src()));
+				break;
+			}
+		}
+
+		Operand RegAlloc::resolve(const Operand &op) {
+			if (op.type() != opVariable)
+				return op;
+
+			Reg r = Reg(assigned->at(op.var().key()));
+			if (r == noReg)
+				return op;
+
+			return asSize(r, op.size());
+		}
+
+		void RegAlloc::initBlock(Listing *dest, Block block) {
+			// Parameters are loaded from where Layout spills them in the prolog.
+			if (block == dest->root()) {
+				Array<Var> *params = dest->allParams();
+				for (Nat i = 0; i < params->count(); i++) {
+					Var v = params->at(i);
+					Reg r = Reg(assigned->at(v.key()));
+					if (r != noReg)
+						*dest << mov(asSize(r, v.size()), v);
+				}
+			}
+
+			// Other variables are zero-initialized, just like Layout does for variables in memory.
+			Array<Var> *vars = dest->allVars(block);
+			for (Nat i = 0; i < vars->count(); i++) {
+				Var v = vars->at(i);
+				Reg r = Reg(assigned->at(v.key()));
+				if (r == noReg || dest->isParam(v))
+					continue;
+
+				if (v.size() == Size::sVec)
+					*dest << vxor(r, r);
+				else
+					*dest << mov(asSize(r, v.size()), xConst(v.size(), 0));
+			}
+		}
+
+	}
+}
@@ -0,0 +1,52 @@
+#pragma once
+#include "../Transform.h"
+#include "../Reg.h"
+#include "../Instr.h"
+#include "Core/Array.h"
+
+namespace code {
+	namespace x64 {
+		STORM_PKG(core.asm.x64);
+
+		/**
+		 * Register allocation for variables in a listing. Uses a linear scan over the live
+		 * intervals of all variables to keep frequently used variables in registers that are not
+		 * otherwise used in the listing, instead of accessing them through their stack slot every
+		 * time.
+		 *
+		 * The transform is conservative. Only variables that fit in a single register, that do not
+		 * have a destructor, and whose address is never needed are considered. Intervals that span
+		 * function calls or block exits (which may call destructors) are only assigned to
+		 * registers that are preserved across function calls. These are saved in the prolog by the
+		 * Layout transform as usual, and are therefore visible to the garbage collector and
+		 * restored by the unwinder during exception handling. Vector variables are kept in xmm
+		 * registers, which are never preserved, so only their intervals that do not span function
+		 * calls are considered. Variables in registers are initialized at the start of their block,
+		 * just like Layout does for variables in memory.
+		 *
+		 * Expected to run after RemoveInvalid and before Layout.
+		 */
+		class RegAlloc : public Transform {
+			STORM_CLASS;
+		public:
+			STORM_CTOR RegAlloc();
+
+			// Start transform.
+			virtual void STORM_FN before(Listing *dest, Listing *src);
+
+			// Transform a single instruction.
+			virtual void STORM_FN during(Listing *dest, Listing *src, Nat id);
+
+		private:
+			// Register assigned to each variable, or 'noReg' if it is to be kept in memory.
+			Array<Nat> *assigned;
+
+			// Replace a variable with its register (if any).
+			Operand resolve(const Operand &op);
+
+			// Initialize the registers of all variables in 'block'.
+			void initBlock(Listing *dest, Block block);
+		};
+
+	}
+}
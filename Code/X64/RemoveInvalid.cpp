@@ -20,9 +20,10 @@ namespace code {
 #define IMM_REG(x) { op::x, &RemoveInvalid::immRegTfm }
 #define DEST_W_REG(x) { op::x, &RemoveInvalid::destRegWTfm }
 #define DEST_RW_REG(x) { op::x, &RemoveInvalid::destRegRwTfm }
+#define FP_ARITH(x) { op::x, &RemoveInvalid::fpArithTfm }
 
 		const OpEntry<RemoveInvalid::TransformFn> RemoveInvalid::transformMap[] = {
-			IMM_REG(mov),
+			TRANSFORM(mov),
 			IMM_REG(add),
 			IMM_REG(adc),
 			IMM_REG(bor),
@@ -54,6 +55,35 @@ namespace code {
 			TRANSFORM(shr),
 			TRANSFORM(sar),
 			TRANSFORM(shl),
+
+			FP_ARITH(fadd),
+			FP_ARITH(fsub),
+			FP_ARITH(fmul),
+			FP_ARITH(fdiv),
+			TRANSFORM(fneg),
+			TRANSFORM(fcmp),
+			TRANSFORM(fcast),
+			TRANSFORM(fcasti),
+			TRANSFORM(icastf),
+
+			// The packed operations are encoded like the scalar floating point operations.
+			FP_ARITH(vadd),
+			FP_ARITH(vsub),
+			FP_ARITH(vand),
+			FP_ARITH(vor),
+			FP_ARITH(vxor),
+			FP_ARITH(vcmpeq),
+			FP_ARITH(vcmpgt),
+			FP_ARITH(vfadd),
+			FP_ARITH(vfsub),
+			FP_ARITH(vfmul),
+			FP_ARITH(vfdiv),
+			FP_ARITH(vfmin),
+			FP_ARITH(vfmax),
+			FP_ARITH(vfcmpeq),
+			FP_ARITH(vfcmplt),
+			FP_ARITH(vfcmple),
+			TRANSFORM(vshuffle),
 		};
 
 		static bool isComplexParam(Listing *l, Var v) {
@@ -129,11 +159,17 @@ namespace code {
 			}
 		}
 
+		Operand RemoveInvalid::largeConst(const Operand &c) {
+			// All entries are 8 bytes, to keep them aligned.
+			Operand r = xRel(c.size(), lblLarge, Offset::sWord*large->count());
+			large->push(wordConst(c.constant()));
+			return r;
+		}
+
 		Instr *RemoveInvalid::extractNumbers(Instr *i) {
 			Operand src = i->src();
 			if (src.type() == opConstant && src.size() == Size::sWord && !singleInt(src.constant())) {
-				i = i->alterSrc(longRel(lblLarge, Offset::sWord*large->count()));
-				large->push(src);
+				i = i->alterSrc(largeConst(src));
 			}
 
 			// Labels are also constants.
@@ -199,6 +235,18 @@ namespace code {
 			*dest << instr->alterSrc(reg);
 		}
 
+		void RemoveInvalid::movTfm(Listing *dest, Instr *instr, Nat line) {
+			// Vectors only fit in xmm registers.
+			if (instr->size() != Size::sVec || fpRegister(instr->src()) || fpRegister(instr->dest())) {
+				immRegTfm(dest, instr, line);
+				return;
+			}
+
+			Reg reg = asSize(unusedFpReg(used->at(line)), Size::sVec);
+			*dest << mov(reg, instr->src());
+			*dest << instr->alterSrc(reg);
+		}
+
 		void RemoveInvalid::destRegWTfm(Listing *dest, Instr *instr, Nat line) {
 			if (instr->dest().type() == opRegister) {
 				*dest << instr;
@@ -319,7 +367,95 @@ namespace code {
 			shlTfm(dest, instr, line);
 		}
 
+		bool RemoveInvalid::constDiv(Listing *dest, Instr *instr, Nat line) {
+			const Operand &op = instr->dest();
+			const Operand &src = instr->src();
+			if (src.type() != opConstant || op.size() != Size::sInt)
+				return false;
+
+			bool sign = instr->op() == op::idiv || instr->op() == op::imod;
+			bool mod = instr->op() == op::imod || instr->op() == op::umod;
+
+			// Find the magnitude of the divisor. Dividing by zero should still fail, and so should
+			// dividing INT_MIN by -1.
+			Nat value = Nat(src.constant());
+			Nat divisor = value;
+			if (sign && Int(value) < 0)
+				divisor = Nat(0) - value;
+			if (divisor == 0 || divisor > (Nat(1) << 31))
+				return false;
+			if (sign && Int(value) == -1)
+				return false;
+
+			// For a divisor d and l = ceil(log2(d)), the quotient of an n < 2^32 is (n * m) >>
+			// (32 + l) where m = ceil(2^(32 + l) / d). The multiplier is between 2^32 and 2^33, so
+			// we multiply by m - 2^32 and add n afterwards to avoid overflow.
+			Nat shift = 0;
+			while ((Word(1) << shift) < divisor)
+				shift++;
+			Word magic = ((Word(1) << (32 + shift)) + divisor - 1) / divisor - (Word(1) << 32);
+
+			RegSet *used = new (this) RegSet(*this->used->at(line));
+			Reg regs[4] = { noReg, noReg, noReg, noReg };
+			Nat count = sign ? 4 : 3;
+			for (Nat i = 0; i < count; i++) {
+				regs[i] = unusedRegUnsafe(used);
+				if (regs[i] == noReg)
+					return false;
+				used->put(regs[i]);
+			}
+
+			Reg n = asSize(regs[0], Size::sLong);
+			Reg q = asSize(regs[1], Size::sLong);
+			Reg tmp = asSize(regs[2], Size::sLong);
+			Reg s = asSize(regs[3], Size::sInt);
+
+			// Load the dividend. 32-bit writes clear the upper part of the register.
+			*dest << mov(asSize(n, Size::sInt), op);
+			if (sign) {
+				// Take the absolute value. 's' is -1 for negative numbers, 0 otherwise.
+				*dest << mov(s, asSize(n, Size::sInt));
+				*dest << sar(s, byteConst(31));
+				*dest << bxor(asSize(n, Size::sInt), s);
+				*dest << sub(asSize(n, Size::sInt), s);
+			}
+
+			*dest << mov(q, n);
+			if (magic < (Word(1) << 31)) {
+				*dest << mul(q, longConst(Long(magic)));
+			} else {
+				*dest << mov(asSize(tmp, Size::sInt), natConst(Nat(magic)));
+				*dest << mul(q, tmp);
+			}
+			*dest << shr(q, byteConst(32));
+			*dest << add(q, n);
+			if (shift > 0)
+				*dest << shr(q, byteConst(Byte(shift)));
+
+			Reg result = asSize(q, Size::sInt);
+			if (mod) {
+				// The remainder has the same sign as the dividend.
+				*dest << mul(result, natConst(divisor));
+				*dest << sub(asSize(n, Size::sInt), result);
+				result = asSize(n, Size::sInt);
+			} else if (sign && Int(value) < 0) {
+				// The quotient has the opposite sign of the dividend.
+				*dest << bnot(s);
+			}
+
+			if (sign) {
+				*dest << bxor(result, s);
+				*dest << sub(result, s);
+			}
+
+			*dest << mov(op, result);
+			return true;
+		}
+
 		void RemoveInvalid::idivTfm(Listing *dest, Instr *instr, Nat line) {
+			if (constDiv(dest, instr, line))
+				return;
+
 			RegSet *used = new (this) RegSet(*this->used->at(line));
 			const Operand &op = instr->dest();
 			bool small = op.size() == Size::sByte;
@@ -375,6 +511,9 @@ namespace code {
 		}
 
 		void RemoveInvalid::imodTfm(Listing *dest, Instr *instr, Nat line) {
+			if (constDiv(dest, instr, line))
+				return;
+
 			RegSet *used = new (this) RegSet(*this->used->at(line));
 			const Operand &op = instr->dest();
 			bool small = op.size() == Size::sByte;
@@ -435,5 +574,154 @@ namespace code {
 			imodTfm(dest, instr, line);
 		}
 
+
+		Operand RemoveInvalid::fpSrc(Listing *dest, const Operand &src, RegSet *used) {
+			switch (src.type()) {
+			case opConstant:
+				// There are no immediate forms of the SSE instructions.
+				return largeConst(src);
+			case opRegister:
+				if (!fpRegister(src)) {
+					Reg r = asSize(unusedFpReg(used), src.size());
+					used->put(r);
+					*dest << mov(r, src);
+					return r;
+				}
+				used->put(src.reg());
+				return src;
+			default:
+				// In memory. The packed operations require memory operands to be aligned to 16 bytes,
+				// but vectors are only aligned to 8 bytes. Load them using an unaligned move first.
+				if (src.size() == Size::sVec) {
+					Reg r = asSize(unusedFpReg(used), Size::sVec);
+					used->put(r);
+					*dest << mov(r, src);
+					return r;
+				}
+				return src;
+			}
+		}
+
+		void RemoveInvalid::fpArithTfm(Listing *dest, Instr *instr, Nat line) {
+			RegSet *used = new (this) RegSet(*this->used->at(line));
+			Operand to = instr->dest();
+			Operand src = fpSrc(dest, instr->src(), used);
+
+			if (fpRegister(to)) {
+				*dest << instr->alterSrc(src);
+				return;
+			}
+
+			Reg r = asSize(unusedFpReg(used), to.size());
+			*dest << mov(r, to);
+			*dest << instr->alter(r, src);
+			*dest << mov(to, r);
+		}
+
+		void RemoveInvalid::vshuffleTfm(Listing *dest, Instr *instr, Nat line) {
+			Operand to = instr->dest();
+			if (fpRegister(to)) {
+				*dest << instr;
+				return;
+			}
+
+			Reg r = asSize(unusedFpReg(used->at(line)), Size::sVec);
+			*dest << mov(r, to);
+			*dest << instr->alterDest(r);
+			*dest << mov(to, r);
+		}
+
+		void RemoveInvalid::fnegTfm(Listing *dest, Instr *instr, Nat line) {
+			// Flip the sign bit using a regular register.
+			Operand to = instr->dest();
+			Size size = to.size();
+			Reg r = asSize(unusedReg(used->at(line)), size);
+
+			*dest << mov(r, instr->src());
+			if (size == Size::sDouble)
+				*dest << bxor(r, largeConst(wordConst(Word(1) << 63)));
+			else
+				*dest << bxor(r, natConst(0x80000000));
+			*dest << mov(to, r);
+		}
+
+		void RemoveInvalid::fcmpTfm(Listing *dest, Instr *instr, Nat line) {
+			RegSet *used = new (this) RegSet(*this->used->at(line));
+			Operand a = instr->dest();
+			Operand b = fpSrc(dest, instr->src(), used);
+
+			if (a.type() == opConstant)
+				a = largeConst(a);
+
+			if (!fpRegister(a)) {
+				Reg r = asSize(unusedFpReg(used), a.size());
+				*dest << mov(r, a);
+				a = r;
+			}
+
+			*dest << instr->alter(a, b);
+		}
+
+		void RemoveInvalid::fcastTfm(Listing *dest, Instr *instr, Nat line) {
+			Operand to = instr->dest();
+			if (to.size() == instr->src().size()) {
+				// Nothing to convert.
+				immRegTfm(dest, mov(engine(), to, instr->src()), line);
+				return;
+			}
+
+			RegSet *used = new (this) RegSet(*this->used->at(line));
+			Operand src = fpSrc(dest, instr->src(), used);
+
+			if (fpRegister(to)) {
+				*dest << instr->alterSrc(src);
+				return;
+			}
+
+			Reg r = asSize(unusedFpReg(used), to.size());
+			*dest << instr->alter(r, src);
+			*dest << mov(to, r);
+		}
+
+		void RemoveInvalid::fcastiTfm(Listing *dest, Instr *instr, Nat line) {
+			RegSet *used = new (this) RegSet(*this->used->at(line));
+			Operand to = instr->dest();
+			Operand src = fpSrc(dest, instr->src(), used);
+
+			if (to.type() == opRegister && !fpRegister(to)) {
+				*dest << instr->alterSrc(src);
+				return;
+			}
+
+			Reg r = asSize(unusedReg(used), to.size());
+			*dest << instr->alter(r, src);
+			*dest << mov(to, r);
+		}
+
+		void RemoveInvalid::icastfTfm(Listing *dest, Instr *instr, Nat line) {
+			RegSet *used = new (this) RegSet(*this->used->at(line));
+			Operand to = instr->dest();
+			Operand src = instr->src();
+
+			// The source is either a regular register or in memory.
+			if (src.type() == opConstant) {
+				src = largeConst(src);
+			} else if (fpRegister(src)) {
+				Reg r = asSize(unusedReg(used), src.size());
+				used->put(r);
+				*dest << mov(r, src);
+				src = r;
+			}
+
+			if (fpRegister(to)) {
+				*dest << instr->alterSrc(src);
+				return;
+			}
+
+			Reg r = asSize(unusedFpReg(used), to.size());
+			*dest << instr->alter(r, src);
+			*dest << mov(to, r);
+		}
+
 	}
 }
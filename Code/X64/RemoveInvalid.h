@@ -44,6 +44,9 @@ namespace code {
 			// Extract any large numbers from an instruction.
 			Instr *extractNumbers(Instr *i);
 
+			// Store a constant among the large constants, and return an operand referring to it.
+			Operand largeConst(const Operand &c);
+
 			// Remove any references to complex parameters.
 			Instr *extractComplex(Listing *dest, Instr *i, Nat line);
 
@@ -62,6 +65,9 @@ namespace code {
 			// Generic transform function for instructions using a generic two-op immReg form.
 			void immRegTfm(Listing *dest, Instr *instr, Nat line);
 
+			// Mov instructions. Uses an xmm register for vectors.
+			void movTfm(Listing *dest, Instr *instr, Nat line);
+
 			// Generic transform for instructions requiring their dest operand to be a register.
 			void destRegWTfm(Listing *dest, Instr *instr, Nat line);
 			void destRegRwTfm(Listing *dest, Instr *instr, Nat line);
@@ -85,6 +91,26 @@ namespace code {
 			void imodTfm(Listing *dest, Instr *instr, Nat line);
 			void udivTfm(Listing *dest, Instr *instr, Nat line);
 			void umodTfm(Listing *dest, Instr *instr, Nat line);
+
+			// Replace 32-bit division or modulo by a constant with multiplication and shifts.
+			// Returns false if not possible, in which case nothing is emitted.
+			bool constDiv(Listing *dest, Instr *instr, Nat line);
+
+			// Floating point operations. SSE instructions require the destination to be a xmm
+			// register, and the source to be either a xmm register or in memory.
+			void fpArithTfm(Listing *dest, Instr *instr, Nat line);
+			void fnegTfm(Listing *dest, Instr *instr, Nat line);
+			void fcmpTfm(Listing *dest, Instr *instr, Nat line);
+			void fcastTfm(Listing *dest, Instr *instr, Nat line);
+			void fcastiTfm(Listing *dest, Instr *instr, Nat line);
+			void icastfTfm(Listing *dest, Instr *instr, Nat line);
+
+			// Packed operations. Except for 'vshuffle', these are handled by 'fpArithTfm'.
+			void vshuffleTfm(Listing *dest, Instr *instr, Nat line);
+
+			// Make 'src' suitable as the source operand of a SSE instruction. Registers used are
+			// added to 'used'.
+			Operand fpSrc(Listing *dest, const Operand &src, RegSet *used);
 		};
 
 	}
@@ -2,6 +2,7 @@
 #include "Arena.h"
 #include "Output.h"
 #include "Listing.h"
+#include "../Optimize.h"
 #include "Remove64.h"
 #include "RemoveInvalid.h"
 #include "LayoutVars.h"
@@ -22,11 +23,15 @@ namespace code {
 
 		Arena::Arena() {}
 
-		Listing *Arena::transform(Listing *l, Binary *owner) const {
+		Listing *Arena::transform(Listing *l, Binary *owner, Bool fast) const {
 #if defined(WINDOWS) && defined(X86)
 			activateInfo();
 #endif
 
+			// Constant folding and dead code elimination.
+			if (optimize && !fast)
+				l = code::transform(l, this, new (this) Optimize());
+
 			if (has64(l)) {
 				// Replace any 64-bit operations with 32-bit corresponding operations.
 				l = code::transform(l, this, new (this) Remove64());
@@ -114,6 +114,9 @@ namespace code {
 
 			layout = code::x86::layout(src, preserved->count(), usingEH, resultParam, memberFn);
 
+			// Variables that need to be zeroed when their block is entered.
+			zero = zeroVars(src);
+
 			// Initialize the 'activated' array.
 			Array<Var> *vars = src->allVars();
 			activated = new (this) Array<Nat>(vars->count(), 0);
@@ -220,19 +223,17 @@ namespace code {
 			bool initEax = true;
 
 			Array<Var> *vars = dest->allVars(init);
-			Array<Listing::CatchInfo> *catchInfo = dest->catchInfo(init);
 			// Go in reverse to make linear accesses in memory when we're using big variables.
 			for (nat i = vars->count(); i > 0; i--) {
 				Var v = vars->at(i - 1);
 
-				if (!dest->isParam(v))
+				if (!dest->isParam(v) && zero->at(v.key()))
 					zeroVar(dest, layout->at(v.key()), v.size(), initEax);
 			}
 
-			// If the block was empty, we don't need to update the info.
-			if (vars->any())
-				updateBlockId(dest);
-			else if (catchInfo && catchInfo->any())
+			// If the block does not affect exception handling, the id of the parent block is just as
+			// good, and we don't need to update the info.
+			if (exceptionBlock(dest, init))
 				updateBlockId(dest);
 		}
 
@@ -289,7 +290,6 @@ namespace code {
 			bool pushedEax = false;
 
 			Array<Var> *vars = dest->allVars(destroy);
-			Array<Listing::CatchInfo> *catchInfo = dest->catchInfo(destroy);
 			// Destroy in reverse order.
 			for (Nat i = vars->count(); i > 0; i--) {
 				Var v = vars->at(i - 1);
@@ -331,10 +331,8 @@ namespace code {
 				restoreResult(dest);
 
 			block = dest->parent(block);
-			// If empty, we don't need to update.
-			if (vars->any())
-				updateBlockId(dest);
-			else if (catchInfo && catchInfo->any())
+			// If we did not update the info when entering the block, we don't need to do it now.
+			if (exceptionBlock(dest, destroy))
 				updateBlockId(dest);
 		}
 
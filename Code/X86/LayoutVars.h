@@ -58,6 +58,9 @@ namespace code {
 			// Layout of variables.
 			Array<Offset> *layout;
 
+			// Variables to zero when their block is entered (see 'zeroVars').
+			Array<Bool> *zero;
+
 			// Index where each variable was activated.
 			Array<Nat> *activated;
 
@@ -3,6 +3,7 @@
 #include "Binary.h"
 #include "Asm.h"
 #include "Gc/CodeTable.h"
+#include "Gc/PerfMap.h"
 #include "Utils/Bitwise.h"
 
 namespace code {
@@ -15,10 +16,11 @@ namespace code {
 			// Initialize our members.
 			this->owner = owner;
 			codeRefs = new (this) Array<Reference *>();
-			code = (byte *)runtime::allocCode(engine(), size + 2*sizeof(void *), numRefs + 3);
+			Nat reserved = perfMap().enabled() ? 4 : 3;
+			code = (byte *)runtime::allocCode(engine(), size + 2*sizeof(void *), numRefs + reserved);
 			labels = lbls;
 			pos = 0;
-			ref = 3;
+			ref = reserved;
 
 			// Store 'codeRefs' and 'owner' at the end of our allocated space.
 			GcCode *refs = runtime::codeRefs(code);
@@ -34,6 +36,13 @@ namespace code {
 			refs->refs[2].offset = 0;
 			refs->refs[2].kind = GcCodeRef::unwindInfo;
 			refs->refs[2].pointer = unwind;
+
+			// An entry for the perf map, if enabled.
+			if (reserved > 3) {
+				refs->refs[3].offset = 0;
+				refs->refs[3].kind = GcCodeRef::perfMap;
+				refs->refs[3].pointer = perfMap().add(code, size);
+			}
 		}
 
 		void CodeOut::putByte(Byte b) {
@@ -139,7 +148,9 @@ namespace code {
 			if (ref == 0)
 				return;
 
-			codeRefs->push(new (this) CodeUpdater(r, owner, code, ref - 1));
+			CodeUpdater *updater = new (this) CodeUpdater(r, owner, code, ref - 1);
+			codeRefs->push(updater);
+			owner->addReference(updater);
 		}
 
 		Nat CodeOut::labelOffset(Nat id) {
@@ -10,6 +10,7 @@ namespace code {
 
 #define IMM_REG(x) { op::x, &RemoveInvalid::immRegTfm }
 #define TRANSFORM(x) { op::x, &RemoveInvalid::x ## Tfm }
+#define VECTOR(x) { op::x, &RemoveInvalid::vectorTfm }
 
 		const OpEntry<RemoveInvalid::TransformFn> RemoveInvalid::transformMap[] = {
 			IMM_REG(mov),
@@ -35,10 +36,38 @@ namespace code {
 			TRANSFORM(icast),
 			TRANSFORM(ucast),
 
+			TRANSFORM(fadd),
+			TRANSFORM(fsub),
+			TRANSFORM(fneg),
+			TRANSFORM(fmul),
+			TRANSFORM(fdiv),
+			TRANSFORM(fcmp),
+			TRANSFORM(fcast),
+			TRANSFORM(fcasti),
+			TRANSFORM(icastf),
+
 			TRANSFORM(fnParam),
 			TRANSFORM(fnParamRef),
 			TRANSFORM(fnCall),
 			TRANSFORM(fnCallRef),
+
+			VECTOR(vadd),
+			VECTOR(vsub),
+			VECTOR(vand),
+			VECTOR(vor),
+			VECTOR(vxor),
+			VECTOR(vcmpeq),
+			VECTOR(vcmpgt),
+			VECTOR(vfadd),
+			VECTOR(vfsub),
+			VECTOR(vfmul),
+			VECTOR(vfdiv),
+			VECTOR(vfmin),
+			VECTOR(vfmax),
+			VECTOR(vfcmpeq),
+			VECTOR(vfcmplt),
+			VECTOR(vfcmple),
+			VECTOR(vshuffle),
 		};
 
 		RemoveInvalid::Param::Param(Operand src, TypeDesc *type, Bool ref) : src(src), type(type), ref(ref) {}
@@ -677,5 +706,108 @@ namespace code {
 			params->clear();
 		}
 
+
+		// Load 'src' onto the x87 stack using 'op' (fld or fild). The x87 instructions only accept
+		// memory operands, so registers and constants are pushed onto the stack temporarily.
+		static void fpLoad(Listing *dest, op::OpCode op, const Operand &src) {
+			Engine &e = dest->engine();
+			switch (src.type()) {
+			case opRegister:
+			case opConstant:
+				if (src.size().size32() > 4) {
+					*dest << push(high32(src));
+					*dest << push(low32(src));
+				} else {
+					*dest << push(src);
+				}
+				*dest << instrSrc(e, op, xRel(src.size(), ptrStack, Offset()));
+				*dest << add(ptrStack, ptrConst(Offset(src.size().size32() > 4 ? 8 : 4)));
+				break;
+			default:
+				*dest << instrSrc(e, op, src);
+				break;
+			}
+		}
+
+		// Store the top of the x87 stack into 'to' using 'op' (fstp or fistp).
+		static void fpStore(Listing *dest, op::OpCode op, const Operand &to) {
+			Engine &e = dest->engine();
+			if (to.type() != opRegister) {
+				*dest << instrDest(e, op, to);
+				return;
+			}
+
+			bool large = to.size().size32() > 4;
+			*dest << sub(ptrStack, ptrConst(Offset(large ? 8 : 4)));
+			*dest << instrDest(e, op, xRel(to.size(), ptrStack, Offset()));
+			if (large) {
+				*dest << pop(low32(to));
+				*dest << pop(high32(to));
+			} else {
+				*dest << pop(to);
+			}
+		}
+
+		void RemoveInvalid::faddTfm(Listing *dest, Instr *instr, Nat line) {
+			fpLoad(dest, op::fld, instr->dest());
+			fpLoad(dest, op::fld, instr->src());
+			*dest << faddp();
+			fpStore(dest, op::fstp, instr->dest());
+		}
+
+		void RemoveInvalid::fsubTfm(Listing *dest, Instr *instr, Nat line) {
+			fpLoad(dest, op::fld, instr->dest());
+			fpLoad(dest, op::fld, instr->src());
+			*dest << fsubp();
+			fpStore(dest, op::fstp, instr->dest());
+		}
+
+		void RemoveInvalid::fnegTfm(Listing *dest, Instr *instr, Nat line) {
+			*dest << fldz();
+			fpLoad(dest, op::fld, instr->src());
+			*dest << fsubp();
+			fpStore(dest, op::fstp, instr->dest());
+		}
+
+		void RemoveInvalid::fmulTfm(Listing *dest, Instr *instr, Nat line) {
+			fpLoad(dest, op::fld, instr->dest());
+			fpLoad(dest, op::fld, instr->src());
+			*dest << fmulp();
+			fpStore(dest, op::fstp, instr->dest());
+		}
+
+		void RemoveInvalid::fdivTfm(Listing *dest, Instr *instr, Nat line) {
+			fpLoad(dest, op::fld, instr->dest());
+			fpLoad(dest, op::fld, instr->src());
+			*dest << fdivp();
+			fpStore(dest, op::fstp, instr->dest());
+		}
+
+		void RemoveInvalid::fcmpTfm(Listing *dest, Instr *instr, Nat line) {
+			fpLoad(dest, op::fld, instr->src());
+			fpLoad(dest, op::fld, instr->dest());
+			*dest << fcompp();
+		}
+
+		void RemoveInvalid::fcastTfm(Listing *dest, Instr *instr, Nat line) {
+			fpLoad(dest, op::fld, instr->src());
+			fpStore(dest, op::fstp, instr->dest());
+		}
+
+		void RemoveInvalid::fcastiTfm(Listing *dest, Instr *instr, Nat line) {
+			fpLoad(dest, op::fld, instr->src());
+			fpStore(dest, op::fistp, instr->dest());
+		}
+
+		void RemoveInvalid::icastfTfm(Listing *dest, Instr *instr, Nat line) {
+			fpLoad(dest, op::fild, instr->src());
+			fpStore(dest, op::fstp, instr->dest());
+		}
+
+		void RemoveInvalid::vectorTfm(Listing *dest, Instr *instr, Nat line) {
+			Str *msg = TO_S(this, S("The X86 backend does not support the packed operation ") << name(instr->op()) << S("."));
+			throw new (this) InvalidValue(msg);
+		}
+
 	}
 }
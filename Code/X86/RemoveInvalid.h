@@ -68,6 +68,20 @@ namespace code {
 			void icastTfm(Listing *dest, Instr *instr, Nat line);
 			void ucastTfm(Listing *dest, Instr *instr, Nat line);
 
+			// Floating point operations are implemented using the x87 stack.
+			void faddTfm(Listing *dest, Instr *instr, Nat line);
+			void fsubTfm(Listing *dest, Instr *instr, Nat line);
+			void fnegTfm(Listing *dest, Instr *instr, Nat line);
+			void fmulTfm(Listing *dest, Instr *instr, Nat line);
+			void fdivTfm(Listing *dest, Instr *instr, Nat line);
+			void fcmpTfm(Listing *dest, Instr *instr, Nat line);
+			void fcastTfm(Listing *dest, Instr *instr, Nat line);
+			void fcastiTfm(Listing *dest, Instr *instr, Nat line);
+			void icastfTfm(Listing *dest, Instr *instr, Nat line);
+
+			// Packed operations are not supported, since SSE2 is not always available.
+			void vectorTfm(Listing *dest, Instr *instr, Nat line);
+
 			// Perform a function call.
 			void fnCall(Listing *dest, TypeInstr *instr, Array<Param> *params);
 
@@ -19,12 +19,20 @@ namespace storm {
 			engine,
 			// Reference to the entry-point for lazy code updates.
 			lazyCodeUpdate,
+			// Reference to the function called when lazy code is to be optimized.
+			lazyCodeTierUp,
 			// Reference to the throw function for a rule.
 			ruleThrow,
 			// Allocate an object of the type given.
 			alloc,
 			// Allocate an array of the given type and size.
 			allocArray,
+			// Finish an object allocated inline by generated code, when the GC interfered with the
+			// allocation. See 'allocObject' in CodeGen.h.
+			allocTrapped,
+			// Address of the word that the owner of thread-local allocation buffers is compared to.
+			// See GcInlineAlloc.
+			inlineAllocKey,
 			// Execute as<T>.
 			as,
 			// # of bytes inside a vtable the object's vtable ptr is pointing.
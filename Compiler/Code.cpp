@@ -4,7 +4,13 @@
 #include "Function.h"
 #include "Exception.h"
 #include "Engine.h"
+#include "Inline.h"
+#include "TailCall.h"
+#include "InlineCache.h"
+#include "CompilePool.h"
+#include "CodeCache.h"
 #include "Core/Str.h"
+#include "Code/Arena.h"
 
 namespace storm {
 
@@ -128,12 +134,40 @@ namespace storm {
 	 * Lazy code.
 	 */
 
-	LazyCode::LazyCode(Fn<CodeGen *> *generate) : binary(null), sourceData(generate), state(sUnloaded) {}
+	// Number of calls and loop iterations before code is optimized.
+	static const Nat tierThreshold = 1000;
+
+	LazyCode::LazyCode(Fn<CodeGen *> *generate) :
+		binary(null), sourceData(generate), counter(tierThreshold), caches(null), inlined(null), state(sUnloaded) {}
 
 	void LazyCode::compile() {
 		// We're always running on the Compiler thread, so it is safe to call 'updateCodeLocal'.
-		if ((state & sMask) != sLoading)
+		if ((state & sMask) == sLoading)
+			return;
+
+		CompilePool *pool = engine().compilePool();
+		if ((state & sMask) != sUnloaded || !pool->parallel()) {
 			updateCodeLocal(this);
+			return;
+		}
+
+		state = (state & ~sMask) | sLoading;
+		try {
+			if (loadCached())
+				return;
+
+			CompileJob *job = prepare(generateSource());
+			if (job->inlined->any()) {
+				// The inlined functions must not change before we know about them.
+				job->run();
+				compiled(job);
+			} else {
+				pool->compile(job);
+			}
+		} catch (...) {
+			state = (state & ~sMask) | sUnloaded;
+			throw;
+		}
 	}
 
 	MAYBE(code::Listing *) LazyCode::source() {
@@ -143,17 +177,54 @@ namespace storm {
 
 		if (state & sDiscardSource)
 			return null;
-		else
-			return (code::Listing *)sourceData;
+
+		if (state & sCached) {
+			// Generate the listing now. We don't need to compile it.
+			sourceData = generate()->call()->l;
+			state &= ~sCached;
+		}
+
+		return (code::Listing *)sourceData;
 	}
 
 	void LazyCode::discardSource() {
 		state |= sDiscardSource;
 
-		if ((state & sMask) == sLoaded)
+		// Keep the listing until the code is optimized, and keep small listings around so that
+		// they can be inlined.
+		if ((state & sMask) == sLoaded && (state & sOptimized) && !(state & sCached)
+			&& !inlineCandidate((code::Listing *)sourceData))
 			sourceData = null;
 	}
 
+	MAYBE(code::Listing *) LazyCode::inlineSource() {
+		if ((state & sMask) != sLoaded || (state & sCached))
+			return null;
+		return (code::Listing *)sourceData;
+	}
+
+	void LazyCode::inlinedChanged() {
+		// Wait until the next call to re-compile. We are likely called while references are updated.
+		if ((state & sMask) == sLoaded) {
+			// Go back to unoptimized code, so that we can see how the new functions are used
+			// before optimizing again.
+			state &= ~sOptimized;
+			counter = tierThreshold;
+			createRedirect();
+		}
+	}
+
+	Bool LazyCode::optimized() const {
+		return (state & sMask) == sLoaded && (state & sOptimized) != 0;
+	}
+
+	Array<InlineCache *> *LazyCode::inlineCaches() {
+		if (caches)
+			return new (this) Array<InlineCache *>(*caches);
+		else
+			return new (this) Array<InlineCache *>();
+	}
+
 	void LazyCode::newRef() {
 		if (!binary)
 			createRedirect();
@@ -182,6 +253,187 @@ namespace storm {
 			toUpdate->set(binary);
 	}
 
+	code::Listing *LazyCode::generateSource() {
+		if (inlined)
+			return inlined->source;
+		else
+			return generate()->call()->l;
+	}
+
+	Bool LazyCode::loadCached() {
+		CodeCache *cache = engine().codeCache();
+		if (inlined || !cache->enabled())
+			return false;
+
+		code::Binary *loaded = cache->load(owner);
+		if (!loaded)
+			return false;
+
+		binary = loaded;
+		if (toUpdate)
+			toUpdate->set(binary);
+
+		// The cache only contains optimized code. Keep 'generate' in case the listing is needed.
+		state = (state & ~sMask) | sLoaded | sOptimized | sCached;
+		return true;
+	}
+
+	CompileJob *LazyCode::prepare(code::Listing *src) {
+		Array<Function *> *callees = new (this) Array<Function *>();
+		Bool optimize = engine().arena()->optimize;
+
+		// Compile quickly for now, and keep the listing until we optimize it.
+		if (!(state & (sOptimized | sTierUp)) && optimize)
+			return new (this) CompileJob(this, src, instrument(src), callees, true);
+
+		// Replace recursive tail calls and inline small functions, if enabled.
+		code::Listing *compile = src;
+		if (optimize) {
+			if (caches)
+				compile = useInlineCaches(compile, caches);
+			compile = tailCalls(owner, compile, callees);
+			compile = inlineCalls(owner, compile, callees);
+		}
+
+		CompileJob *job = new (this) CompileJob(this, src, compile, callees, false);
+
+		// Store the code in the cache. Small functions are generated again, so that they can be
+		// inlined into other functions.
+		if (callees->empty() && engine().codeCache()->enabled() && !inlineCandidate(src))
+			job->recording = new (this) code::Recording();
+
+		return job;
+	}
+
+	void LazyCode::compileLocal(code::Listing *src) {
+		CompileJob *job = prepare(src);
+		job->run();
+		compiled(job);
+	}
+
+	void LazyCode::compiled(CompileJob *job) {
+		state &= ~sTierUp;
+
+		if (!job->binary) {
+			// Compilation failed. Try again when we're called, so that the error is reported.
+			state = (state & ~sMask) | sUnloaded;
+			return;
+		}
+
+		job->binary->attach();
+		binary = job->binary;
+		if (toUpdate)
+			toUpdate->set(binary);
+
+		if (job->recording)
+			engine().codeCache()->save(owner, job->recording);
+
+		code::Listing *src = job->source;
+		if (job->fast) {
+			sourceData = src;
+			inlined = null;
+		} else {
+			state |= sOptimized;
+			if (job->inlined->any())
+				inlined = new (this) InlineInfo(this, src, job->inlined, binary);
+			else
+				inlined = null;
+
+			// Store the listing unless we don't need it anymore.
+			if ((state & sDiscardSource) && !inlineCandidate(src))
+				sourceData = null;
+			else
+				sourceData = src;
+		}
+
+		state = (state & ~(sMask | sCached)) | sLoaded;
+	}
+
+	// Emit code that decreases 'count' and calls 'notify' with 'me' when it reaches zero. The
+	// counter is decreased so that only a single comparison with zero is needed.
+	//
+	// The emitted code overwrites ptrA and the flags. This is fine after the prolog and before
+	// unconditional backward jumps: listings from the code generation do not keep values in
+	// registers across labels (registers are assigned to variables later, by the backends), and
+	// 'instrument' does not count jumps to instructions that read the flags.
+	static void countTier(code::Listing *to, code::Operand me, code::Operand count, code::Operand notify) {
+		using namespace code;
+
+		Label skip = to->label();
+		*to << mov(ptrA, me);
+		*to << sub(count, natConst(1));
+		*to << jmp(skip, ifNotEqual);
+		*to << fnParam(ptrDesc(to->engine()), ptrA);
+		*to << fnCall(notify, false);
+		*to << skip;
+	}
+
+	code::Listing *LazyCode::instrument(code::Listing *src) {
+		using namespace code;
+
+		Engine &e = engine();
+		Operand count = intRel(ptrA, Offset(OFFSET_OF(LazyCode, counter)));
+
+		// Record receivers of virtual calls.
+		caches = new (this) Array<InlineCache *>();
+		src = recordReceivers(src, caches);
+		Operand notify = e.ref(builtin::lazyCodeTierUp);
+
+		// Find the location of all labels, so that we can find backward jumps.
+		Array<Nat> *labelPos = new (this) Array<Nat>();
+		for (Nat i = 0; i <= src->count(); i++) {
+			if (Array<Label> *labels = src->labels(i)) {
+				for (Nat j = 0; j < labels->count(); j++) {
+					Nat key = labels->at(j).key();
+					while (labelPos->count() <= key)
+						labelPos->push(src->count() + 1);
+					labelPos->at(key) = i;
+				}
+			}
+		}
+
+		Listing *dest = src->createShell();
+		for (Nat i = 0; i < src->count(); i++) {
+			if (Array<Label> *labels = src->labels(i))
+				for (Nat j = 0; j < labels->count(); j++)
+					*dest << labels->at(j);
+
+			Instr *instr = src->at(i);
+			Bool backEdge = false;
+			if (instr->op() == op::jmpBlock) {
+				backEdge = true;
+			} else if (instr->op() == op::jmp) {
+				backEdge = instr->dest().type() == opLabel
+					&& instr->src().condFlag() == ifAlways;
+			}
+
+			if (backEdge) {
+				// Only backward jumps to places that do not use the flags.
+				Nat to = instr->dest().label().key();
+				backEdge = to < labelPos->count() && labelPos->at(to) <= i;
+				if (backEdge) {
+					op::OpCode next = src->at(labelPos->at(to))->op();
+					backEdge = next != op::jmp && next != op::setCond;
+				}
+			}
+
+			// Count loop iterations before the jump, and calls after the prolog.
+			if (backEdge)
+				countTier(dest, objPtr(this), count, notify);
+
+			*dest << instr;
+
+			if (i == 0 && instr->op() == op::prolog)
+				countTier(dest, objPtr(this), count, notify);
+		}
+
+		if (Array<Label> *labels = src->labels(src->count()))
+			for (Nat j = 0; j < labels->count(); j++)
+				*dest << labels->at(j);
+
+		return dest;
+	}
+
 	const void *LazyCode::updateCode(LazyCode *me) {
 		// TODO? Always allocate a new UThread? This will make sure we don't run out of stack for the compiler.
 		Thread *cThread = Compiler::thread(me->engine());
@@ -198,6 +450,42 @@ namespace storm {
 		}
 	}
 
+	void LazyCode::tierUp(LazyCode *me) {
+		// Don't wait for the compilation. The new code is used as soon as it is ready.
+		Thread *cThread = Compiler::thread(me->engine());
+		os::FnCall<void, 1> params = os::fnCall().add(me);
+		os::UThread::spawn(address(&LazyCode::tierUpLocal), true, params, &cThread->thread());
+	}
+
+	void LazyCode::tierUpLocal(LazyCode *me) {
+		// Someone else might have been faster.
+		if ((me->state & sMask) != sLoaded || (me->state & (sOptimized | sTierUp)))
+			return;
+
+		code::Listing *src = (code::Listing *)me->sourceData;
+		if (!src)
+			return;
+
+		// The unoptimized code is used until we are done. Nobody waits for us, so if the
+		// compilation fails, we keep the unoptimized code and try again later. Errors in the code
+		// itself were found when the unoptimized code was compiled.
+		me->state |= sTierUp;
+		CompileJob *job = null;
+		try {
+			job = me->prepare(src);
+			job->run();
+		} catch (...) {
+			job = null;
+		}
+
+		if (job && job->binary) {
+			me->compiled(job);
+		} else {
+			me->state &= ~sTierUp;
+			me->counter = tierThreshold;
+		}
+	}
+
 	const void *LazyCode::updateCodeLocal(LazyCode *me) {
 		while ((me->state & sMask) == sLoading) {
 			// Wait for the other one loading this function.
@@ -214,21 +502,12 @@ namespace storm {
 			me->state = (me->state & ~sMask) | sLoading;
 
 			try {
-				CodeGen *l = me->generate()->call();
-				// Append any data needed.
-				me->setCode(l->l);
-
-				// Store the listing unless we don't need it anymore.
-				if (me->state & sDiscardSource)
-					me->sourceData = null;
-				else
-					me->sourceData = l->l;
+				if (!me->loadCached())
+					me->compileLocal(me->generateSource());
 			} catch (...) {
 				me->state = (me->state & ~sMask) | sUnloaded;
 				throw;
 			}
-
-			me->state = (me->state & ~sMask) | sLoaded;
 		}
 
 		return me->binary->address();
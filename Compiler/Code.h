@@ -13,6 +13,9 @@ namespace storm {
 	STORM_PKG(core.lang);
 
 	class Function;
+	class InlineInfo;
+	class InlineCache;
+	class CompileJob;
 
 	/**
 	 * Code is a block of machine code belonging to a function. This code takes parameters as
@@ -150,6 +153,16 @@ namespace storm {
 
 	/**
 	 * Lazily generated code.
+	 *
+	 * Code is compiled in two tiers. The first time the code is called, it is compiled quickly
+	 * without optimizations, and with counters for the number of calls and loop iterations. When
+	 * the counter reaches a threshold, the code is compiled again with optimizations (including
+	 * inlining) on the Compiler thread, and the new code replaces the old through the RefSource.
+	 * When many functions are compiled at once (see CompilePool), the machine code is produced by
+	 * worker threads.
+	 * The unoptimized code also records the receivers of virtual calls, so that the optimized code
+	 * can call the most likely function directly (see InlineCache).
+	 * If optimizations are disabled in the Arena, code is only compiled once.
 	 */
 	class LazyCode : public GeneratedCode {
 		STORM_CLASS;
@@ -166,9 +179,30 @@ namespace storm {
 		// Discard source.
 		virtual void STORM_FN discardSource();
 
+		// Get the source listing if the code is loaded, for inlining into other functions. Unlike
+		// 'source', this never triggers compilation.
+		MAYBE(code::Listing *) STORM_FN inlineSource();
+
+		// Called when a function inlined in here was replaced, or when a call that was assumed to
+		// be non-virtual became virtual. Re-compiles unoptimized code on the next call.
+		void inlinedChanged();
+
+		// Get the inline caches for virtual calls in here. Empty until the code has been compiled.
+		Array<InlineCache *> *STORM_FN inlineCaches();
+
+		// Is the optimized code in use? Optimized code is compiled in the background, so this
+		// becomes true some time after the threshold for optimization is reached.
+		Bool STORM_FN optimized() const;
+
 		// Called to update code.
 		static const void *CODECALL updateCode(LazyCode *c);
 
+		// Called from unoptimized code when it is time to optimize it.
+		static void CODECALL tierUp(LazyCode *c);
+
+		// Called on the Compiler thread when 'job' has been compiled.
+		void compiled(CompileJob *job);
+
 	protected:
 		// Update reference.
 		virtual void STORM_FN newRef();
@@ -180,12 +214,27 @@ namespace storm {
 		// Shared memory between the 'generate' function and the source listing.
 		UNKNOWN(PTR_GC) void *sourceData;
 
+		// Counter used by unoptimized code. Decreased on each call and on each loop iteration. When
+		// it reaches zero, the code is optimized. The counter is updated without synchronization
+		// from all threads running the code, so decrements may be lost and 'tierUp' may be called
+		// more than once. Both are harmless, as 'tierUpLocal' checks the state before
+		// compiling. After reaching zero, the counter wraps around, so 'tierUp' is not called again
+		// until about 2^32 further decrements, unless 'tierUpLocal' resets it.
+		Nat counter;
+
+		// Inline caches for virtual calls. Created when the unoptimized code is generated.
+		MAYBE(Array<InlineCache *> *) caches;
+
+		// Functions inlined into the current code, if any. If set, code is re-generated from the
+		// listing in here rather than by calling 'generate'.
+		MAYBE(InlineInfo *) inlined;
+
 		// Generate code using this function.
 		inline Fn<CodeGen *> *generate() const { return (Fn<CodeGen *> *)sourceData; }
 
 		// State enum.
 		enum {
-			// Nothing is loaded, 'sourceData' contains 'generate'.
+			// Nothing is loaded, 'sourceData' contains 'generate' unless 'inlined' is set.
 			sUnloaded = 0x00,
 
 			// Code is currently loading. 'sourceData' still contains 'generate'.
@@ -198,7 +247,18 @@ namespace storm {
 			sMask = 0x0F,
 
 			// Is the source listing to be discarded? (OR:ed with others)
-			sDiscardSource = 0x10
+			sDiscardSource = 0x10,
+
+			// Is the code optimized? If set, no further recompilations are made. (OR:ed with others)
+			sOptimized = 0x20,
+
+			// Was the code loaded from the CodeCache? If set, 'sourceData' still contains
+			// 'generate' even though the code is loaded. (OR:ed with others)
+			sCached = 0x40,
+
+			// Is optimized code being compiled in the background? The unoptimized code is used
+			// until the compilation is done. (OR:ed with others)
+			sTierUp = 0x80
 		};
 
 		// Current state.
@@ -207,6 +267,25 @@ namespace storm {
 		// Called to update code from the Compiler thread.
 		static const void *CODECALL updateCodeLocal(LazyCode *c);
 
+		// Called to optimize code from the Compiler thread.
+		static void CODECALL tierUpLocal(LazyCode *c);
+
+		// Get the listing to compile. Either from 'inlined' or by calling 'generate'.
+		code::Listing *generateSource();
+
+		// Try to load the code from the CodeCache. Returns true on success.
+		Bool loadCached();
+
+		// Create a job for compiling 'src'. Applies optimizations if 'sOptimized' or 'sTierUp' is
+		// set, otherwise instruments the code.
+		CompileJob *prepare(code::Listing *src);
+
+		// Compile 'src' on this thread and use it.
+		void compileLocal(code::Listing *src);
+
+		// Add counters for calls and loop iterations to 'src'.
+		code::Listing *instrument(code::Listing *src);
+
 		// Create a redirect chunk of code.
 		void createRedirect();
 
@@ -0,0 +1,401 @@
+#include "stdafx.h"
+#include "CodeCache.h"
+#include "Engine.h"
+#include "Function.h"
+#include "Type.h"
+#include "NamedThread.h"
+#include "NamedSource.h"
+#include "Name.h"
+#include "Core/Str.h"
+#include "Core/StrBuf.h"
+#include "Core/Io/MemStream.h"
+
+namespace storm {
+
+	// Identifies entries and manifests. Changed whenever the format changes.
+	static const Nat entryMagic = 0x53434331; // SCC1
+	static const Nat manifestMagic = 0x53434D32; // SCM2
+
+	// Don't read entries larger than this.
+	static const Nat maxEntrySize = 64 * 1024 * 1024;
+
+	// FNV-1a.
+	static const Word hashStart = 0xCBF29CE484222325ULL;
+
+	static Word hashData(Word hash, const byte *data, Nat size) {
+		for (Nat i = 0; i < size; i++) {
+			hash ^= data[i];
+			hash *= 0x100000001B3ULL;
+		}
+		return hash;
+	}
+
+	static Word hashStr(Word hash, Str *str) {
+		const wchar *s = str->c_str();
+		return hashData(hash, (const byte *)s, Nat(wcslen(s) * sizeof(wchar)));
+	}
+
+	static Word hashFile(Url *file) {
+		IStream *in = file->read();
+		Buffer b = buffer(file->engine(), 64 * 1024);
+		Word hash = hashStart;
+		while (in->more()) {
+			b.filled(0);
+			b = in->read(b);
+			hash = hashData(hash, b.dataPtr(), b.filled());
+		}
+		in->close();
+		return hash;
+	}
+
+	// Hash the names of all files and directories in 'dir'. The order of the children does not matter.
+	static Word hashListing(Url *dir) {
+		Array<Url *> *children = dir->children();
+		Word sum = 0;
+		for (Nat i = 0; i < children->count(); i++)
+			sum += hashStr(hashStart, children->at(i)->format());
+
+		Nat count = children->count();
+		Word hash = hashData(hashStart, (const byte *)&count, sizeof(count));
+		return hashData(hash, (const byte *)&sum, sizeof(sum));
+	}
+
+	static Str *hashName(Engine &e, Word hash) {
+		StrBuf *to = new (e) StrBuf();
+		*to << hex(hash);
+		return to->toS();
+	}
+
+	CodeCache::CodeCache() : dir(null), manifest(null), builtins(null) {
+		hashes = new (this) Map<Str *, Word>();
+		files = new (this) Array<Url *>();
+		dirs = new (this) Array<Url *>();
+		listings = new (this) Map<Str *, Word>();
+		valid = new (this) Map<Str *, Bool>();
+	}
+
+	void CodeCache::open(Url *dir) {
+		// Code generated by other compilers does not belong here.
+		Word compiler = hashFile(executableFileUrl(engine()));
+		this->dir = dir->pushDir(hashName(engine(), compiler));
+
+		if (!this->dir->exists() && !this->dir->createDir()) {
+			WARNING(L"Failed to create the code cache directory. The cache is disabled.");
+			this->dir = null;
+		}
+	}
+
+	void CodeCache::loaded(Array<Url *> *loaded) {
+		if (!dir)
+			return;
+
+		// Hash the files now, so that we know which version was used to generate code.
+		for (Nat i = 0; i < loaded->count(); i++) {
+			Url *file = loaded->at(i);
+			hashes->put(file->format(), hashFile(file));
+			files->push(file);
+
+			// Adding or removing files in the directory may change what names refer to, even if
+			// none of the loaded files change.
+			Url *dir = file->parent();
+			Str *dirPath = dir->format();
+			if (!listings->has(dirPath)) {
+				listings->put(dirPath, hashListing(dir));
+				dirs->push(dir);
+			}
+		}
+
+		manifest = null;
+	}
+
+	Word CodeCache::hash(Url *file) {
+		Str *path = file->format();
+		Map<Str *, Word>::Iter found = hashes->find(path);
+		if (found != hashes->end())
+			return found.v();
+
+		Word result = hashFile(file);
+		hashes->put(path, result);
+		return result;
+	}
+
+	Word CodeCache::listing(Url *dir) {
+		Str *path = dir->format();
+		Map<Str *, Word>::Iter found = listings->find(path);
+		if (found != listings->end())
+			return found.v();
+
+		Word result = hashListing(dir);
+		listings->put(path, result);
+		return result;
+	}
+
+	MAYBE(Str *) CodeCache::key(Function *fn) {
+		Str *name = mangleName(fn->path());
+
+		// Make sure that no other function has the same name.
+		if (lookupMangledNamed(engine().scope(), name) != fn)
+			return null;
+		return name;
+	}
+
+	Url *CodeCache::entry(Str *key) {
+		Str *name = hashName(engine(), hashStr(hashStart, key));
+		return dir->push(TO_S(this, name << S(".code")));
+	}
+
+	Str *CodeCache::currentManifest() {
+		if (manifest)
+			return manifest;
+
+		Word id = hashStart;
+		for (Nat i = 0; i < files->count(); i++) {
+			Word h = hash(files->at(i));
+			id = hashStr(id, files->at(i)->format());
+			id = hashData(id, (const byte *)&h, sizeof(h));
+		}
+		for (Nat i = 0; i < dirs->count(); i++) {
+			Word h = listing(dirs->at(i));
+			id = hashStr(id, dirs->at(i)->format());
+			id = hashData(id, (const byte *)&h, sizeof(h));
+		}
+
+		Str *name = TO_S(this, S("deps-") << hex(id));
+		Url *file = dir->push(name);
+		if (!file->exists()) {
+			OStream *out = file->write();
+			out->writeNat(manifestMagic);
+			out->writeNat(files->count());
+			for (Nat i = 0; i < files->count(); i++) {
+				files->at(i)->format()->write(out);
+				out->writeWord(hash(files->at(i)));
+			}
+			out->writeNat(dirs->count());
+			for (Nat i = 0; i < dirs->count(); i++) {
+				dirs->at(i)->format()->write(out);
+				out->writeWord(listing(dirs->at(i)));
+			}
+			out->close();
+		}
+
+		// We just computed the hashes.
+		valid->put(name, true);
+		manifest = name;
+		return name;
+	}
+
+	Bool CodeCache::upToDate(Str *name) {
+		Map<Str *, Bool>::Iter found = valid->find(name);
+		if (found != valid->end())
+			return found.v();
+
+		Bool ok = false;
+		try {
+			IStream *in = dir->push(name)->read();
+			ok = in->readNat() == manifestMagic;
+
+			Nat count = ok ? in->readNat() : 0;
+			for (Nat i = 0; i < count && ok; i++) {
+				Str *path = Str::read(in);
+				Word expected = in->readWord();
+				ok = hash(parsePath(path)) == expected;
+			}
+
+			count = ok ? in->readNat() : 0;
+			for (Nat i = 0; i < count && ok; i++) {
+				Str *path = Str::read(in);
+				Word expected = in->readWord();
+				ok = listing(parsePath(path)) == expected;
+			}
+			in->close();
+		} catch (...) {
+			// Missing or removed files.
+			ok = false;
+		}
+
+		valid->put(name, ok);
+		return ok;
+	}
+
+	Map<Str *, code::RefSource *> *CodeCache::builtinSources() {
+		if (builtins)
+			return builtins;
+
+		builtins = new (this) Map<Str *, code::RefSource *>();
+		for (Nat i = 0; i < builtin::count; i++) {
+			code::RefSource *source = engine().ref(builtin::BuiltIn(i)).source();
+			builtins->put(source->title(), source);
+		}
+		return builtins;
+	}
+
+	MAYBE(code::RefSource *) CodeCache::resolve(Nat kind, Str *name, Nat subtype) {
+		if (kind == sourceBuiltin) {
+			Map<Str *, code::RefSource *> *b = builtinSources();
+			if (b->has(name))
+				return b->get(name);
+			return null;
+		}
+
+		if (kind != sourceNamed)
+			return null;
+
+		Named *found = lookupMangledNamed(engine().scope(), name);
+		if (Function *f = as<Function>(found)) {
+			if (subtype == 0)
+				return f->ref().source();
+			if (subtype == 'd')
+				return f->directRef().source();
+		} else if (Type *t = as<Type>(found)) {
+			if (subtype == 0)
+				return t->typeRef().source();
+		} else if (NamedThread *t = as<NamedThread>(found)) {
+			if (subtype == 0)
+				return t->ref().source();
+		}
+
+		return null;
+	}
+
+	Bool CodeCache::write(OStream *to, code::RefSource *source) {
+		Nat kind;
+		Str *name;
+		Nat subtype = 0;
+
+		if (NamedSource *named = as<NamedSource>(source)) {
+			kind = sourceNamed;
+			name = mangleName(named->named()->path());
+			subtype = named->type().codepoint();
+		} else {
+			kind = sourceBuiltin;
+			name = source->title();
+		}
+
+		// Make sure we find the same source when we read the entry.
+		if (resolve(kind, name, subtype) != source)
+			return false;
+
+		to->writeByte(Byte(kind));
+		name->write(to);
+		to->writeNat(subtype);
+		return true;
+	}
+
+	MAYBE(code::RefSource *) CodeCache::read(IStream *from) {
+		Nat kind = from->readByte();
+		Str *name = Str::read(from);
+		Nat subtype = from->readNat();
+		return resolve(kind, name, subtype);
+	}
+
+	void CodeCache::save(Function *fn, code::Recording *record) {
+		if (!dir || !record->portable)
+			return;
+
+		try {
+			Str *k = key(fn);
+			if (!k)
+				return;
+
+			// Produce the entry in memory, so that we don't leave a partial entry behind if some
+			// RefSource can not be named.
+			MemOStream *out = new (this) MemOStream();
+			out->writeNat(entryMagic);
+			k->write(out);
+			currentManifest()->write(out);
+
+			out->writeNat(record->size);
+			out->writeNat(record->refs);
+			out->writeNat(record->metaOffset);
+
+			out->writeNat(record->blocks->count());
+			for (Nat i = 0; i < record->blocks->count(); i++)
+				out->writeNat(record->blocks->at(i));
+
+			out->writeNat(record->sources->count());
+			for (Nat i = 0; i < record->sources->count(); i++)
+				if (!write(out, record->sources->at(i)))
+					return;
+
+			out->writeNat(record->ops.filled());
+			out->write(record->ops);
+			out->writeWord(hashData(hashStart, record->ops.dataPtr(), record->ops.filled()));
+
+			OStream *file = entry(k)->write();
+			file->write(out->buffer());
+			file->close();
+		} catch (...) {
+			// The cache is only an optimization. Failing to write it is not an error.
+		}
+	}
+
+	MAYBE(code::Recording *) CodeCache::readEntry(IStream *from, Str *key) {
+		if (from->readNat() != entryMagic)
+			return null;
+
+		// Different functions may share the file.
+		if (!(*Str::read(from) == *key))
+			return null;
+
+		if (!upToDate(Str::read(from)))
+			return null;
+
+		code::Recording *r = new (this) code::Recording();
+		r->size = from->readNat();
+		r->refs = from->readNat();
+		r->metaOffset = from->readNat();
+
+		Nat blocks = from->readNat();
+		for (Nat i = 0; i < blocks; i++)
+			r->blocks->push(from->readNat());
+
+		Nat sources = from->readNat();
+		for (Nat i = 0; i < sources; i++) {
+			code::RefSource *source = read(from);
+			if (!source)
+				return null;
+			r->sources->push(source);
+		}
+
+		Nat size = from->readNat();
+		if (size > maxEntrySize)
+			return null;
+
+		r->ops = from->readAll(size);
+		if (r->ops.filled() != size)
+			return null;
+
+		if (from->readWord() != hashData(hashStart, r->ops.dataPtr(), r->ops.filled()))
+			return null;
+
+		return r;
+	}
+
+	MAYBE(code::Binary *) CodeCache::load(Function *fn) {
+		if (!dir)
+			return null;
+
+		try {
+			Str *k = key(fn);
+			if (!k)
+				return null;
+
+			Url *file = entry(k);
+			if (!file->exists())
+				return null;
+
+			IStream *in = file->read();
+			code::Recording *r = readEntry(in, k);
+			in->close();
+
+			if (!r)
+				return null;
+
+			return new (this) code::Binary(engine().arena(), r);
+		} catch (...) {
+			// Truncated or malformed entries are simply not used.
+			return null;
+		}
+	}
+
+}
@@ -0,0 +1,120 @@
+#pragma once
+#include "Core/Array.h"
+#include "Core/Map.h"
+#include "Core/Io/Url.h"
+#include "Code/Binary.h"
+#include "Code/Recording.h"
+
+namespace storm {
+	STORM_PKG(core.lang);
+
+	class Function;
+
+	/**
+	 * Cache of machine code on disk, so that functions do not need to be parsed and compiled again
+	 * each time the system is started.
+	 *
+	 * The cache stores Recordings of the optimized code of functions, along with the names of the
+	 * RefSources they refer to. When a function is about to be compiled, LazyCode first asks the
+	 * cache for an entry, and replays it if the entry is still valid.
+	 *
+	 * Entries are stored in a directory named after a hash of the compiler executable, so that
+	 * code generated by other versions of the compiler is never used. The code of a function
+	 * depends on other things than its own source file, for example the layout of types declared
+	 * elsewhere. Because of this, each entry refers to a manifest that contains the hashes of all
+	 * source files that were loaded when the entry was created, and of the contents of the
+	 * directories they were loaded from. An entry is only used if none of those files have changed,
+	 * and no files have been added to or removed from the directories, since a new file may
+	 * contain for example a new overload that changes what a name refers to.
+	 *
+	 * Only code that can be described entirely in terms of RefSources that can be found by name
+	 * is stored (see Recording). That excludes, for example, code that contains string literals
+	 * or that contains inlined functions.
+	 */
+	class CodeCache : public ObjectOn<Compiler> {
+		STORM_CLASS;
+	public:
+		// Create. The cache is disabled until 'open' is called.
+		STORM_CTOR CodeCache();
+
+		// Store the cache in 'dir'.
+		void STORM_FN open(Url *dir);
+
+		// Is the cache enabled?
+		inline Bool STORM_FN enabled() const { return dir != null; }
+
+		// Called when a package has loaded 'files'.
+		void STORM_FN loaded(Array<Url *> *files);
+
+		// Create code for 'fn' from the cache. Returns null if there is no valid entry.
+		MAYBE(code::Binary *) load(Function *fn);
+
+		// Save the code in 'record' as the code for 'fn', if possible.
+		void save(Function *fn, code::Recording *record);
+
+	private:
+		// Directory for the current version of the compiler. Null if disabled.
+		MAYBE(Url *) dir;
+
+		// Hashes of the contents of files, by path.
+		Map<Str *, Word> *hashes;
+
+		// All files loaded so far.
+		Array<Url *> *files;
+
+		// All directories that files were loaded from.
+		Array<Url *> *dirs;
+
+		// Hashes of the names of the children of directories, by path.
+		Map<Str *, Word> *listings;
+
+		// Name of the manifest for 'files'. Null if it has not been written yet.
+		MAYBE(Str *) manifest;
+
+		// Manifests known to be up to date.
+		Map<Str *, Bool> *valid;
+
+		// RefSources in the Engine, by title. Created when needed.
+		MAYBE(Map<Str *, code::RefSource *> *) builtins;
+
+		// Kinds of RefSources in entries.
+		enum {
+			sourceBuiltin,
+			sourceNamed,
+		};
+
+		// Get the hash of 'file'.
+		Word hash(Url *file);
+
+		// Get the hash of the names of the children of 'dir'.
+		Word listing(Url *dir);
+
+		// Get the key for 'fn'. Returns null if 'fn' can not be found by its name.
+		MAYBE(Str *) key(Function *fn);
+
+		// Get the file used for the entry 'key'.
+		Url *entry(Str *key);
+
+		// Get the manifest for the currently loaded files, writing it if necessary.
+		Str *currentManifest();
+
+		// Check if the manifest 'name' is up to date.
+		Bool upToDate(Str *name);
+
+		// Get the built-in RefSources.
+		Map<Str *, code::RefSource *> *builtinSources();
+
+		// Write a RefSource to 'to'. Returns false if it can not be resolved when it is read.
+		Bool write(OStream *to, code::RefSource *source);
+
+		// Read a RefSource written by 'write'. Returns null if it does not exist anymore.
+		MAYBE(code::RefSource *) read(IStream *from);
+
+		// Find a RefSource.
+		MAYBE(code::RefSource *) resolve(Nat kind, Str *name, Nat subtype);
+
+		// Read an entry. Returns null if it is not valid.
+		MAYBE(code::Recording *) readEntry(IStream *from, Str *key);
+	};
+
+}
@@ -271,6 +271,92 @@ namespace storm {
 		return call;
 	}
 
+	// Allocate an object of 'type' from the thread-local allocation buffer of the GC, as described
+	// by 'a'. Calls 'builtin::alloc' if the buffer is exhausted, if the buffer belongs to someone
+	// else, or if the type needs more attention from the GC (e.g. finalizers). Since GcTypes are
+	// created lazily, and finalizers may be added to them later on, this is checked at runtime.
+	static void allocInline(CodeGen *s, Type *type, const GcInlineAlloc &a, code::Var to) {
+		using namespace code;
+
+		Engine &e = type->engine;
+		Listing *l = s->l;
+
+		// Only registers are used, so that no frame variables are needed for each allocation:
+		// ptrA is the buffer, ptrB the end (and later the start) of the allocation and ptrC the GcType.
+		Label zero = l->label();
+		Label slow = l->label();
+		Label done = l->label();
+		Operand buffer = ptrRel(noReg, Offset(Int(a.bufferTls)));
+		Operand init = ptrRel(ptrA, Offset(Int(a.initOffset)));
+		Operand alloc = ptrRel(ptrA, Offset(Int(a.allocOffset)));
+		Operand limit = ptrRel(ptrA, Offset(Int(a.limitOffset)));
+		Operand stride = ptrRel(ptrC, Offset(OFFSET_OF(GcType, stride)));
+
+		// Is the buffer ours?
+		*l << threadLocal();
+		*l << mov(ptrA, ptrRel(noReg, Offset(Int(a.ownerTls))));
+		*l << mov(ptrC, e.ref(builtin::inlineAllocKey));
+		*l << cmp(ptrA, ptrRel(ptrC, Offset()));
+		*l << jmp(slow, ifNotEqual);
+
+		// Check the GcType.
+		*l << mov(ptrC, type->typeRef());
+		*l << mov(ptrC, ptrRel(ptrC, Type::gcTypeOffset()));
+		*l << cmp(ptrC, ptrConst(0));
+		*l << jmp(slow, ifEqual);
+		*l << cmp(ptrRel(ptrC, Offset(OFFSET_OF(GcType, kind))), ptrConst(Nat(GcType::tFixedObj)));
+		*l << jmp(slow, ifNotEqual);
+		*l << cmp(ptrRel(ptrC, Offset(OFFSET_OF(GcType, finalizer))), ptrConst(0));
+		*l << jmp(slow, ifNotEqual);
+
+		// Compute the size. Only 64-bit systems support inline allocations, so we can use 'sWord'
+		// to get a 64-bit mask.
+		*l << mov(ptrB, stride);
+		*l << add(ptrB, ptrConst(Nat(a.headerSize + a.align - 1)));
+		*l << band(asSize(ptrB, Size::sWord), wordConst(~Word(a.align - 1)));
+
+		// Reserve memory.
+		*l << threadLocal();
+		*l << mov(ptrA, buffer);
+		*l << add(ptrB, alloc);
+		*l << cmp(ptrB, limit);
+		*l << jmp(slow, ifAbove);
+		*l << mov(alloc, ptrB);
+
+		// Clear it, starting from the end. The size is computed again, since we ran out of registers.
+		*l << mov(ptrA, stride);
+		*l << add(ptrA, ptrConst(Nat(a.headerSize + a.align - 1)));
+		*l << band(asSize(ptrA, Size::sWord), wordConst(~Word(a.align - 1)));
+		*l << zero;
+		*l << sub(ptrB, ptrConst(Offset::sPtr));
+		*l << mov(ptrRel(ptrB, Offset()), ptrConst(0));
+		*l << sub(ptrA, ptrConst(Offset::sPtr));
+		*l << cmp(ptrA, ptrConst(0));
+		*l << jmp(zero, ifNotEqual);
+
+		// Set the header.
+		*l << mov(ptrRel(ptrB, Offset()), ptrC);
+		*l << add(ptrB, ptrConst(Nat(a.headerSize)));
+		*l << mov(to, ptrB);
+
+		// Commit. If the GC interfered, it decides which object to use.
+		*l << threadLocal();
+		*l << mov(ptrA, buffer);
+		*l << mov(ptrC, alloc);
+		*l << mov(init, ptrC);
+		*l << cmp(limit, ptrConst(0));
+		*l << jmp(done, ifNotEqual);
+		*l << fnParam(e.ptrDesc(), type->typeRef());
+		*l << fnParam(e.ptrDesc(), to);
+		*l << fnCall(e.ref(builtin::allocTrapped), false, e.ptrDesc(), to);
+		*l << jmp(done);
+
+		*l << slow;
+		*l << fnParam(e.ptrDesc(), type->typeRef());
+		*l << fnCall(e.ref(builtin::alloc), false, e.ptrDesc(), to);
+		*l << done;
+	}
+
 	void allocObject(CodeGen *s, Function *ctor, Array<code::Operand> *params, code::Var to) {
 		using namespace code;
 
@@ -279,8 +365,13 @@ namespace storm {
 
 		Engine &e = ctor->engine();
 
-		*s->l << fnParam(e.ptrDesc(), type->typeRef());
-		*s->l << fnCall(e.ref(builtin::alloc), false, e.ptrDesc(), to);
+		GcInlineAlloc a = e.gc.inlineAlloc();
+		if (a.supported) {
+			allocInline(s, type, a, to);
+		} else {
+			*s->l << fnParam(e.ptrDesc(), type->typeRef());
+			*s->l << fnCall(e.ref(builtin::alloc), false, e.ptrDesc(), to);
+		}
 
 		CodeResult *r = new (s) CodeResult();
 		params = new (s) Array<code::Operand>(*params);
@@ -379,6 +470,41 @@ namespace storm {
 		return new (e) Binary(e.arena(), l);
 	}
 
+	// Describe 'v' for the key of a shared call thunk. Returns false if the thunk can not be shared.
+	static bool thunkKey(StrBuf *to, Value v) {
+		code::TypeDesc *desc = v.desc(to->engine());
+		if (!as<code::PrimitiveDesc>(desc) && !as<code::SimpleDesc>(desc))
+			return false;
+
+		*to << desc << (v.returnInReg() ? S(";") : S("&;"));
+		return true;
+	}
+
+	code::RefSource *sharedCallThunk(Value result, Array<Value> *params) {
+		Engine &e = params->engine();
+
+		// The thunk only depends on the layout of the parameters and the result.
+		StrBuf *key = new (e) StrBuf();
+		if (!thunkKey(key, result))
+			return null;
+		*key << S("(");
+		for (Nat i = 0; i < params->count(); i++)
+			if (!thunkKey(key, params->at(i)))
+				return null;
+		*key << S(")");
+
+		Str *k = key->toS();
+		Map<Str *, code::RefSource *> *thunks = e.callThunks();
+		Map<Str *, code::RefSource *>::Iter found = thunks->find(k);
+		if (found != thunks->end())
+			return found.v();
+
+		code::RefSource *thunk = new (e) code::StrRefSource(TO_S(e, S("call thunk ") << k));
+		thunk->set(callThunk(result, params));
+		thunks->put(k, thunk);
+		return thunk;
+	}
+
 
 	Array<code::Operand> *spillRegisters(CodeGen *s, Array<code::Operand> *params) {
 		Bool hasReg = false;
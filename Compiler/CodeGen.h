@@ -191,7 +191,8 @@ namespace storm {
 	// Allocate and fill a FnCall object, copying arguments depending on 'copy'.
 	code::Var STORM_FN createFnCall(CodeGen *to, Array<Value> *formals, Array<code::Operand> *actuals, Bool copy);
 
-	// Allocate an object on the heap. Store it in variable 'to'.
+	// Allocate an object on the heap. Store it in variable 'to'. If the GC supports it, the object
+	// is allocated inline from a thread-local buffer (see GcInlineAlloc).
 	void STORM_FN allocObject(CodeGen *s, Function *ctor, Array<code::Operand> *params, code::Var to);
 	code::Var STORM_FN allocObject(CodeGen *s, Function *ctor, Array<code::Operand> *params);
 
@@ -201,6 +202,11 @@ namespace storm {
 	// Create a thunk for a function usable with function pointers. This thunk is compatible with 'os::CallThunk'
 	code::Binary *STORM_FN callThunk(Value result, Array<Value> *params);
 
+	// Get a thunk created by 'callThunk' that is shared with all other functions with the same
+	// signature, as long as the signature does not contain types with copy constructors or
+	// destructors. Returns null if the thunk can not be shared.
+	MAYBE(code::RefSource *) STORM_FN sharedCallThunk(Value result, Array<Value> *params);
+
 	// Make sure all parameters in a parameter list reside in memory, moving any values stored in
 	// registers into memory as necessary. Returns either the original parameter list or a modified
 	// version if at least one parameter was flushed to memory.
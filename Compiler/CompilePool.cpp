@@ -0,0 +1,125 @@
+#include "stdafx.h"
+#include "CompilePool.h"
+#include "Engine.h"
+#include "Code.h"
+
+#ifdef POSIX
+#include <unistd.h>
+#endif
+
+namespace storm {
+
+	CompileJob::CompileJob(LazyCode *owner, code::Listing *source, code::Listing *compile, Array<Function *> *inlined, Bool fast)
+		: owner(owner), source(source), compile(compile), inlined(inlined), fast(fast),
+		  recording(null), binary(null), error(null) {}
+
+	void CompileJob::run() {
+		binary = code::Binary::detached(engine().arena(), compile, fast, recording);
+	}
+
+
+	// Maximum number of workers. Compilations are usually short, so more threads than this mostly
+	// increase contention in the GC.
+	static const Nat maxWorkers = 8;
+
+	static Nat processors() {
+#if defined(WINDOWS)
+		SYSTEM_INFO info;
+		GetSystemInfo(&info);
+		return Nat(info.dwNumberOfProcessors);
+#elif defined(POSIX)
+		long count = sysconf(_SC_NPROCESSORS_ONLN);
+		return count > 0 ? Nat(count) : 1;
+#else
+		return 1;
+#endif
+	}
+
+	CompilePool::CompilePool() : next(0), depth(0), pending(0), error(null) {
+		Nat count = min(max(processors(), Nat(1)) - 1, maxWorkers);
+		workers = new (this) Array<Thread *>();
+		for (Nat i = 0; i < count; i++)
+			workers->push(new (this) Thread());
+
+		done = new (this) Event();
+		done->set();
+	}
+
+	void CompilePool::begin() {
+		depth++;
+	}
+
+	void CompilePool::end() {
+		if (depth == 0)
+			return;
+		if (--depth > 0)
+			return;
+
+		done->wait();
+
+		if (Exception *e = error) {
+			error = null;
+			throw e;
+		}
+	}
+
+	void CompilePool::shutdown() {
+		done->wait();
+		workers = new (this) Array<Thread *>();
+		next = 0;
+	}
+
+	Bool CompilePool::parallel() const {
+		return depth > 0 && workers->any();
+	}
+
+	void CompilePool::compile(CompileJob *job) {
+		if (workers->empty()) {
+			// Nobody to help us.
+			job->run();
+			job->owner->compiled(job);
+			return;
+		}
+
+		if (pending++ == 0)
+			done->clear();
+
+		Thread *worker = workers->at(next);
+		next = (next + 1) % workers->count();
+
+		os::FnCall<void, 1> params = os::fnCall().add(job);
+		os::UThread::spawn(address(&CompilePool::runJob), true, params, &worker->thread());
+	}
+
+	void CompilePool::runJob(CompileJob *job) {
+		// Errors are reported by 'end' on the Compiler thread. The code is compiled again when it
+		// is called, so the error is reported to the caller as well.
+		try {
+			job->run();
+		} catch (const Exception *e) {
+			job->binary = null;
+			job->error = const_cast<Exception *>(e);
+		} catch (const ::Exception &e) {
+			job->binary = null;
+			job->error = new (job) InternalError(new (job) Str(e.what().c_str()));
+		} catch (...) {
+			job->binary = null;
+			job->error = new (job) InternalError(S("Unknown error while compiling code."));
+		}
+
+		Thread *cThread = Compiler::thread(job->engine());
+		os::FnCall<void, 1> params = os::fnCall().add(job);
+		os::UThread::spawn(address(&CompilePool::finishJob), true, params, &cThread->thread());
+	}
+
+	void CompilePool::finishJob(CompileJob *job) {
+		CompilePool *me = job->engine().compilePool();
+		if (job->error && !me->error)
+			me->error = job->error;
+		job->owner->compiled(job);
+
+		if (--me->pending == 0)
+			me->done->set();
+	}
+
+}
@@ -0,0 +1,118 @@
+#pragma once
+#include "Core/Array.h"
+#include "Core/Thread.h"
+#include "Core/Event.h"
+#include "Code/Listing.h"
+#include "Code/Binary.h"
+#include "Code/Recording.h"
+
+namespace storm {
+	STORM_PKG(core.lang);
+
+	class Function;
+	class LazyCode;
+
+	/**
+	 * A listing that is to be translated into machine code for a LazyCode.
+	 */
+	class CompileJob : public ObjectOn<Compiler> {
+		STORM_CLASS;
+	public:
+		// Create.
+		CompileJob(LazyCode *owner, code::Listing *source, code::Listing *compile, Array<Function *> *inlined, Bool fast);
+
+		// Owner.
+		LazyCode *owner;
+
+		// Listing produced by the code generation.
+		code::Listing *source;
+
+		// Listing to translate. 'source' with inlining or instrumentation applied.
+		code::Listing *compile;
+
+		// Functions inlined into 'compile'.
+		Array<Function *> *inlined;
+
+		// Compile quickly, without optimizations?
+		Bool fast;
+
+		// Record the output here, if set, so that it can be stored in the CodeCache.
+		MAYBE(code::Recording *) recording;
+
+		// The result. Created detached. Null if the translation failed.
+		MAYBE(code::Binary *) binary;
+
+		// The error that made the translation fail, if any.
+		MAYBE(Exception *) error;
+
+		// Translate 'compile' on the current thread.
+		void run();
+	};
+
+
+	/**
+	 * A pool of threads that translate listings into machine code in parallel.
+	 *
+	 * The Compiler thread still generates the listings, as that requires name resolution. Only the
+	 * translation into machine code (transforms, layout and encoding) is done on the
+	 * workers. References in the generated code are attached and the result is published through
+	 * the RefSource of the function on the Compiler thread (see LazyCode).
+	 *
+	 * The pool is used inside batches, for example when an entire package is compiled through
+	 * 'NameSet::compile'. Code that is compiled due to a call is still compiled immediately, as the
+	 * caller needs to wait for it anyway.
+	 */
+	class CompilePool : public ObjectOn<Compiler> {
+		STORM_CLASS;
+	public:
+		// Create. Uses one thread less than the number of processors, so there are no workers on
+		// systems with a single processor.
+		STORM_CTOR CompilePool();
+
+		// Start a batch of compilations. Batches may be nested.
+		void STORM_FN begin();
+
+		// End a batch. When the outermost batch ends, waits for all compilations to finish. If any
+		// of them failed, the first error is thrown from here. The failed functions are compiled
+		// again when they are called.
+		void STORM_FN end();
+
+		// Wait for all compilations to finish, and release the workers. Called when the Engine is
+		// destroyed. The threads exit when the Thread objects are collected. After this, all
+		// compilations are made on the calling thread.
+		void shutdown();
+
+		// Shall compilations be made on the workers? True inside a batch if there are any workers.
+		Bool STORM_FN parallel() const;
+
+		// Translate 'job' on one of the workers. When done, 'LazyCode::compiled' is called on the
+		// Compiler thread.
+		void compile(CompileJob *job);
+
+	private:
+		// Worker threads.
+		Array<Thread *> *workers;
+
+		// Next worker to use.
+		Nat next;
+
+		// Batch depth.
+		Nat depth;
+
+		// Number of jobs that are not yet finished.
+		Nat pending;
+
+		// Set when there are no pending jobs.
+		Event *done;
+
+		// First error from a job in the current batch.
+		MAYBE(Exception *) error;
+
+		// Called on a worker thread.
+		static void CODECALL runJob(CompileJob *job);
+
+		// Called on the Compiler thread when a job is finished.
+		static void CODECALL finishJob(CompileJob *job);
+	};
+
+}
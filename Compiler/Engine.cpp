@@ -5,6 +5,8 @@
 #include "Package.h"
 #include "Code.h"
 #include "Function.h"
+#include "CompilePool.h"
+#include "CodeCache.h"
 #include "Core/Hash.h"
 #include "Core/Thread.h"
 #include "Core/Str.h"
@@ -146,11 +148,12 @@ namespace storm {
 	};
 
 
-	Engine::Engine(const Path &root, ThreadMode mode, void *stackBase) :
+	Engine::Engine(const Path &root, ThreadMode mode, void *stackBase, const Options &options) :
 		id(atomicIncrement(engineId)),
-		gc(defaultArena, defaultFinalizer),
+		gc(defaultArena, defaultFinalizer, options.nearCode),
 		threadGroup(util::memberVoidFn(this, &Engine::attachThread), util::memberVoidFn(this, &Engine::detachThread)),
 		world(gc),
+		options(options),
 		objRoot(null),
 		ioThread(null),
 		stackInfo(gc) {
@@ -209,6 +212,10 @@ namespace storm {
 		advance(bootShutdown);
 		libs.shutdown();
 
+		// Let the workers finish. They exit when their threads are collected below.
+		if (o.compilePool)
+			o.compilePool->shutdown();
+
 		// Perform a GC now, to execute as many finalizers as possible now. We might actually need
 		// to compile some destructors during shutdown...
 		gc.collect();
@@ -304,8 +311,11 @@ namespace storm {
 	}
 
 	code::Arena *Engine::arena() {
-		if (!o.arena)
+		if (!o.arena) {
 			o.arena = code::arena(*this);
+			o.arena->peephole = options.peephole;
+			o.arena->optimize = options.optimize;
+		}
 
 		return o.arena;
 	}
@@ -317,6 +327,27 @@ namespace storm {
 		return o.vtableCalls;
 	}
 
+	CompilePool *Engine::compilePool() {
+		if (!o.compilePool)
+			o.compilePool = new (*this) CompilePool();
+
+		return o.compilePool;
+	}
+
+	CodeCache *Engine::codeCache() {
+		if (!o.codeCache)
+			o.codeCache = new (*this) CodeCache();
+
+		return o.codeCache;
+	}
+
+	Map<Str *, code::RefSource *> *Engine::callThunks() {
+		if (!o.callThunks)
+			o.callThunks = new (*this) Map<Str *, code::RefSource *>();
+
+		return o.callThunks;
+	}
+
 	static const GcType voidArrayType = {
 		GcType::tArray,
 		null,
@@ -358,8 +389,17 @@ namespace storm {
 		return code::Ref(*r);
 	}
 
+	// Called for every object allocated from generated code. Goes directly to the GC rather than
+	// through 'runtime::allocObject' to keep the number of calls on this path at a minimum.
 	static void *allocType(Type *t) {
-		return runtime::allocObject(0, t);
+		const GcType *g = t->gcType();
+		assert(g->type == t, L"Invalid type reference found in allocation from generated code.");
+		return t->engine.gc.alloc(g);
+	}
+
+	// Called when an object allocated inline in generated code could not be committed.
+	static void *allocTrapped(Type *t, void *object) {
+		return t->engine.gc.inlineTrapped(t->gcType(), object);
 	}
 
 	static void *allocArray(Type *t, size_t count) {
@@ -403,12 +443,18 @@ namespace storm {
 			return arena()->externalSource(S("engine"), this);
 		case builtin::lazyCodeUpdate:
 			return FNREF(LazyCode::updateCode);
+		case builtin::lazyCodeTierUp:
+			return FNREF(LazyCode::tierUp);
 		case builtin::ruleThrow:
 			return FNREF(syntax::Node::throwError);
 		case builtin::alloc:
 			return FNREF(allocType);
 		case builtin::allocArray:
 			return FNREF(allocArray);
+		case builtin::allocTrapped:
+			return FNREF(allocTrapped);
+		case builtin::inlineAllocKey:
+			return arena()->externalSource(S("inlineAllocKey"), (const void *)gc.inlineAlloc().key);
 		case builtin::as:
 			return FNREF(stormAs);
 		case builtin::VTableAllocOffset:
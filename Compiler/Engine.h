@@ -26,6 +26,8 @@ namespace storm {
 	class TextInput;
 	class TextOutput;
 	class Visibility;
+	class CompilePool;
+	class CodeCache;
 
 	/**
 	 * Defines the root object of the compiler. This object contains everything needed by the
@@ -57,13 +59,28 @@ namespace storm {
 			reuseMain,
 		};
 
+		// Options that need to be known when the engine is created, since they affect code that is
+		// generated while booting.
+		struct Options {
+			Options() : peephole(true), optimize(true), nearCode(true) {}
+
+			// Apply peephole optimizations? See code::Arena::peephole.
+			bool peephole;
+
+			// Apply backend-independent optimizations? See code::Arena::optimize.
+			bool optimize;
+
+			// Try to place generated code close to the executable? See Gc::Gc.
+			bool nearCode;
+		};
+
 		// Create the engine.
 		// 'root' is the location of the root package directory on disk. The package 'core' is
 		// assumed to be found as a subdirectory of the given root path.
 		// 'stackBase' is the base of the current thread's stack. Eg. the address of argc and/or
 		// argv or some other variable allocated on the stack near 'main'.
 		// TODO: Do not depend on Util/Path!
-		Engine(const Path &root, ThreadMode mode, void *stackBase);
+		Engine(const Path &root, ThreadMode mode, void *stackBase, const Options &options = Options());
 
 		// Destroy. This will wait until all threads have terminated properly.
 		~Engine();
@@ -149,6 +166,16 @@ namespace storm {
 		// VTable call stubs.
 		VTableCalls *vtableCalls();
 
+		// Threads used to compile code in parallel.
+		CompilePool *compilePool();
+
+		// Cache of compiled code on disk.
+		CodeCache *codeCache();
+
+		// Call thunks shared between functions with the same signature, by signature. See
+		// 'sharedCallThunk' in CodeGen.h.
+		Map<Str *, code::RefSource *> *callThunks();
+
 		// Get the one and only Handle object for void.
 		const Handle &voidHandle();
 
@@ -208,6 +235,9 @@ namespace storm {
 		// How far along in the boot process?
 		BootStatus bootStatus;
 
+		// Options given at creation.
+		Options options;
+
 		/**
 		 * GC:d objects.
 		 */
@@ -233,6 +263,15 @@ namespace storm {
 			// VTableCalls.
 			code::VTableCalls *vtableCalls;
 
+			// CompilePool.
+			CompilePool *compilePool;
+
+			// CodeCache.
+			CodeCache *codeCache;
+
+			// Shared call thunks.
+			Map<Str *, code::RefSource *> *callThunks;
+
 			// References.
 			code::RefSource *refs[builtin::count];
 
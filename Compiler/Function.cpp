@@ -542,6 +542,11 @@ namespace storm {
 	code::RefSource *Function::threadThunk() {
 		using namespace code;
 
+		if (threadThunkRef)
+			return threadThunkRef;
+
+		// Functions with the same signature can usually use the same thunk.
+		threadThunkRef = sharedCallThunk(result, params);
 		if (threadThunkRef)
 			return threadThunkRef;
 
@@ -0,0 +1,217 @@
+#include "stdafx.h"
+#include "GcInfo.h"
+#include "Engine.h"
+#include "Core/StrBuf.h"
+#include "Type.h"
+#include "Core/Io/Utf8Text.h"
+#include "Gc/Telemetry.h"
+#include "Utils/StackInfoSet.h"
+
+namespace storm {
+
+	GcCollection::GcCollection()
+		: generation(0), pause(true), scanned(0), copied(0), promoted(0), freed(0), pinnedChunks(0) {}
+
+	StrBuf &operator <<(StrBuf &to, GcCollection c) {
+		to << S("generation ") << c.generation << S(": ") << c.duration;
+		to << (c.pause ? S(", ") : S(" (incremental), "));
+		to << c.scanned << S(" scanned, ") << c.copied << S(" copied, ");
+		to << c.promoted << S(" promoted, ") << c.freed << S(" freed, ");
+		to << c.pinnedChunks << S(" pinned chunks");
+		return to;
+	}
+
+
+	// Number of buckets in a histogram, and the size of the first one in us.
+	static const Nat histogramBuckets = 16;
+	static const Long histogramFirst = 64;
+
+	GcHistogram::GcHistogram() {
+		buckets = new (this) Array<Nat>(histogramBuckets, 0);
+	}
+
+	void GcHistogram::add(Duration pause) {
+		Nat bucket = 0;
+		while (bucket + 1 < histogramBuckets && pause >= upper(bucket))
+			bucket++;
+
+		buckets->at(bucket)++;
+		maxPause = ::max(maxPause, pause);
+	}
+
+	Nat GcHistogram::count() const {
+		return buckets->count();
+	}
+
+	Duration GcHistogram::lower(Nat bucket) const {
+		if (bucket == 0)
+			return Duration();
+		return time::us(histogramFirst << (bucket - 1));
+	}
+
+	Duration GcHistogram::upper(Nat bucket) const {
+		if (bucket + 1 >= histogramBuckets)
+			return ::max(maxPause, lower(bucket));
+		return time::us(histogramFirst << bucket);
+	}
+
+	Nat GcHistogram::at(Nat bucket) const {
+		return buckets->at(bucket);
+	}
+
+	Nat GcHistogram::total() const {
+		Nat sum = 0;
+		for (Nat i = 0; i < buckets->count(); i++)
+			sum += buckets->at(i);
+		return sum;
+	}
+
+	Duration GcHistogram::longest() const {
+		return maxPause;
+	}
+
+	Duration GcHistogram::percentile(Float fraction) const {
+		Nat limit = Nat(fraction * total());
+		Nat sum = 0;
+		for (Nat i = 0; i < buckets->count(); i++) {
+			sum += buckets->at(i);
+			if (sum > limit || sum == total())
+				return upper(i);
+		}
+		return Duration();
+	}
+
+	void GcHistogram::toS(StrBuf *to) const {
+		*to << S("Pauses: ") << total() << S(", longest: ") << maxPause;
+		for (Nat i = 0; i < buckets->count(); i++) {
+			if (buckets->at(i) == 0)
+				continue;
+
+			*to << S("\n") << lower(i) << S(" - ") << upper(i) << S(": ") << buckets->at(i);
+		}
+	}
+
+
+	GcInfo::GcInfo(const GcHistory &history)
+		: tracked(history.tracked),
+		  collections(history.collections),
+		  collectTime(time::us(Long(history.collectTime))),
+		  finalizations(history.finalizations),
+		  finalizeTime(time::us(Long(history.finalizeTime))) {
+
+		recent = new (this) Array<GcCollection>();
+		recent->reserve(Nat(history.recent.size()));
+		for (size_t i = 0; i < history.recent.size(); i++) {
+			const GcEvent &e = history.recent[i];
+			GcCollection c;
+			c.generation = e.generation;
+			c.start = time::us(Long(e.start));
+			c.duration = time::us(Long(e.duration));
+			c.pause = e.pause;
+			c.scanned = e.scanned;
+			c.copied = e.copied;
+			c.promoted = e.promoted;
+			c.freed = e.freed;
+			c.pinnedChunks = Nat(e.pinnedChunks);
+			recent->push(c);
+		}
+	}
+
+	GcHistogram *GcInfo::pauses() const {
+		GcHistogram *result = new (this) GcHistogram();
+		for (Nat i = 0; i < recent->count(); i++)
+			if (recent->at(i).pause)
+				result->add(recent->at(i).duration);
+		return result;
+	}
+
+	GcHistogram *GcInfo::pauses(Nat generation) const {
+		GcHistogram *result = new (this) GcHistogram();
+		for (Nat i = 0; i < recent->count(); i++)
+			if (recent->at(i).pause && recent->at(i).generation == generation)
+				result->add(recent->at(i).duration);
+		return result;
+	}
+
+	Float GcInfo::overhead() const {
+		if (recent->empty())
+			return 0;
+
+		GcCollection first = recent->at(0);
+		GcCollection last = recent->last();
+		Duration total = last.start + last.duration - first.start;
+		if (total <= Duration())
+			return 0;
+
+		Duration collecting;
+		for (Nat i = 0; i < recent->count(); i++)
+			if (recent->at(i).pause)
+				collecting += recent->at(i).duration;
+		return collecting / total;
+	}
+
+	void GcInfo::toS(StrBuf *to) const {
+		*to << S("Collections: ") << collections << S(" (") << collectTime << S(")\n");
+		*to << S("Finalizations: ") << finalizations << S(" (") << finalizeTime << S(")\n");
+		*to << S("Overhead: ") << (overhead() * 100) << S("%\n");
+		*to << pauses();
+	}
+
+	GcInfo *gcInfo(EnginePtr e) {
+		return new (e.v) GcInfo(e.v.gc.history());
+	}
+
+	void gcGoals(EnginePtr e, Nat pause, Nat overhead) {
+		e.v.gc.setGoals(GcGoals(pause, overhead));
+	}
+
+	void sampleAllocations(EnginePtr e, Nat interval) {
+		e.v.gc.sampleAllocations(interval);
+	}
+
+	// Output a frame name in the folded format, where semicolons and line breaks have a special meaning.
+	static void putFrame(StrBuf *to, const StackFrame &frame) {
+		std::wostringstream name;
+		StdOutput out(name);
+		stackInfo().format(out, frame.id, frame.fnBase, frame.offset);
+
+		std::wstring s = name.str();
+		for (size_t i = 0; i < s.size(); i++)
+			if (s[i] == ';' || s[i] == '\n' || s[i] == '\r')
+				s[i] = ' ';
+		*to << s.c_str();
+	}
+
+	Str *allocationProfile(EnginePtr e, Bool bytes) {
+		vector<AllocSampler::Site> sites = e.v.gc.allocSamples();
+		StrBuf *to = new (e.v) StrBuf();
+
+		for (size_t i = 0; i < sites.size(); i++) {
+			const AllocSampler::Site &site = sites[i];
+
+			// The trace starts at the innermost function.
+			for (nat j = site.trace.count(); j > 0; j--) {
+				putFrame(to, site.trace[j - 1]);
+				*to << S(";");
+			}
+
+			if (site.type)
+				*to << site.type->identifier();
+			else if (site.kind == GcType::tArray || site.kind == GcType::tWeakArray)
+				*to << S("<array>");
+			else
+				*to << S("<unknown>");
+
+			*to << S(" ") << Word(bytes ? site.bytes : site.samples) << S("\n");
+		}
+
+		return to->toS();
+	}
+
+	void saveAllocationProfile(EnginePtr e, Url *file, Bool bytes) {
+		TextOutput *out = new (e.v) Utf8Output(file->write());
+		out->write(allocationProfile(e, bytes));
+		out->close();
+	}
+
+}
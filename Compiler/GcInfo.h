@@ -0,0 +1,189 @@
+#pragma once
+#include "Core/Object.h"
+#include "Core/Array.h"
+#include "Core/Timing.h"
+#include "Core/EnginePtr.h"
+#include "Core/Io/Url.h"
+
+namespace storm {
+	STORM_PKG(core);
+
+	class GcHistory;
+
+	/**
+	 * Information about a single garbage collection.
+	 *
+	 * Not all GC implementations are able to provide all values. Values that are not available are
+	 * zero.
+	 */
+	class GcCollection {
+		STORM_VALUE;
+	public:
+		// Create an empty collection.
+		STORM_CTOR GcCollection();
+
+		// Generation that was collected. Zero is the youngest generation.
+		Nat generation;
+
+		// Time when the collection started. Only meaningful relative to other collections.
+		Duration start;
+
+		// Time spent collecting.
+		Duration duration;
+
+		// Is 'duration' the length of a pause? False for incremental collections, where the
+		// program was running during parts of 'duration'. Always false for MPS, which does not
+		// report the length of its pauses.
+		Bool pause;
+
+		// Number of bytes in the collected generation when the collection started.
+		Word scanned;
+
+		// Number of bytes copied to a new location.
+		Word copied;
+
+		// Number of bytes that now belong to an older generation.
+		Word promoted;
+
+		// Number of bytes reclaimed.
+		Word freed;
+
+		// Number of chunks (the regions of memory the GC allocates from the system) that contained
+		// pinned objects, and were therefore kept rather than freed.
+		Nat pinnedChunks;
+	};
+
+	// Output.
+	StrBuf &STORM_FN operator <<(StrBuf &to, GcCollection c);
+
+
+	/**
+	 * Histogram of pause times.
+	 *
+	 * The buckets are exponentially sized. The first bucket contains pauses shorter than 64 us, and
+	 * each following bucket is twice as large as the previous one. The last bucket contains all
+	 * pauses that are too long for the other buckets.
+	 */
+	class GcHistogram : public Object {
+		STORM_CLASS;
+	public:
+		// Create an empty histogram.
+		STORM_CTOR GcHistogram();
+
+		// Add a pause.
+		void STORM_FN add(Duration pause);
+
+		// Number of buckets.
+		Nat STORM_FN count() const;
+
+		// Bounds of a bucket. 'lower' is inclusive and 'upper' is exclusive. The upper bound of the
+		// last bucket is the longest pause added to it.
+		Duration STORM_FN lower(Nat bucket) const;
+		Duration STORM_FN upper(Nat bucket) const;
+
+		// Number of pauses in a bucket.
+		Nat STORM_FN at(Nat bucket) const;
+
+		// Total number of pauses.
+		Nat STORM_FN total() const;
+
+		// Longest pause.
+		Duration STORM_FN longest() const;
+
+		// Get an upper bound for the length of the 'fraction' (0 to 1) shortest pauses. For example,
+		// 'percentile(0.99)' is the length that 99% of the pauses are shorter than, rounded up to the
+		// end of the bucket.
+		Duration STORM_FN percentile(Float fraction) const;
+
+		// Output.
+		virtual void STORM_FN toS(StrBuf *to) const;
+
+	private:
+		// Number of pauses in each bucket.
+		Array<Nat> *buckets;
+
+		// Longest pause.
+		Duration maxPause;
+	};
+
+
+	/**
+	 * Information about the garbage collections performed so far.
+	 *
+	 * The information is a snapshot of the state when it was created by 'gcInfo'. Totals are
+	 * counted from startup, while details are only kept for a limited number of recent
+	 * collections. GC implementations that do not keep track of their collections report no
+	 * collections at all.
+	 */
+	class GcInfo : public Object {
+		STORM_CLASS;
+	public:
+		// Create from the history provided by the GC.
+		GcInfo(const GcHistory &history);
+
+		// Does the GC keep track of its collections? If not, all other values are zero.
+		Bool tracked;
+
+		// Number of collections since startup.
+		Word collections;
+
+		// Total time spent collecting.
+		Duration collectTime;
+
+		// Number of times finalizers were executed after a collection.
+		Word finalizations;
+
+		// Total time spent executing finalizers.
+		Duration finalizeTime;
+
+		// The most recent collections, oldest first.
+		Array<GcCollection> *recent;
+
+		// Histogram of the pauses in 'recent'. Incremental collections are not included. Since MPS
+		// does not report pause times, this is always empty when using MPS.
+		GcHistogram *STORM_FN pauses() const;
+
+		// Histogram of the pauses in 'recent' that collected the specified generation.
+		GcHistogram *STORM_FN pauses(Nat generation) const;
+
+		// Fraction of time spent in pauses during the time covered by 'recent'. Incremental
+		// collections are not included, so this is always zero when using MPS.
+		Float STORM_FN overhead() const;
+
+		// Output.
+		virtual void STORM_FN toS(StrBuf *to) const;
+	};
+
+	// Get information about the garbage collections performed so far.
+	GcInfo *STORM_FN gcInfo(EnginePtr e);
+
+	// Set goals for the garbage collector: the time spent collecting a single generation
+	// ('pause', in milliseconds), and the time spent collecting a generation relative to the time
+	// between its collections ('overhead', in percent). Only collectors that resize their
+	// generations (SMM) use the goals.
+	void STORM_FN gcGoals(EnginePtr e, Nat pause, Nat overhead);
+
+
+	/**
+	 * Allocation profiling.
+	 *
+	 * The GC is able to record the stack trace of one allocation for every 'interval' bytes that
+	 * are allocated. This is cheap enough to leave on with a large interval (e.g. 512 KiB), as only
+	 * the sampled allocations are slowed down. The samples are aggregated by the allocated type and
+	 * the stack trace, and can be retrieved in the "folded stacks" format understood by flame
+	 * graph tools: one line for each allocation site, containing the functions on the stack from
+	 * the outermost one, separated by semicolons, followed by the allocated type and a value.
+	 */
+
+	// Start sampling allocations, once every 'interval' bytes. Any previous samples are
+	// discarded. An interval of zero stops sampling, but keeps the samples.
+	void STORM_FN sampleAllocations(EnginePtr e, Nat interval);
+
+	// Get the samples in the folded stacks format. If 'bytes' is true, the value on each line is
+	// the estimated number of bytes allocated, otherwise it is the number of samples.
+	Str *STORM_FN allocationProfile(EnginePtr e, Bool bytes);
+
+	// Write the samples to a file, in the same format as 'allocationProfile'.
+	void STORM_FN saveAllocationProfile(EnginePtr e, Url *file, Bool bytes);
+
+}
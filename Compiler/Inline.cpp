@@ -0,0 +1,350 @@
+#include "stdafx.h"
+#include "Inline.h"
+#include "Function.h"
+#include "Code.h"
+#include "NamedSource.h"
+#include "Code/TypeDesc.h"
+
+namespace storm {
+	using namespace code;
+
+	// Maximum number of instructions in a function that is inlined.
+	static const Nat inlineBudget = 32;
+
+	// Does 'op' refer to the metadata label?
+	static bool refersMeta(Listing *l, const Operand &op) {
+		if (op.type() != opLabel && op.type() != opRelativeLbl)
+			return false;
+		return op.label() == l->meta();
+	}
+
+	Bool inlineCandidate(MAYBE(Listing *) l) {
+		if (!l || l->empty() || l->count() > inlineBudget)
+			return false;
+		if (l->exceptionAware())
+			return false;
+		if (l->at(0)->op() != op::prolog)
+			return false;
+
+		if (!as<PrimitiveDesc>(l->result))
+			return false;
+
+		Array<Var> *params = l->allParams();
+		for (Nat i = 0; i < params->count(); i++)
+			if (!as<PrimitiveDesc>(l->paramDesc(params->at(i))))
+				return false;
+
+		Array<Var> *vars = l->allVars();
+		for (Nat i = 0; i < vars->count(); i++)
+			if (l->freeFn(vars->at(i)).any())
+				return false;
+
+		for (Nat i = 1; i < l->count(); i++) {
+			Instr *instr = l->at(i);
+			switch (instr->op()) {
+			case op::prolog:
+			case op::epilog:
+			case op::ret:
+			case op::call:
+			case op::fnRetRef:
+			case op::threadLocal:
+			case op::preserve:
+			case op::dat:
+			case op::lblOffset:
+			case op::align:
+				// These depend on being in a function of their own.
+				return false;
+			default:
+				break;
+			}
+
+			if (refersMeta(l, instr->src()) || refersMeta(l, instr->dest()))
+				return false;
+		}
+
+		return true;
+	}
+
+	// Find the function called by 'call' and return its listing if it is suitable for inlining.
+	static Listing *inlineBody(Function *owner, Instr *call, Function *&callee) {
+		if (call->op() != op::fnCall || call->src().type() != opReference)
+			return null;
+
+		NamedSource *source = as<NamedSource>(call->src().refSource());
+		if (!source)
+			return null;
+
+		callee = as<Function>(source->named());
+		if (!callee || callee == owner)
+			return null;
+
+		if (source->type() == Char(Nat(0))) {
+			// Through the lookup. Must not be virtual.
+			if (callee->ref().address() != callee->directRef().address())
+				return null;
+		} else if (source->type() != Char('d')) {
+			return null;
+		}
+
+		LazyCode *code = as<LazyCode>(callee->getCode());
+		if (!code)
+			return null;
+
+		Listing *body = code->inlineSource();
+		if (!inlineCandidate(body))
+			return null;
+		return body;
+	}
+
+	/**
+	 * Copies the body of a function into another listing.
+	 */
+	class Inliner {
+	public:
+		Inliner(Listing *to, Listing *body, Block parent) : to(to), body(body) {
+			Array<Block> *blocks = body->allBlocks();
+			blockMap = new (to) Array<Block>(blocks->count(), Block());
+			for (Nat i = 0; i < blocks->count(); i++) {
+				Block b = blocks->at(i);
+				Block p = i == 0 ? parent : blockMap->at(body->parent(b).key());
+				blockMap->at(b.key()) = to->createBlock(p);
+			}
+
+			Array<Var> *vars = body->allVars();
+			varMap = new (to) Array<Var>(vars->count(), Var());
+			for (Nat i = 0; i < vars->count(); i++) {
+				Var v = vars->at(i);
+				Block in = body->isParam(v) ? blockMap->at(0) : blockMap->at(body->parent(v).key());
+				varMap->at(v.key()) = to->createVar(in, v.size());
+			}
+
+			labelMap = new (to) Array<Label>();
+		}
+
+		// Emit the body. 'params' are the parameters to the function, 'result' is where the result
+		// is to be stored (if anywhere), and 'parent' is the block the call was made in.
+		void emit(Array<Operand> *params, Operand result, Block parent) {
+			Label done = to->label();
+			Block root = blockMap->at(0);
+
+			// Registers are not preserved by 'begin', so actuals that use registers are copied to
+			// temporary variables first.
+			Array<Operand> *actuals = new (to) Array<Operand>(*params);
+			for (Nat i = 0; i < actuals->count(); i++) {
+				Operand &actual = actuals->at(i);
+				if (!actual.hasRegister())
+					continue;
+
+				Var tmp = to->createVar(parent, actual.size());
+				*to << mov(tmp, actual);
+				actual = tmp;
+			}
+
+			*to << begin(root);
+
+			Array<Var> *formals = body->allParams();
+			for (Nat i = 0; i < formals->count(); i++)
+				*to << mov(map(formals->at(i)), actuals->at(i));
+
+			for (Nat i = 1; i < body->count(); i++) {
+				emitLabels(i);
+
+				Instr *instr = body->at(i);
+				if (instr->op() == op::fnRet) {
+					if (result.any() && instr->src().any())
+						*to << mov(result, map(instr->src()));
+					*to << jmpBlock(done, parent);
+				} else {
+					*to << instr->alter(map(instr->dest()), map(instr->src()));
+				}
+			}
+			emitLabels(body->count());
+
+			*to << end(root);
+			*to << done;
+		}
+
+	private:
+		// Output to, and the body to inline.
+		Listing *to;
+		Listing *body;
+
+		// Blocks and variables in 'body' mapped to their counterpart in 'to'. Indexed by key.
+		Array<Block> *blockMap;
+		Array<Var> *varMap;
+
+		// Labels in 'body' mapped to labels in 'to'. Created on demand.
+		Array<Label> *labelMap;
+
+		// Map a label.
+		Label map(Label l) {
+			while (labelMap->count() <= l.key())
+				labelMap->push(Label());
+			if (labelMap->at(l.key()) == Label())
+				labelMap->at(l.key()) = to->label();
+			return labelMap->at(l.key());
+		}
+
+		// Map an operand.
+		Operand map(const Operand &op) {
+			switch (op.type()) {
+			case opVariable:
+				return xRel(op.size(), varMap->at(op.var().key()), op.offset());
+			case opLabel:
+				return map(op.label());
+			case opRelativeLbl:
+				return xRel(op.size(), map(op.label()), op.offset());
+			case opBlock:
+				return blockMap->at(op.block().key());
+			default:
+				return op;
+			}
+		}
+
+		// Emit labels at position 'id' in 'body'.
+		void emitLabels(Nat id) {
+			if (Array<Label> *labels = body->labels(id))
+				for (Nat i = 0; i < labels->count(); i++)
+					*to << map(labels->at(i));
+		}
+	};
+
+	Listing *inlineCalls(Function *owner, Listing *src, Array<Function *> *inlined) {
+		// Find calls to inline, and the block they are located in.
+		Array<Listing *> *bodies = new (src) Array<Listing *>(src->count(), null);
+		Array<Block> *blocks = new (src) Array<Block>(src->count(), Block());
+		Array<Bool> *params = new (src) Array<Bool>(src->count(), false);
+		Array<Function *> *callees = new (src) Array<Function *>(src->count(), null);
+		Array<Block> *current = new (src) Array<Block>(1, src->root());
+		Bool any = false;
+
+		for (Nat i = 0; i < src->count(); i++) {
+			Instr *instr = src->at(i);
+			if (instr->op() == op::beginBlock) {
+				current->push(instr->src().block());
+				continue;
+			} else if (instr->op() == op::endBlock) {
+				if (current->count() > 1)
+					current->pop();
+				continue;
+			}
+
+			Function *callee = null;
+			Listing *body = inlineBody(owner, instr, callee);
+			if (!body)
+				continue;
+
+			// Parameters must immediately precede the call, and the types must match.
+			Array<Var> *formals = body->allParams();
+			Nat count = formals->count();
+			if (count > i)
+				continue;
+
+			bool ok = true;
+			for (Nat j = 0; j < count && ok; j++) {
+				Nat at = i - count + j;
+				Instr *param = src->at(at);
+				ok &= param->op() == op::fnParam;
+				ok &= param->src().size() == formals->at(j).size();
+				if (j > 0)
+					ok &= src->labels(at) == null;
+			}
+			if (count > 0)
+				ok &= src->labels(i) == null;
+
+			// The result must have the same size.
+			Operand result = instr->dest();
+			if (result.any())
+				ok &= result.size() == body->result->size();
+
+			if (!ok)
+				continue;
+
+			for (Nat j = 0; j < count; j++)
+				params->at(i - count + j) = true;
+			bodies->at(i) = body;
+			blocks->at(i) = current->last();
+			callees->at(i) = callee;
+			any = true;
+		}
+
+		if (!any)
+			return src;
+
+		Listing *dest = src->createShell();
+		Array<Operand> *actuals = new (src) Array<Operand>();
+		for (Nat i = 0; i < src->count(); i++) {
+			if (Array<Label> *labels = src->labels(i))
+				for (Nat j = 0; j < labels->count(); j++)
+					*dest << labels->at(j);
+
+			Instr *instr = src->at(i);
+			if (params->at(i)) {
+				actuals->push(instr->src());
+			} else if (Listing *body = bodies->at(i)) {
+				Inliner inliner(dest, body, blocks->at(i));
+				inliner.emit(actuals, instr->dest(), blocks->at(i));
+				actuals->clear();
+
+				inlined->push(callees->at(i));
+			} else {
+				*dest << instr;
+			}
+		}
+
+		if (Array<Label> *labels = src->labels(src->count()))
+			for (Nat j = 0; j < labels->count(); j++)
+				*dest << labels->at(j);
+
+		return dest;
+	}
+
+
+	/**
+	 * InlineInfo.
+	 */
+
+	InlineInfo::InlineInfo(LazyCode *owner, Listing *source, Array<Function *> *inlined, code::Content *content)
+		: source(source), owner(owner), inlined(inlined), valid(true) {
+
+		code = new (this) Array<Code *>();
+		lookup = new (this) Array<Code *>();
+		refs = new (this) Array<code::Reference *>();
+
+		for (Nat i = 0; i < inlined->count(); i++) {
+			Function *f = inlined->at(i);
+			code->push(f->getCode());
+			lookup->push(f->getLookup());
+
+			refs->push(new (this) InlineRef(f->directRef().source(), content, this));
+			refs->push(new (this) InlineRef(f->ref().source(), content, this));
+		}
+	}
+
+	void InlineInfo::check() {
+		if (!valid)
+			return;
+
+		for (Nat i = 0; i < inlined->count(); i++) {
+			Function *f = inlined->at(i);
+			if (f->getCode() != code->at(i) || f->getLookup() != lookup->at(i)) {
+				valid = false;
+				owner->inlinedChanged();
+				return;
+			}
+		}
+	}
+
+
+	/**
+	 * InlineRef.
+	 */
+
+	InlineRef::InlineRef(code::RefSource *to, code::Content *inside, InlineInfo *info)
+		: code::Reference(to, inside), info(info) {}
+
+	void InlineRef::moved(const void *newAddr) {
+		info->check();
+	}
+
+}
@@ -0,0 +1,90 @@
+#pragma once
+#include "Code/Listing.h"
+#include "Code/Reference.h"
+#include "Core/Array.h"
+
+namespace storm {
+	STORM_PKG(core.lang);
+
+	class Function;
+	class Code;
+	class LazyCode;
+
+	/**
+	 * Inlining of small functions.
+	 *
+	 * Calls to small non-virtual functions in a listing are replaced with the body of the called
+	 * function. This is done on the listings produced by the code generation, so it works for all
+	 * languages that use LazyCode. A function is inlined if:
+	 *
+	 * - the call is made through the lookup of a function that is not virtual, or directly to the
+	 *   code of a function.
+	 * - the called function has already been compiled, and its listing is small (see
+	 *   'inlineCandidate').
+	 * - all parameters, and the result, are primitive types.
+	 *
+	 * The lookup of a member function is only non-virtual as long as no loaded subclass overrides
+	 * it (see VTable). Whenever the code or lookup of an inlined function is replaced, for example
+	 * when a package that overrides the function is loaded, the function it was inlined into
+	 * returns to unoptimized code the next time it is called. This is detected through References
+	 * to the RefSources of the inlined functions.
+	 */
+
+	// Is 'l' small and simple enough to be inlined into other functions?
+	Bool STORM_FN inlineCandidate(MAYBE(code::Listing *) l);
+
+	// Inline suitable function calls in 'src', which is the code of 'owner'. Returns 'src' if
+	// nothing was inlined. All inlined functions are added to 'inlined'.
+	code::Listing *STORM_FN inlineCalls(Function *owner, code::Listing *src, Array<Function *> *inlined);
+
+
+	/**
+	 * Functions inlined into a LazyCode. Keeps track of the original listing so that it can be
+	 * compiled again if any of the inlined functions are replaced.
+	 */
+	class InlineInfo : public ObjectOn<Compiler> {
+		STORM_CLASS;
+	public:
+		// Create. 'source' is the listing before inlining. 'content' is the compiled code.
+		InlineInfo(LazyCode *owner, code::Listing *source, Array<Function *> *inlined, code::Content *content);
+
+		// Listing before inlining.
+		code::Listing *source;
+
+		// Check if any inlined functions have changed, and notify the owner if that is the case.
+		void check();
+
+	private:
+		// Owner.
+		LazyCode *owner;
+
+		// Inlined functions, and their code and lookup at the time of inlining.
+		Array<Function *> *inlined;
+		Array<Code *> *code;
+		Array<Code *> *lookup;
+
+		// References to the functions, to get notified when they change.
+		Array<code::Reference *> *refs;
+
+		// Still valid?
+		Bool valid;
+	};
+
+
+	/**
+	 * Reference used to get notified when an inlined function is replaced.
+	 */
+	class InlineRef : public code::Reference {
+		STORM_CLASS;
+	public:
+		InlineRef(code::RefSource *to, code::Content *inside, InlineInfo *info);
+
+		// Notification of changed address.
+		virtual void moved(const void *newAddr);
+
+	private:
+		// Info to notify.
+		InlineInfo *info;
+	};
+
+}
@@ -0,0 +1,222 @@
+#include "stdafx.h"
+#include "InlineCache.h"
+#include "Function.h"
+#include "Type.h"
+#include "Code.h"
+#include "NamedSource.h"
+#include "VTableCall.h"
+#include "OverridePart.h"
+#include "Core/Runtime.h"
+#include "Core/StrBuf.h"
+
+namespace storm {
+	using namespace code;
+
+	InlineCache::InlineCache(Function *fn, Nat id)
+		: id(id), fn(fn), found(null), sample(null), hitCount(0), missCount(0) {}
+
+	MAYBE(Function *) InlineCache::target() {
+		if (!sample)
+			return found;
+
+		Type *type = runtime::typeOf(sample);
+		sample = null;
+
+		// Find the function that overrides 'fn' in 'type', or in any of its parents.
+		Type *owner = fn->params->at(0).type;
+		OverridePart *part = new (this) OverridePart(fn);
+		for (Type *t = type; t; t = t->super()) {
+			if (t == owner) {
+				found = fn;
+				break;
+			}
+
+			if (Function *f = as<Function>(t->tryFindHere(part, Scope()))) {
+				found = f;
+				break;
+			}
+		}
+
+		return found;
+	}
+
+	void InlineCache::record(Listing *to, Operand obj) {
+		*to << mov(ptrA, obj);
+		*to << mov(ptrC, objPtr(this));
+		*to << mov(ptrRel(ptrC, Offset(OFFSET_OF(InlineCache, sample))), ptrA);
+	}
+
+	// Find the vtable slot used when calling 'fn' through its lookup, if any.
+	static VTableSlot lookupSlot(Function *fn) {
+		DelegatedCode *lookup = as<DelegatedCode>(fn->getLookup());
+		if (!lookup)
+			return VTableSlot();
+
+		VTableSource *source = as<VTableSource>(lookup->to().source());
+		if (!source)
+			return VTableSlot();
+
+		return source->vtableSlot();
+	}
+
+	void InlineCache::check(Listing *to, Operand obj, Label miss) {
+		// Note: We compare the contents of the vtable slot rather than the vtable itself. That
+		// way, we don't need to worry about overrides being added or vtables being moved.
+		*to << mov(ptrA, obj);
+		*to << mov(ptrA, ptrRel(ptrA, Offset()));
+		*to << mov(ptrA, vtableSlotRef(to, lookupSlot(fn)));
+		*to << mov(ptrC, objPtr(this));
+		*to << cmp(ptrA, found->directRef());
+		*to << jmp(miss, ifNotEqual);
+		*to << add(intRel(ptrC, Offset(OFFSET_OF(InlineCache, hitCount))), natConst(1));
+	}
+
+	void InlineCache::missed(Listing *to) {
+		*to << mov(ptrC, objPtr(this));
+		*to << add(intRel(ptrC, Offset(OFFSET_OF(InlineCache, missCount))), natConst(1));
+	}
+
+	void InlineCache::toS(StrBuf *to) const {
+		*to << fn->identifier() << S(": ") << hitCount << S(" hits, ") << missCount << S(" misses");
+	}
+
+	// If instruction 'id' in 'src' is a virtual call suitable for an inline cache, return the
+	// function called.
+	static Function *virtualCall(Listing *src, Nat id) {
+		Instr *call = src->at(id);
+		if (call->op() != op::fnCall || call->src().type() != opReference)
+			return null;
+
+		NamedSource *source = as<NamedSource>(call->src().refSource());
+		if (!source || source->type() != Char(Nat(0)))
+			return null;
+
+		Function *fn = as<Function>(source->named());
+		if (!fn || !fn->isMember() || !lookupSlot(fn).valid())
+			return null;
+
+		// Parameters must immediately precede the call. We use 'ptrA' and 'ptrC' before the
+		// parameters, so they may not use registers.
+		Nat count = fn->params->count();
+		if (count == 0 || count > id)
+			return null;
+
+		Nat first = id - count;
+		if (src->at(first)->op() != op::fnParam || src->at(first)->src().size() != Size::sPtr)
+			return null;
+
+		for (Nat i = first; i < id; i++) {
+			Instr *param = src->at(i);
+			if (param->op() != op::fnParam && param->op() != op::fnParamRef)
+				return null;
+			if (param->src().hasRegister())
+				return null;
+			if (i > first && src->labels(i))
+				return null;
+		}
+
+		if (src->labels(id))
+			return null;
+
+		return fn;
+	}
+
+	Listing *recordReceivers(Listing *src, Array<InlineCache *> *caches) {
+		// Find call sites, and where their parameters start.
+		Array<InlineCache *> *first = new (src) Array<InlineCache *>(src->count(), null);
+		Bool any = false;
+		for (Nat i = 0; i < src->count(); i++) {
+			if (Function *fn = virtualCall(src, i)) {
+				InlineCache *cache = new (src) InlineCache(fn, i);
+				caches->push(cache);
+				first->at(i - fn->params->count()) = cache;
+				any = true;
+			}
+		}
+
+		if (!any)
+			return src;
+
+		Listing *dest = src->createShell();
+		for (Nat i = 0; i < src->count(); i++) {
+			if (Array<Label> *labels = src->labels(i))
+				for (Nat j = 0; j < labels->count(); j++)
+					*dest << labels->at(j);
+
+			Instr *instr = src->at(i);
+			if (InlineCache *cache = first->at(i))
+				cache->record(dest, instr->src());
+
+			*dest << instr;
+		}
+
+		if (Array<Label> *labels = src->labels(src->count()))
+			for (Nat j = 0; j < labels->count(); j++)
+				*dest << labels->at(j);
+
+		return dest;
+	}
+
+	Listing *useInlineCaches(Listing *src, Array<InlineCache *> *caches) {
+		// Find the caches we can use, and where their parameters start.
+		Array<InlineCache *> *first = new (src) Array<InlineCache *>(src->count(), null);
+		Bool any = false;
+		for (Nat i = 0; i < caches->count(); i++) {
+			InlineCache *cache = caches->at(i);
+			if (cache->id >= src->count() || !cache->target())
+				continue;
+
+			Function *fn = virtualCall(src, cache->id);
+			if (fn != cache->function())
+				continue;
+
+			first->at(cache->id - fn->params->count()) = cache;
+			any = true;
+		}
+
+		if (!any)
+			return src;
+
+		Listing *dest = src->createShell();
+		for (Nat i = 0; i < src->count(); i++) {
+			if (Array<Label> *labels = src->labels(i))
+				for (Nat j = 0; j < labels->count(); j++)
+					*dest << labels->at(j);
+
+			InlineCache *cache = first->at(i);
+			if (!cache) {
+				*dest << src->at(i);
+				continue;
+			}
+
+			Label miss = dest->label();
+			Label done = dest->label();
+			Instr *call = src->at(cache->id);
+
+			// Direct call if the check succeeds.
+			cache->check(dest, src->at(i)->src(), miss);
+			for (Nat j = i; j < cache->id; j++)
+				*dest << src->at(j);
+			*dest << call->alterSrc(cache->target()->directRef());
+			*dest << jmp(done);
+
+			// Otherwise, use the vtable.
+			*dest << miss;
+			cache->missed(dest);
+			for (Nat j = i; j < cache->id; j++)
+				*dest << src->at(j);
+			*dest << call;
+			*dest << done;
+
+			// There are no labels inside the call.
+			i = cache->id;
+		}
+
+		if (Array<Label> *labels = src->labels(src->count()))
+			for (Nat j = 0; j < labels->count(); j++)
+				*dest << labels->at(j);
+
+		return dest;
+	}
+
+}
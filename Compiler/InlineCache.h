@@ -0,0 +1,80 @@
+#pragma once
+#include "Code/Listing.h"
+#include "Core/Array.h"
+
+namespace storm {
+	STORM_PKG(core.lang);
+
+	class Function;
+
+	/**
+	 * Inline cache for a call site of a virtual function.
+	 *
+	 * Unoptimized code records the receiver of each virtual call in the inline cache for that call
+	 * site. When the code is optimized, the function called for the recorded receiver is looked
+	 * up, and the call site checks if the function in the vtable of the receiver is that
+	 * function. If so, the function is called directly (which also allows it to be inlined),
+	 * otherwise the regular vtable dispatch is used.
+	 *
+	 * The number of hits and misses of the check is counted, so that megamorphic call sites can
+	 * be found. The counters are updated without synchronization, so they are approximate when
+	 * the code runs on multiple threads.
+	 */
+	class InlineCache : public ObjectOn<Compiler> {
+		STORM_CLASS;
+	public:
+		// Create, for a call to 'fn' at instruction 'id' in the source listing.
+		InlineCache(Function *fn, Nat id);
+
+		// Instruction in the source listing.
+		Nat id;
+
+		// The called function.
+		inline Function *STORM_FN function() const { return fn; }
+
+		// Number of calls that were dispatched directly.
+		inline Nat STORM_FN hits() const { return hitCount; }
+
+		// Number of calls that had to use the vtable.
+		inline Nat STORM_FN misses() const { return missCount; }
+
+		// Function that is called directly, if any.
+		MAYBE(Function *) STORM_FN target();
+
+		// Emit code that records the receiver 'obj' in here. Clobbers 'ptrA' and 'ptrC'.
+		void record(code::Listing *to, code::Operand obj);
+
+		// Emit code that checks if a call with the receiver 'obj' would call 'target()', and
+		// jumps to 'miss' otherwise. Clobbers 'ptrA' and 'ptrC'.
+		void check(code::Listing *to, code::Operand obj, code::Label miss);
+
+		// Emit code that counts a miss. Clobbers 'ptrC'.
+		void missed(code::Listing *to);
+
+		// To string.
+		virtual void STORM_FN toS(StrBuf *to) const;
+
+	private:
+		// Called function.
+		Function *fn;
+
+		// Function called for the recorded receiver.
+		MAYBE(Function *) found;
+
+		// The last receiver recorded. Cleared when 'target' is computed.
+		UNKNOWN(PTR_GC) RootObject *sample;
+
+		// Counters.
+		Nat hitCount;
+		Nat missCount;
+	};
+
+	// Record receivers of all virtual calls in 'src' for use in a later call to
+	// 'useInlineCaches'. Creates an InlineCache for each call site in 'caches'.
+	code::Listing *recordReceivers(code::Listing *src, Array<InlineCache *> *caches);
+
+	// Check the receivers of virtual calls in 'src' against the ones recorded in 'caches', and call
+	// the functions directly whenever possible.
+	code::Listing *useInlineCaches(code::Listing *src, Array<InlineCache *> *caches);
+
+}
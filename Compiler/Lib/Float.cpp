@@ -18,51 +18,38 @@ namespace storm {
 
 	static void floatAdd(InlineParams p) {
 		if (p.result->needed()) {
-			*p.state->l << fld(p.param(0));
-			*p.state->l << fld(p.param(1));
-			*p.state->l << faddp();
-			*p.state->l << fstp(p.result->location(p.state));
-			*p.state->l << fwait();
+			Operand result = p.result->location(p.state);
+			*p.state->l << mov(result, p.param(0));
+			*p.state->l << fadd(result, p.param(1));
 		}
 	}
 
 	static void floatSub(InlineParams p) {
 		if (p.result->needed()) {
-			*p.state->l << fld(p.param(0));
-			*p.state->l << fld(p.param(1));
-			*p.state->l << fsubp();
-			*p.state->l << fstp(p.result->location(p.state));
-			*p.state->l << fwait();
+			Operand result = p.result->location(p.state);
+			*p.state->l << mov(result, p.param(0));
+			*p.state->l << fsub(result, p.param(1));
 		}
 	}
 
 	static void floatNeg(InlineParams p) {
-		if (p.result->needed()) {
-			*p.state->l << fldz();
-			*p.state->l << fld(p.param(0));
-			*p.state->l << fsubp();
-			*p.state->l << fstp(p.result->location(p.state));
-			*p.state->l << fwait();
-		}
+		if (p.result->needed())
+			*p.state->l << fneg(p.result->location(p.state), p.param(0));
 	}
 
 	static void floatMul(InlineParams p) {
 		if (p.result->needed()) {
-			*p.state->l << fld(p.param(0));
-			*p.state->l << fld(p.param(1));
-			*p.state->l << fmulp();
-			*p.state->l << fstp(p.result->location(p.state));
-			*p.state->l << fwait();
+			Operand result = p.result->location(p.state);
+			*p.state->l << mov(result, p.param(0));
+			*p.state->l << fmul(result, p.param(1));
 		}
 	}
 
 	static void floatDiv(InlineParams p) {
 		if (p.result->needed()) {
-			*p.state->l << fld(p.param(0));
-			*p.state->l << fld(p.param(1));
-			*p.state->l << fdivp();
-			*p.state->l << fstp(p.result->location(p.state));
-			*p.state->l << fwait();
+			Operand result = p.result->location(p.state);
+			*p.state->l << mov(result, p.param(0));
+			*p.state->l << fdiv(result, p.param(1));
 		}
 	}
 
@@ -80,25 +67,21 @@ namespace storm {
 	static void floatToInt(InlineParams p) {
 		if (!p.result->needed())
 			return;
-		*p.state->l << fld(p.param(0));
-		*p.state->l << fistp(p.result->location(p.state));
+		*p.state->l << fcasti(p.result->location(p.state), p.param(0));
 	}
 
 	// Note: Can be used for both 'double' and 'float'.
 	static void floatToFloat(InlineParams p) {
 		if (!p.result->needed())
 			return;
-		*p.state->l << fld(p.param(0));
-		*p.state->l << fstp(p.result->location(p.state));
+		*p.state->l << fcast(p.result->location(p.state), p.param(0));
 	}
 
 	template <CondFlag f>
 	static void floatCmp(InlineParams p) {
 		if (p.result->needed()) {
 			Operand result = p.result->location(p.state);
-			*p.state->l << fld(p.param(1));
-			*p.state->l << fld(p.param(0));
-			*p.state->l << fcompp();
+			*p.state->l << fcmp(p.param(0), p.param(1));
 			*p.state->l << setCond(result, f);
 		}
 	}
@@ -197,51 +180,38 @@ namespace storm {
 
 	static void doubleAdd(InlineParams p) {
 		if (p.result->needed()) {
-			*p.state->l << fld(p.param(0));
-			*p.state->l << fld(p.param(1));
-			*p.state->l << faddp();
-			*p.state->l << fstp(p.result->location(p.state));
-			*p.state->l << fwait();
+			Operand result = p.result->location(p.state);
+			*p.state->l << mov(result, p.param(0));
+			*p.state->l << fadd(result, p.param(1));
 		}
 	}
 
 	static void doubleSub(InlineParams p) {
 		if (p.result->needed()) {
-			*p.state->l << fld(p.param(0));
-			*p.state->l << fld(p.param(1));
-			*p.state->l << fsubp();
-			*p.state->l << fstp(p.result->location(p.state));
-			*p.state->l << fwait();
+			Operand result = p.result->location(p.state);
+			*p.state->l << mov(result, p.param(0));
+			*p.state->l << fsub(result, p.param(1));
 		}
 	}
 
 	static void doubleNeg(InlineParams p) {
-		if (p.result->needed()) {
-			*p.state->l << fldz();
-			*p.state->l << fld(p.param(0));
-			*p.state->l << fsubp();
-			*p.state->l << fstp(p.result->location(p.state));
-			*p.state->l << fwait();
-		}
+		if (p.result->needed())
+			*p.state->l << fneg(p.result->location(p.state), p.param(0));
 	}
 
 	static void doubleMul(InlineParams p) {
 		if (p.result->needed()) {
-			*p.state->l << fld(p.param(0));
-			*p.state->l << fld(p.param(1));
-			*p.state->l << fmulp();
-			*p.state->l << fstp(p.result->location(p.state));
-			*p.state->l << fwait();
+			Operand result = p.result->location(p.state);
+			*p.state->l << mov(result, p.param(0));
+			*p.state->l << fmul(result, p.param(1));
 		}
 	}
 
 	static void doubleDiv(InlineParams p) {
 		if (p.result->needed()) {
-			*p.state->l << fld(p.param(0));
-			*p.state->l << fld(p.param(1));
-			*p.state->l << fdivp();
-			*p.state->l << fstp(p.result->location(p.state));
-			*p.state->l << fwait();
+			Operand result = p.result->location(p.state);
+			*p.state->l << mov(result, p.param(0));
+			*p.state->l << fdiv(result, p.param(1));
 		}
 	}
 
@@ -260,9 +230,7 @@ namespace storm {
 	static void doubleCmp(InlineParams p) {
 		if (p.result->needed()) {
 			Operand result = p.result->location(p.state);
-			*p.state->l << fld(p.param(1));
-			*p.state->l << fld(p.param(0));
-			*p.state->l << fcompp();
+			*p.state->l << fcmp(p.param(0), p.param(1));
 			*p.state->l << setCond(result, f);
 		}
 	}
@@ -277,8 +245,7 @@ namespace storm {
 
 	static void castDouble(InlineParams p) {
 		p.allocRegs(0);
-		*p.state->l << fld(p.param(1));
-		*p.state->l << fstp(doubleRel(p.regParam(0), Offset()));
+		*p.state->l << fcast(doubleRel(p.regParam(0), Offset()), p.param(1));
 	}
 
 	static Double doubleRead(IStream *from) {
@@ -79,6 +79,8 @@ namespace storm {
 		}
 
 		// Create the thunk if not done already.
+		if (!thunk)
+			thunk = sharedCallThunk(result, formal);
 		if (!thunk) {
 			thunk = new (this) NamedSource(this, Char('t'));
 			thunk->set(callThunk(result, formal));
@@ -19,8 +19,7 @@ namespace storm {
 		if (!p.result->needed())
 			return;
 
-		*p.state->l << fild(p.param(0));
-		*p.state->l << fstp(p.result->location(p.state));
+		*p.state->l << icastf(p.result->location(p.state), p.param(0));
 	}
 
 	static Int intRead(IStream *from) {
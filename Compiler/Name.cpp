@@ -350,7 +350,7 @@ namespace storm {
 	// We need to differentiate between 'void' and 'not found'.
 	struct LookupResult {
 		Bool ok;
-		MAYBE(Type *) type;
+		MAYBE(Named *) found;
 	};
 
 	static LookupResult lookupPart(Engine &e, Scope scope, Str *original, Str::Iter &at) {
@@ -382,7 +382,13 @@ namespace storm {
 						return r;
 					}
 
-					Value v(param.type);
+					Type *paramType = as<Type>(param.found);
+					if (param.found && !paramType) {
+						r.ok = false;
+						return r;
+					}
+
+					Value v(paramType);
 					if (at.v() == mangleCommaRef) {
 						v.ref = true;
 					} else if (at.v() != mangleComma) {
@@ -410,11 +416,11 @@ namespace storm {
 			}
 		}
 
-		// Not void, make sure that the type exists!
+		// Not void, make sure that the entity exists!
 		if (name->count() > 0) {
-			// It 't' was null, then we failed. That failure should propagate the entire way.
-			r.type = as<Type>(scope.find(name));
-			if (!r.type)
+			// It 'found' was null, then we failed. That failure should propagate the entire way.
+			r.found = scope.find(name);
+			if (!r.found)
 				r.ok = false;
 		}
 
@@ -422,7 +428,11 @@ namespace storm {
 	}
 
 	MAYBE(Type *) lookupMangledName(const Scope &scope, Str *name) {
+		return as<Type>(lookupMangledNamed(scope, name));
+	}
+
+	MAYBE(Named *) lookupMangledNamed(const Scope &scope, Str *name) {
 		Str::Iter at = name->begin();
-		return lookupPart(name->engine(), scope, name, at).type;
+		return lookupPart(name->engine(), scope, name, at).found;
 	}
 }
@@ -166,4 +166,7 @@ namespace storm {
 	// Look up a mangled name.
 	MAYBE(Type *) STORM_FN lookupMangledName(const Scope &scope, Str *name);
 
+	// Look up a mangled name of any named entity, for example a function.
+	MAYBE(Named *) STORM_FN lookupMangledNamed(const Scope &scope, Str *name);
+
 }
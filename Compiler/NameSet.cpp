@@ -2,6 +2,7 @@
 #include "NameSet.h"
 #include "Engine.h"
 #include "Exception.h"
+#include "CompilePool.h"
 #include "Core/StrBuf.h"
 #include "Core/Str.h"
 
@@ -135,8 +136,17 @@ namespace storm {
 	void NameSet::compile() {
 		forceLoad();
 
-		for (Iter i = begin(), e = end(); i != e; ++i)
-			i.v()->compile();
+		// Let the CompilePool produce the machine code while we generate code for the next function.
+		CompilePool *pool = engine().compilePool();
+		pool->begin();
+		try {
+			for (Iter i = begin(), e = end(); i != e; ++i)
+				i.v()->compile();
+		} catch (...) {
+			pool->end();
+			throw;
+		}
+		pool->end();
 	}
 
 	void NameSet::discardSource() {
@@ -6,6 +6,7 @@
 #include "Engine.h"
 #include "Reader.h"
 #include "Exception.h"
+#include "CodeCache.h"
 
 namespace storm {
 
@@ -149,6 +150,9 @@ namespace storm {
 		// 	prev->push(i.v());
 
 		try {
+			// Code in the cache is only valid as long as these files are unchanged.
+			engine().codeCache()->loaded(files);
+
 			Map<SimpleName *, PkgFiles *> *readers = readerName(files);
 			Array<PkgReader *> *load = createReaders(readers);
 
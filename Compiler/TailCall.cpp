@@ -0,0 +1,249 @@
+#include "stdafx.h"
+#include "TailCall.h"
+#include "Function.h"
+#include "NamedSource.h"
+#include "Code/TypeDesc.h"
+#include "Code/Layout.h"
+
+namespace storm {
+	using namespace code;
+
+	// Maximum number of instructions to examine after a call to see if it is in tail position.
+	static const Nat tailScan = 32;
+
+	// Is 'instr' a call to 'owner'? Sets 'lookup' if the call is made through the lookup.
+	static bool selfCall(Function *owner, Instr *instr, Bool &lookup) {
+		if (instr->op() != op::fnCall || instr->src().type() != opReference)
+			return false;
+
+		NamedSource *source = as<NamedSource>(instr->src().refSource());
+		if (!source || source->named() != owner)
+			return false;
+
+		if (source->type() == Char(Nat(0))) {
+			// Through the lookup. Must not be virtual.
+			if (owner->ref().address() != owner->directRef().address())
+				return false;
+			lookup = true;
+			return true;
+		}
+
+		return source->type() == Char('d');
+	}
+
+	// Can 'block' be left before a call inside it without changing the behavior of the code?
+	static bool plainBlock(Listing *l, Block block) {
+		Array<Listing::CatchInfo> *catchInfo = l->catchInfo(block);
+		if (catchInfo && catchInfo->any())
+			return false;
+
+		Array<Var> *vars = l->allVars(block);
+		for (Nat i = 0; i < vars->count(); i++)
+			if (l->freeFn(vars->at(i)).any())
+				return false;
+
+		return true;
+	}
+
+	// Can the code of 'l' be restarted by assigning new values to the parameters?
+	static bool restartable(Listing *l, Array<Bool> *zero) {
+		if (l->empty() || l->at(0)->op() != op::prolog)
+			return false;
+
+		if (!as<PrimitiveDesc>(l->result))
+			return false;
+
+		Array<Var> *params = l->allParams();
+		for (Nat i = 0; i < params->count(); i++)
+			if (!as<PrimitiveDesc>(l->paramDesc(params->at(i))))
+				return false;
+
+		// Variables in the root block are not zeroed again when we jump to the start. Make sure we
+		// are able to do that ourselves.
+		Array<Var> *vars = l->allVars(l->root());
+		for (Nat i = 0; i < vars->count(); i++) {
+			Var v = vars->at(i);
+			if (l->isParam(v) || !zero->at(v.key()))
+				continue;
+
+			Size s = v.size();
+			if (s != Size::sByte && s != Size::sInt && s != Size::sLong && s != Size::sPtr)
+				return false;
+		}
+
+		return plainBlock(l, l->root());
+	}
+
+	// Find the position of all labels in 'l'.
+	static Array<Nat> *labelPositions(Listing *l) {
+		Array<Nat> *result = new (l) Array<Nat>();
+		for (Nat i = 0; i <= l->count(); i++) {
+			Array<Label> *labels = l->labels(i);
+			if (!labels)
+				continue;
+
+			for (Nat j = 0; j < labels->count(); j++) {
+				Nat key = labels->at(j).key();
+				while (result->count() <= key)
+					result->push(l->count());
+				result->at(key) = i;
+			}
+		}
+		return result;
+	}
+
+	// Is the result of the call at 'pos', stored in 'result', returned without being modified?
+	static bool tailPosition(Listing *l, Array<Nat> *labels, Nat pos, Operand result) {
+		for (Nat steps = 0; steps < tailScan; steps++) {
+			if (++pos >= l->count())
+				return false;
+
+			Instr *instr = l->at(pos);
+			switch (instr->op()) {
+			case op::endBlock:
+				if (!plainBlock(l, instr->src().block()))
+					return false;
+				break;
+			case op::jmp:
+				if (instr->dest().type() != opLabel || instr->src().condFlag() != ifAlways)
+					return false;
+				if (instr->dest().label().key() >= labels->count())
+					return false;
+				// Continue from the label.
+				pos = labels->at(instr->dest().label().key()) - 1;
+				break;
+			case op::mov:
+				if (result.empty() || instr->src() != result || instr->dest().type() != opVariable)
+					return false;
+				result = instr->dest();
+				break;
+			case op::fnRet:
+				return instr->src() == result;
+			default:
+				return false;
+			}
+		}
+
+		return false;
+	}
+
+	Listing *tailCalls(Function *owner, Listing *src, Array<Function *> *depends) {
+		Array<Bool> *zero = zeroVars(src);
+		if (!restartable(src, zero))
+			return src;
+
+		Array<Var> *formals = src->allParams();
+		Nat count = formals->count();
+		Array<Nat> *labels = labelPositions(src);
+
+		// Find calls to replace, and the block they are located in.
+		Array<Block> *calls = new (src) Array<Block>(src->count(), Block());
+		Array<Bool> *params = new (src) Array<Bool>(src->count(), false);
+		Array<Block> *current = new (src) Array<Block>(1, src->root());
+		Bool lookup = false;
+		Bool any = false;
+
+		for (Nat i = 0; i < src->count(); i++) {
+			Instr *instr = src->at(i);
+			if (instr->op() == op::beginBlock) {
+				current->push(instr->src().block());
+				continue;
+			} else if (instr->op() == op::endBlock) {
+				if (current->count() > 1)
+					current->pop();
+				continue;
+			}
+
+			Bool throughLookup = false;
+			if (!selfCall(owner, instr, throughLookup))
+				continue;
+
+			// Parameters must immediately precede the call.
+			if (count > i)
+				continue;
+
+			bool ok = true;
+			for (Nat j = 0; j < count && ok; j++) {
+				Nat at = i - count + j;
+				Instr *param = src->at(at);
+				ok &= param->op() == op::fnParam;
+				ok &= param->src().size() == formals->at(j).size();
+				if (j > 0)
+					ok &= src->labels(at) == null;
+			}
+			if (count > 0)
+				ok &= src->labels(i) == null;
+
+			// We leave all active blocks before the call.
+			for (Nat j = 1; j < current->count() && ok; j++)
+				ok &= plainBlock(src, current->at(j));
+
+			if (!ok || !tailPosition(src, labels, i, instr->dest()))
+				continue;
+
+			for (Nat j = 0; j < count; j++)
+				params->at(i - count + j) = true;
+			calls->at(i) = current->last();
+			lookup |= throughLookup;
+			any = true;
+		}
+
+		if (!any)
+			return src;
+
+		if (lookup)
+			depends->push(owner);
+
+		Listing *dest = src->createShell();
+		Label start = dest->label();
+		Block root = dest->root();
+
+		// Parameters to the current call, stored in temporary variables so that parameters may
+		// refer to each other.
+		Array<Var> *temps = new (src) Array<Var>();
+		for (Nat i = 0; i < count; i++)
+			temps->push(dest->createVar(root, formals->at(i).size()));
+
+		Nat param = 0;
+		for (Nat i = 0; i < src->count(); i++) {
+			if (Array<Label> *l = src->labels(i))
+				for (Nat j = 0; j < l->count(); j++)
+					*dest << l->at(j);
+
+			Instr *instr = src->at(i);
+			if (params->at(i)) {
+				*dest << mov(temps->at(param++), instr->src());
+			} else if (calls->at(i) != Block()) {
+				for (Nat j = 0; j < count; j++)
+					*dest << mov(formals->at(j), temps->at(j));
+
+				// The prolog zeroed these variables the first time.
+				Array<Var> *vars = src->allVars(src->root());
+				for (Nat j = 0; j < vars->count(); j++) {
+					Var v = vars->at(j);
+					if (!src->isParam(v) && zero->at(v.key()))
+						*dest << mov(v, xConst(v.size(), 0));
+				}
+
+				if (calls->at(i) == root)
+					*dest << jmp(start);
+				else
+					*dest << jmpBlock(start, root);
+				param = 0;
+			} else {
+				*dest << instr;
+			}
+
+			// The start of the function body is right after the prolog.
+			if (i == 0)
+				*dest << start;
+		}
+
+		if (Array<Label> *l = src->labels(src->count()))
+			for (Nat j = 0; j < l->count(); j++)
+				*dest << l->at(j);
+
+		return dest;
+	}
+
+}
@@ -0,0 +1,33 @@
+#pragma once
+#include "Code/Listing.h"
+#include "Core/Array.h"
+
+namespace storm {
+	STORM_PKG(core.lang);
+
+	class Function;
+
+	/**
+	 * Elimination of recursive calls in tail position.
+	 *
+	 * A call from a function to itself is replaced with a jump to the start of the function if the
+	 * result of the call is returned directly, so that deep recursion does not use any additional
+	 * stack space. This is done on the listings produced by the code generation, so it works for
+	 * all languages that use LazyCode. A call is replaced if:
+	 *
+	 * - the call is made through the lookup of the function, and the function is not virtual, or
+	 *   directly to the code of the function.
+	 * - all parameters, and the result, are primitive types.
+	 * - the result of the call is returned without being modified, possibly after leaving blocks
+	 *   and jumping to other labels.
+	 * - none of the blocks that are active at the call have variables with destructors or catch
+	 *   exceptions. Leaving these blocks before the call would otherwise change the order in which
+	 *   things happen.
+	 *
+	 * Calls through the lookup depend on the function not being overridden. In that case, 'owner'
+	 * is added to 'depends', so that the code is compiled again if it is overridden (see
+	 * InlineInfo).
+	 */
+	code::Listing *STORM_FN tailCalls(Function *owner, code::Listing *src, Array<Function *> *depends);
+
+}
@@ -964,6 +964,10 @@ namespace storm {
 		return myGcType;
 	}
 
+	Offset Type::gcTypeOffset() {
+		return Offset(OFFSET_OF(Type, myGcType));
+	}
+
 	const GcType *Type::gcArrayType() {
 		if (value()) {
 			return gcType();
@@ -137,6 +137,10 @@ namespace storm {
 		// needed. For values, this is the same as gcArrayType.
 		const GcType *CODECALL gcType();
 
+		// Offset of the pointer to the GcType inside Type objects, so that generated code can read
+		// it without calling 'gcType'. The pointer is null until the GcType has been created.
+		static Offset gcTypeOffset();
+
 		// Get the raw GcType for arrays of this type. Usually, the handle is preferred, but
 		// sometimes in early boot that is not possible.
 		const GcType *CODECALL gcArrayType();
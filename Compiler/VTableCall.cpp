@@ -47,7 +47,7 @@ namespace storm {
 		Listing *l = new (this) Listing();
 		*l << mov(ptrA, engine().arena()->firstParamLoc(id));
 		*l << mov(ptrA, ptrRel(ptrA, Offset()));
-		*l << jmp(ptrRel(ptrA, Offset::sPtr * offset));
+		*l << jmp(vtableSlotRef(l, cppSlot(offset)));
 
 		Binary *b = new (this) Binary(engine().arena(), l);
 		entry = new (this) VTableSource(cppSlot(offset), id, b);
@@ -64,14 +64,28 @@ namespace storm {
 		Listing *l = new (this) Listing();
 		*l << mov(ptrA, engine().arena()->firstParamLoc(id));
 		*l << mov(ptrA, ptrRel(ptrA, Offset()));
-		*l << mov(ptrA, ptrRel(ptrA, -Offset::sPtr * vtable::extraOffset));
-		*l << jmp(ptrRel(ptrA, Offset::sPtr * (offset + 2))); // 2 for the 2 size_t members in arrays.
+		*l << jmp(vtableSlotRef(l, stormSlot(offset)));
 
 		Binary *b = new (this) Binary(engine().arena(), l);
 		entry = new (this) VTableSource(stormSlot(offset), id, b);
 		return entry;
 	}
 
+	code::Operand vtableSlotRef(code::Listing *to, VTableSlot slot) {
+		using namespace code;
+
+		switch (slot.type) {
+		case VTableSlot::tCpp:
+			return ptrRel(ptrA, Offset::sPtr * slot.offset);
+		case VTableSlot::tStorm:
+			*to << mov(ptrA, ptrRel(ptrA, -Offset::sPtr * vtable::extraOffset));
+			return ptrRel(ptrA, Offset::sPtr * (slot.offset + 2)); // 2 for the 2 size_t members in arrays.
+		default:
+			assert(false, L"Unknown slot type.");
+			return Operand();
+		}
+	}
+
 	VTableSource::VTableSource(VTableSlot slot, Nat id, code::Content *c) : RefSource(c), slot(slot), id(id) {}
 
 	Str *VTableSource::title() const {
@@ -3,6 +3,7 @@
 #include "Value.h"
 #include "Core/Array.h"
 #include "Code/RefSource.h"
+#include "Code/Listing.h"
 
 namespace storm {
 	STORM_PKG(core.lang);
@@ -39,6 +40,11 @@ namespace storm {
 	};
 
 
+	// Emit code that finds 'slot' in the vtable in 'ptrA'. Returns an operand that refers to the
+	// function pointer in the slot. Clobbers 'ptrA'.
+	code::Operand vtableSlotRef(code::Listing *to, VTableSlot slot);
+
+
 	/**
 	 * Custom reference sources for the vtable thunks.
 	 */
@@ -49,6 +55,9 @@ namespace storm {
 
 		virtual Str *STORM_FN title() const;
 
+		// Get the slot called.
+		inline VTableSlot STORM_FN vtableSlot() const { return slot; }
+
 	private:
 		VTableSlot slot;
 		Nat id;
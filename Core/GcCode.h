@@ -54,6 +54,9 @@ namespace storm {
 			// pointer to the location that shall be updated. Architecture specific.
 			unwindInfo = 0x70,
 
+			// Update an entry in the PerfMap. 'pointer' is a handle returned from the PerfMap.
+			perfMap = 0x80,
+
 			// ...
 		};
 
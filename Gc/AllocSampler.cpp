@@ -0,0 +1,107 @@
+#include "stdafx.h"
+#include "AllocSampler.h"
+#include "Gc.h"
+
+namespace storm {
+
+	AllocSampler::AllocSampler(Gc &owner)
+		: owner(owner), interval(std::numeric_limits<size_t>::max()), counter(0),
+		  types(null), typesCapacity(0), typesRoot(null) {}
+
+	AllocSampler::~AllocSampler() {
+		Gc::destroyRoot(typesRoot);
+		delete []types;
+	}
+
+	void AllocSampler::reset(size_t interval) {
+		util::Lock::L z(lock);
+		this->interval = interval;
+		counter = 0;
+		data.clear();
+		index.clear();
+		for (size_t i = 0; i < typesCapacity; i++)
+			types[i] = null;
+	}
+
+	vector<AllocSampler::Site> AllocSampler::sites() {
+		util::Lock::L z(lock);
+		return data;
+	}
+
+	static size_t hashTrace(const ::StackTrace &trace) {
+		size_t r = 5381;
+		for (nat i = 0; i < trace.count(); i++) {
+			r = ((r << 5) + r) + size_t(trace[i].fnBase);
+			r = ((r << 5) + r) + size_t(trace[i].offset);
+		}
+		return r;
+	}
+
+	static bool sameTrace(const ::StackTrace &a, const ::StackTrace &b) {
+		if (a.count() != b.count())
+			return false;
+
+		for (nat i = 0; i < a.count(); i++) {
+			if (a[i].fnBase != b[i].fnBase || a[i].offset != b[i].offset || a[i].id != b[i].id)
+				return false;
+		}
+
+		return true;
+	}
+
+	void AllocSampler::sample(const GcType *type) {
+		// Another thread may have taken the sample already.
+		size_t now = counter;
+		size_t step = interval;
+		size_t samples = now / step;
+		if (samples == 0)
+			return;
+		counter = now % step;
+
+		// Capture the trace without holding the lock, it is the expensive part. We skip this
+		// function, so that the trace starts inside the Gc.
+		::StackTrace trace = ::stackTrace(1);
+		size_t hash = hashTrace(trace);
+
+		util::Lock::L z(lock);
+
+		std::pair<Index::iterator, Index::iterator> range = index.equal_range(hash);
+		for (Index::iterator i = range.first; i != range.second; ++i) {
+			Site &site = data[i->second];
+			if (site.type == type->type && site.kind == type->kind && sameTrace(site.trace, trace)) {
+				site.samples += samples;
+				site.bytes += samples * step;
+				return;
+			}
+		}
+
+		add(type->type, type->kind, trace, hash, samples);
+	}
+
+	void AllocSampler::add(Type *type, size_t kind, const ::StackTrace &trace, size_t hash, size_t samples) {
+		size_t id = data.size();
+
+		if (id >= typesCapacity) {
+			size_t capacity = max(size_t(16), typesCapacity * 2);
+			Type **t = new Type *[capacity];
+			for (size_t i = 0; i < capacity; i++)
+				t[i] = i < typesCapacity ? types[i] : null;
+
+			// Create the new root before removing the old one, so that the types are always reachable.
+			GcRoot *root = owner.createRoot(t, capacity, true);
+			Gc::destroyRoot(typesRoot);
+			delete []types;
+
+			types = t;
+			typesCapacity = capacity;
+			typesRoot = root;
+		}
+
+		types[id] = type;
+
+		Site site = { type, kind, trace, samples, samples * interval };
+		data.push_back(site);
+		index.insert(std::make_pair(hash, id));
+	}
+
+}
@@ -0,0 +1,102 @@
+#pragma once
+#include "Utils/Lock.h"
+#include "Utils/StackTrace.h"
+#include "Core/GcType.h"
+
+namespace storm {
+
+	class Gc;
+	class GcRoot;
+
+	/**
+	 * Sampling allocation profiler.
+	 *
+	 * While enabled, the Gc reports the size of each allocation made through 'alloc' and
+	 * 'allocArray' to the sampler. Each time 'interval' bytes have been allocated, the sampler
+	 * records a stack trace of the current allocation. Samples are aggregated by the type of the
+	 * allocated object and the stack trace, so the memory used only depends on the number of
+	 * distinct allocation sites.
+	 *
+	 * The byte counter is not updated atomically, since that would make all allocations noticeably
+	 * slower when multiple threads allocate at the same time. Lost updates only make the samples
+	 * slightly less regular.
+	 */
+	class AllocSampler {
+	public:
+		// Create.
+		AllocSampler(Gc &owner);
+
+		// Destroy.
+		~AllocSampler();
+
+		// Called for each allocation.
+		inline void allocated(const GcType *type, size_t size) {
+			counter += size;
+			if (counter >= interval)
+				sample(type);
+		}
+
+		// Start over with a new interval, discarding all samples.
+		void reset(size_t interval);
+
+		/**
+		 * Samples from a single allocation site.
+		 */
+		struct Site {
+			// Type of the allocated objects. May be null for allocations not associated with a type.
+			Type *type;
+
+			// Kind of the allocations (GcType::Kind).
+			size_t kind;
+
+			// Stack trace of the allocations.
+			::StackTrace trace;
+
+			// Number of samples.
+			size_t samples;
+
+			// Estimated number of bytes allocated.
+			size_t bytes;
+		};
+
+		// Get all sites sampled so far.
+		vector<Site> sites();
+
+	private:
+		// No copy.
+		AllocSampler(const AllocSampler &o);
+		AllocSampler &operator =(const AllocSampler &o);
+
+		// Owner.
+		Gc &owner;
+
+		// Lock for the data below.
+		util::Lock lock;
+
+		// Number of bytes between samples.
+		size_t interval;
+
+		// Number of bytes allocated since the last sample.
+		size_t counter;
+
+		// Sites.
+		vector<Site> data;
+
+		// Index of sites, based on a hash of the stack trace.
+		typedef std::multimap<size_t, size_t> Index;
+		Index index;
+
+		// Types of all sites, in the same order as 'data'. Allocated separately and registered as
+		// a root, so that types are kept alive as long as they are referred to by a sample.
+		Type **types;
+		size_t typesCapacity;
+		GcRoot *typesRoot;
+
+		// Record a sample.
+		void sample(const GcType *type);
+
+		// Add a site.
+		void add(Type *type, size_t kind, const ::StackTrace &trace, size_t hash, size_t samples);
+	};
+
+}
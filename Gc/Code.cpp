@@ -2,6 +2,7 @@
 #include "Code.h"
 #include "Gc.h"
 #include "Core/GcCode.h"
+#include "PerfMap.h"
 
 #include "CodeX86.h"
 #include "CodeX64.h"
@@ -47,6 +48,10 @@ namespace storm {
 				ptr = size_t(&ref.pointer);
 				shortUnalignedAtomicWrite(*(nat *)write, nat(ptr - (size_t(write) + sizeof(nat))));
 				break;
+			case GcCodeRef::perfMap:
+				if (ref.pointer)
+					PerfMap::update(ref.pointer, code);
+				break;
 			default:
 				// Pass on to the architecture specific parts:
 				ARCH::writePtr(code, refs, id);
@@ -69,6 +74,17 @@ namespace storm {
 		}
 
 		void finalize(void *code) {
+			GcCode *refs = Gc::codeRefs(code);
+			for (size_t i = 0; i < refs->refCount; i++) {
+				GcCodeRef &ref = refs->refs[i];
+				if (ref.kind == GcCodeRef::perfMap && ref.pointer) {
+					PerfMap::Handle h = ref.pointer;
+					// Set it to null so we do not accidentally update or free it again.
+					atomicWrite(ref.pointer, null);
+					perfMap().remove(h);
+				}
+			}
+
 			ARCH::finalize(code);
 		}
 
@@ -155,7 +155,7 @@ namespace storm {
 		return false;
 	}
 
-	GcImpl::GcImpl(size_t, nat) {}
+	GcImpl::GcImpl(size_t, nat, bool) {}
 
 	void GcImpl::destroy() {}
 
@@ -165,6 +165,16 @@ namespace storm {
 		return s;
 	}
 
+	GcHistory GcImpl::history() {
+		return GcHistory();
+	}
+
+	void GcImpl::setGoals(const GcGoals &goals) {}
+
+	Nat GcImpl::setWorkers(Nat count) {
+		return 0;
+	}
+
 	void GcImpl::collect() {
 		verify();
 	}
@@ -206,6 +216,16 @@ namespace storm {
 		return fmt::initWeakArray(mem, type, size, count);
 	}
 
+	GcInlineAlloc GcImpl::inlineAlloc() {
+		// Not supported. All allocations go through the pool, so that they may be checked.
+		return GcInlineAlloc();
+	}
+
+	void *GcImpl::inlineTrapped(const GcType *type, void *object) {
+		assert(false, L"Inline allocations are not supported.");
+		return alloc(type);
+	}
+
 	Bool GcImpl::liveObject(RootObject *obj) {
 		return true;
 	}
@@ -1,6 +1,7 @@
 #include "stdafx.h"
 #include "Gc.h"
 #include "Utils/Memory.h"
+#include "PerfMap.h"
 
 #ifndef STORM_GC
 #error "This file must be compiled from the Gc project!"
@@ -19,14 +20,17 @@ namespace storm {
 	}
 
 	struct ImplWrap : public GcImpl {
-		ImplWrap(Gc &owner, size_t initialArena, nat finalizationInterval)
-			: GcImpl(initialArena, finalizationInterval), owner(owner) {}
+		ImplWrap(Gc &owner, size_t initialArena, nat finalizationInterval, bool nearCode)
+			: GcImpl(initialArena, finalizationInterval, nearCode), owner(owner) {}
 
 		Gc &owner;
 	};
 
-	Gc::Gc(size_t initialArena, nat finalizationInterval)
-		: impl(new ImplWrap(*this, initialArena, finalizationInterval)), destroyed(false) {}
+	Gc::Gc(size_t initialArena, nat finalizationInterval, bool nearCode)
+		: impl(new ImplWrap(*this, initialArena, finalizationInterval, nearCode)), destroyed(false),
+		  sampler(null), samples(null), inlineKey(this) {
+		updateInlineKey();
+	}
 
 	Gc::~Gc() {
 		destroy();
@@ -38,6 +42,17 @@ namespace storm {
 			return;
 		destroyed = true;
 
+		// Generated code may not use the allocation buffers anymore.
+		inlineKey = this;
+
+		{
+			// The samples refer to roots, so they need to be removed before the roots.
+			util::Lock::L z(samplerLock);
+			sampler = null;
+			delete samples;
+			samples = null;
+		}
+
 		{
 			util::Lock::L z(threadLock);
 			for (ThreadMap::iterator i = threads.begin(); i != threads.end(); ++i) {
@@ -72,12 +87,71 @@ namespace storm {
 		return impl->summary();
 	}
 
+	GcHistory Gc::history() {
+		return impl->history();
+	}
+
+	void Gc::setGoals(const GcGoals &goals) {
+		impl->setGoals(goals);
+	}
+
+	Nat Gc::setWorkers(Nat count) {
+		return impl->setWorkers(count);
+	}
+
+	void Gc::sampleAllocations(size_t interval) {
+		util::Lock::L z(samplerLock);
+
+		if (interval == 0) {
+			sampler = null;
+			updateInlineKey();
+			return;
+		}
+
+		if (!samples)
+			samples = new AllocSampler(*this);
+		samples->reset(interval);
+		sampler = samples;
+		updateInlineKey();
+	}
+
+	GcInlineAlloc Gc::inlineAlloc() {
+		GcInlineAlloc r = impl->inlineAlloc();
+		r.key = &inlineKey;
+		return r;
+	}
+
+	void *Gc::inlineTrapped(const GcType *type, void *object) {
+		return impl->inlineTrapped(type, object);
+	}
+
+	void Gc::updateInlineKey() {
+		// Allocations need to go through 'alloc' to be sampled.
+		GcInlineAlloc r = impl->inlineAlloc();
+		if (r.supported && !sampler)
+			inlineKey = r.owner;
+		else
+			inlineKey = this;
+	}
+
+	vector<AllocSampler::Site> Gc::allocSamples() {
+		util::Lock::L z(samplerLock);
+		if (samples)
+			return samples->sites();
+		return vector<AllocSampler::Site>();
+	}
+
 	void Gc::collect() {
 		impl->collect();
+		if (perfMap().enabled())
+			perfMap().flush();
 	}
 
 	bool Gc::collect(nat time) {
-		return impl->collect(time);
+		bool r = impl->collect(time);
+		if (perfMap().enabled())
+			perfMap().flush();
+		return r;
 	}
 
 	void Gc::attachThread() {
@@ -25,6 +25,7 @@
 #include "Format.h" // for fmt::wordAlign
 #include "SampleImpl.h"
 #include "Root.h"
+#include "AllocSampler.h"
 
 #ifdef STORM_GC
 
@@ -68,7 +69,9 @@ namespace storm {
 		// 'initialArenaSize' - an initial estimate of the arena size. May be disregarded by the gc if needed.
 		// 'finalizationInterval' - how seldom the gc should check for finalizations. An interval of 500 means
 		//                          every 500 allocations.
-		Gc(size_t initialArenaSize, nat finalizationInterval);
+		// 'nearCode' - try to place code close to the executable, so that calls between code and the
+		//              executable fit in 32-bit displacements. Only supported by SMM on 64-bit systems.
+		Gc(size_t initialArenaSize, nat finalizationInterval, bool nearCode = true);
 
 		// Destroy.
 		~Gc();
@@ -79,6 +82,19 @@ namespace storm {
 		// Memory information.
 		MemorySummary summary();
 
+		// Information about recent collections. Implementations that do not keep track of their
+		// collections return an empty history.
+		GcHistory history();
+
+		// Set goals for the pause times and overhead of collections. Implementations that do not
+		// resize their generations ignore the goals.
+		void setGoals(const GcGoals &goals);
+
+		// Set the number of additional threads used for parallel phases of collections. Returns
+		// the previous number. Implementations that do not collect in parallel ignore the value
+		// and return zero.
+		Nat setWorkers(Nat count);
+
 
 		/**
 		 * Manual garbage collection hints.
@@ -88,9 +104,14 @@ namespace storm {
 		void collect();
 
 		// Spend approx 'time' ms on an incremental collection if possible. Returns true if there is more to do.
+		//
+		// Note: 'time' only limits how much work is started by each call. It does not bound the length
+		// of the pause. Each call stops the world for at least one step of the collection, and a
+		// step may take longer than 'time'. For example, SMM collects one generation per step, and
+		// the last two (largest) generations in a single step.
 		bool collect(Nat time);
 
-		// TODO: Add interface for managing pause times and getting information about allocations.
+		// TODO: Add interface for managing pause times.
 
 
 		/**
@@ -122,6 +143,9 @@ namespace storm {
 				|| type->kind == GcType::tFixedObj,
 				L"Wrong type for calling alloc().");
 
+			if (AllocSampler *s = sampler)
+				s->allocated(type, type->stride);
+
 			return impl->alloc(type);
 		}
 
@@ -146,6 +170,9 @@ namespace storm {
 		inline void *allocArray(const GcType *type, size_t count) {
 			assert(type->kind == GcType::tArray, L"Wrong type for calling allocArray().");
 
+			if (AllocSampler *s = sampler)
+				s->allocated(type, type->stride * count);
+
 			return impl->allocArray(type, count);
 		}
 
@@ -154,6 +181,15 @@ namespace storm {
 			return impl->allocWeakArray(&weakArrayType, count);
 		}
 
+		// Describe how generated code may allocate objects without calling 'alloc'. See
+		// GcInlineAlloc for details. The description does not change, but inline allocations are
+		// disabled through 'key' while allocations are sampled.
+		GcInlineAlloc inlineAlloc();
+
+		// Called from generated code when the inline allocation of 'object' (a client pointer) of
+		// 'type' failed to commit. Returns the object to use instead.
+		void *inlineTrapped(const GcType *type, void *object);
+
 		// See if the object is live. An object is considered live until it has been
 		// finalized. Finalized objects may not be collected immediately after they have been
 		// finalized, and therefore they may still appear inside weak sets etc. after that. The GC
@@ -239,6 +275,20 @@ namespace storm {
 		};
 
 
+		/**
+		 * Sampling of allocations, to find out where memory is allocated. See AllocSampler for
+		 * details.
+		 */
+
+		// Record the stack trace of one allocation for every 'interval' bytes allocated through
+		// 'alloc' and 'allocArray'. An interval of zero stops sampling. Samples are kept after
+		// sampling has been stopped, until sampling is started again.
+		void sampleAllocations(size_t interval);
+
+		// Get all allocation sites sampled so far.
+		vector<AllocSampler::Site> allocSamples();
+
+
 		/**
 		 * Iterate through all objects on the heap.
 		 *
@@ -355,6 +405,24 @@ namespace storm {
 
 		// Destroyed already?
 		Bool destroyed;
+
+		// Allocation sampler, if sampling is active. Only read once by 'alloc' and friends, so
+		// that it may be cleared while other threads are allocating.
+		AllocSampler *sampler;
+
+		// Allocation sampler, even if sampling has been stopped. Owned by us.
+		AllocSampler *samples;
+
+		// Lock for starting and stopping sampling.
+		util::Lock samplerLock;
+
+		// Word that generated code compares the owner of the thread-local allocation buffer
+		// against. Contains a pointer to this object, which never matches, while inline allocations
+		// are disabled.
+		const void *volatile inlineKey;
+
+		// Update 'inlineKey' to reflect the current state.
+		void updateInlineKey();
 	};
 
 
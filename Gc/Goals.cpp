@@ -0,0 +1,48 @@
+#include "stdafx.h"
+#include "Goals.h"
+
+namespace storm {
+
+	GcGoals::GcGoals() : pause(10), overhead(5) {}
+
+	GcGoals::GcGoals(nat pause, nat overhead) : pause(pause), overhead(overhead) {}
+
+	GcGenState::GcGenState()
+		: size(0), initialSize(0), minSize(0), maxSize(0), used(0),
+		  survival(0), pause(0), interval(0), shrinkForPause(true) {}
+
+	size_t adaptGenerationSize(const GcGoals &goals, const GcGenState &s) {
+		nat64 goal = nat64(goals.pause) * 1000;
+		nat64 interval = s.interval;
+		size_t size = s.size;
+
+		if (s.pause > goal) {
+			// Pauses are too long. Shrink in proportion to how far above the goal we are, but
+			// not to less than half the current size at once.
+			if (s.shrinkForPause)
+				size = max(size / 2, size_t(nat64(size) * goal / s.pause));
+		} else if (interval > 0 && s.pause * 100 > interval * goals.overhead) {
+			// We are collected too often. Doubling the size halves the number of
+			// collections. Only the time spent copying survivors is expected to grow with the
+			// size, the rest is spent scanning roots and other generations.
+			if (s.pause + s.pause * s.survival / 1024 <= goal)
+				size *= 2;
+		} else if (interval > 0 && s.pause * 100 * 4 < interval * goals.overhead) {
+			// We are collected rarely. Move back towards the initial size to keep the working
+			// set small.
+			if (size > s.initialSize)
+				size = max(s.initialSize, size - size / 4);
+		}
+
+		size = max(size, s.minSize);
+		size = min(size, s.maxSize);
+
+		// Never shrink below twice the used memory. Otherwise, the generation is full again
+		// shortly after each collection.
+		if (size < s.size)
+			size = max(size, min(s.size, s.used * 2));
+
+		return size;
+	}
+
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+namespace storm {
+
+	/**
+	 * Goals for garbage collectors that adapt the size of their generations to the program (SMM
+	 * at the moment). Set through 'Gc::goals'. Other collectors ignore them.
+	 */
+	class GcGoals {
+	public:
+		// Create, using the default goals.
+		GcGoals();
+
+		// Create.
+		GcGoals(nat pause, nat overhead);
+
+		// Goal for the time spent collecting a single generation, in milliseconds. Generations that
+		// take longer than this to collect are made smaller, and generations are only grown as long
+		// as the expected pause time stays below this value.
+		nat pause;
+
+		// Goal for the fraction of time spent collecting a generation, in percent of the time
+		// between collections. Generations that exceed this are grown so that they are collected
+		// less often. Generations that are well below it are shrunk towards their initial size, to
+		// improve cache locality.
+		nat overhead;
+	};
+
+
+	/**
+	 * The state of a generation after a collection, as needed to decide its new size.
+	 */
+	class GcGenState {
+	public:
+		GcGenState();
+
+		// Current size of the generation, and the size it was created with.
+		size_t size;
+		size_t initialSize;
+
+		// Limits for the size of the generation.
+		size_t minSize;
+		size_t maxSize;
+
+		// Number of bytes used after the collection.
+		size_t used;
+
+		// Fraction of the used bytes that usually survive a collection, in 1/1024:ths.
+		size_t survival;
+
+		// Usual time spent collecting the generation, in microseconds.
+		nat64 pause;
+
+		// Time between the last two collections, in microseconds. Zero if unknown.
+		nat64 interval;
+
+		// May the generation be shrunk because of long pauses? This does not help for generations
+		// whose survivors stay in the same generation (e.g. the last generations in SMM), since
+		// the pause is then mostly spent copying objects that are live anyway.
+		bool shrinkForPause;
+	};
+
+	// Compute the new size of a generation with the state 'state', given 'goals'.
+	size_t adaptGenerationSize(const GcGoals &goals, const GcGenState &state);
+
+}
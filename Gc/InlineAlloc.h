@@ -0,0 +1,63 @@
+#pragma once
+
+namespace storm {
+
+	/**
+	 * Description of the thread-local allocation buffers of a GC implementation, so that generated
+	 * code is able to allocate objects without calling into the GC in the common case. Acquired by
+	 * calling 'Gc::inlineAlloc'.
+	 *
+	 * Each thread has a buffer that contains three pointers: 'init', 'alloc' and 'limit'. The
+	 * memory between 'alloc' and 'limit' is free for the thread to use. An object described by a
+	 * GcType is allocated as follows:
+	 *
+	 * 1. Check that the GcType is of the kind 'tFixedObj' and that it does not have a finalizer.
+	 *    Other objects need to be allocated through 'Gc::alloc'.
+	 * 2. Check that the thread-local word at 'ownerTls' is equal to the word pointed to by
+	 *    'key'. Otherwise, the buffer may not be used by this thread (e.g. since the thread has not
+	 *    allocated anything yet, or since the buffer belongs to another Gc instance).
+	 * 3. Load a pointer to the buffer from the thread-local word at 'bufferTls'.
+	 * 4. Compute the size of the allocation as 'headerSize' + 'stride', rounded up to a multiple
+	 *    of 'align'. Then, reserve memory: if 'alloc' + size is above 'limit', fall back to
+	 *    'Gc::alloc'. Otherwise, increase 'alloc' by the size.
+	 * 5. Clear the memory, and store a pointer to the GcType in the first word of the allocation.
+	 * 6. Commit the allocation by setting 'init' to 'alloc'. If 'limit' is zero after that, the
+	 *    GC has interfered with the allocation, and 'Gc::inlineTrapped' must be called with the
+	 *    client pointer to get the object to use.
+	 *
+	 * The client pointer to the object is 'headerSize' bytes after the start of the allocation.
+	 * Thread-local words are accessed relative to the thread pointer, i.e. using the 'threadLocal'
+	 * prefix in the code backends.
+	 */
+	struct GcInlineAlloc {
+		GcInlineAlloc()
+			: supported(false), ownerTls(0), bufferTls(0), owner(0), key(0),
+			  initOffset(0), allocOffset(0), limitOffset(0), headerSize(0), align(0) {}
+
+		// Is inline allocation supported? If false, the other members are not valid.
+		bool supported;
+
+		// Offset of thread-local variables, relative to the thread pointer.
+		ptrdiff_t ownerTls;
+		ptrdiff_t bufferTls;
+
+		// The value stored in the owner variable when the thread-local buffer belongs to this GC
+		// instance. Filled in by the GC implementation.
+		const void *owner;
+
+		// Location of the word to compare the owner variable against. It contains 'owner' whenever
+		// inline allocations are allowed, and a value that never matches otherwise. Filled in by
+		// the Gc class.
+		const void *const volatile *key;
+
+		// Offset of the pointers inside the buffer.
+		size_t initOffset;
+		size_t allocOffset;
+		size_t limitOffset;
+
+		// Size of the object header, and alignment of allocations.
+		size_t headerSize;
+		size_t align;
+	};
+
+}
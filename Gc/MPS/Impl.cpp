@@ -23,6 +23,19 @@
 // Use the old scanning (for comparing performance)?
 // #define MPS_OLD_SCAN
 
+// Let generated code allocate from the allocation points of threads? Requires reaching thread-local
+// variables at a fixed offset from the thread pointer, which we only do on X86-64 Linux. The offset
+// is only fixed when the variables are in the executable itself ('initial-exec' is not reliable for
+// shared libraries loaded with dlopen), so inline allocations are disabled if the Gc is built as
+// position-independent code for a shared library (i.e. 'Gc+=pic' in .myproject). Executables built
+// as PIE define '__PIE__' as well, and are fine.
+#if defined(X64) && defined(POSIX) && (!defined(__PIC__) || defined(__PIE__)) && !FMT_CHECK_MEMORY && !MPS_CHECK_MEMORY
+#define MPS_INLINE_ALLOC
+#define MPS_INLINE_TLS __attribute__((tls_model("initial-exec")))
+#else
+#define MPS_INLINE_TLS
+#endif
+
 
 namespace storm {
 
@@ -516,7 +529,8 @@ namespace storm {
 		}
 	}
 
-	GcImpl::GcImpl(size_t initialArena, Nat finalizationInterval) : finalizationInterval(finalizationInterval) {
+	GcImpl::GcImpl(size_t initialArena, Nat finalizationInterval, bool nearCode)
+		: finalizationInterval(finalizationInterval), stepping(false) {
 		// We work under these assumptions.
 		fmt::init();
 		assert(vtable::allocOffset() >= sizeof(void *), L"Invalid vtable offset (initialization failed?)");
@@ -634,6 +648,10 @@ namespace storm {
 		// We want to receive finalization messages.
 		mps_message_type_enable(arena, mps_message_type_finalization());
 
+		// We also want to know when collections start and end, for the history.
+		mps_message_type_enable(arena, mps_message_type_gc_start());
+		mps_message_type_enable(arena, mps_message_type_gc());
+
 		// Add a root for exceptions in flight.
 		check(mps_root_create(&exRoot, arena, mps_rank_ambig(), (mps_rm_t)0, &mpsScanExceptions, null, 0),
 			L"Failed to create a root for the exceptions.");
@@ -692,6 +710,26 @@ namespace storm {
 		return MemorySummary();
 	}
 
+	GcHistory GcImpl::history() {
+		// Collections are only recorded when the messages from MPS are checked. Check them now, so
+		// that recent collections are included, unless someone else is doing that already.
+		if (atomicCAS(runningFinalizers, 0, 1) == 0) {
+			checkCollections();
+			atomicWrite(runningFinalizers, 0);
+		}
+
+		return telemetry.history();
+	}
+
+	void GcImpl::setGoals(const GcGoals &goals) {
+		// MPS sizes its generations according to the chain given to it at startup.
+	}
+
+	Nat GcImpl::setWorkers(Nat count) {
+		// MPS does not collect in parallel.
+		return 0;
+	}
+
 	void GcImpl::collect() {
 		mps_arena_collect(arena);
 		mps_arena_release(arena);
@@ -700,9 +738,20 @@ namespace storm {
 	}
 
 	Bool GcImpl::collect(nat time) {
+		// Start a full collection like SMM does. Otherwise, MPS only starts one if it thinks it
+		// can finish within 'time', so small values of 'time' would never do anything. When a
+		// collection is running, 'mps_arena_step' always advances it at least once.
+		if (!stepping) {
+			check(mps_arena_start_collect(arena), L"Failed to start a collection.");
+			stepping = true;
+		}
+
 		TODO(L"Better value for 'multiplier' here?");
 		// mps_bool_t != bool...
-		return mps_arena_step(arena, time / 1000.0, 1) ? true : false;
+		bool more = mps_arena_step(arena, time / 1000.0, 1) ? true : false;
+		if (!more)
+			stepping = false;
+		return more;
 	}
 
 	GcThread *GcImpl::attachThread() {
@@ -749,10 +798,15 @@ namespace storm {
 
 	// Thread-local variables for remembering the current thread's allocation point. We need some
 	// integrity checking to support the (rare) case of one thread allocating from different
-	// Engine:s. We do this by remembering which Gc-instance the saved ap is valid for.
-	static THREAD GcImpl *currentInfoOwner = null;
+	// Engine:s. We do this by remembering which Gc-instance the saved ap is valid for. Generated
+	// code also reads 'currentInfoOwner' and 'currentBuffer' below. See 'inlineAlloc'.
+	static THREAD GcImpl *currentInfoOwner MPS_INLINE_TLS = null;
 	static THREAD GcThread *currentInfo = null;
 
+	// The allocation point in 'currentInfo', so that generated code can reach it without
+	// knowing the layout of GcThread.
+	static THREAD mps_ap_t currentBuffer MPS_INLINE_TLS = null;
+
 	mps_ap_t &GcImpl::currentAllocPoint() {
 		GcThread *info = null;
 
@@ -769,6 +823,7 @@ namespace storm {
 				throw GcError(L"Trying to allocate memory from a thread not registered with the GC.");
 
 			currentInfo = info = thread;
+			currentBuffer = thread->ap;
 			currentInfoOwner = this;
 		}
 
@@ -812,6 +867,47 @@ namespace storm {
 		return result;
 	}
 
+#ifdef MPS_INLINE_ALLOC
+	// Find the offset of a thread-local variable of the current thread relative to the thread
+	// pointer. Variables declared with MPS_INLINE_TLS are in the static TLS block, so the offset
+	// is the same for all threads.
+	static ptrdiff_t threadPointerOffset(const void *var) {
+		const byte *tp;
+		__asm__("movq %%fs:0, %0" : "=r" (tp));
+		return (const byte *)var - tp;
+	}
+#endif
+
+	GcInlineAlloc GcImpl::inlineAlloc() {
+		GcInlineAlloc r;
+#ifdef MPS_INLINE_ALLOC
+		// Generated code follows the reserve/commit protocol of the 'mps_reserve' and
+		// 'mps_commit' macros. Note: since generated code does not go through
+		// 'currentAllocPoint', finalizers are only checked by allocations that reach 'alloc', for
+		// example when the allocation point needs to be refilled.
+		r.supported = true;
+		r.ownerTls = threadPointerOffset(&currentInfoOwner);
+		r.bufferTls = threadPointerOffset(&currentBuffer);
+		r.owner = this;
+		r.initOffset = OFFSET_OF(mps_ap_s, init);
+		r.allocOffset = OFFSET_OF(mps_ap_s, alloc);
+		r.limitOffset = OFFSET_OF(mps_ap_s, limit);
+		r.headerSize = headerSize;
+		r.align = headerSize;
+#endif
+		return r;
+	}
+
+	void *GcImpl::inlineTrapped(const GcType *type, void *object) {
+		// Generated code only uses 'currentBuffer' when it belongs to us.
+		Obj *o = fromClient(object);
+		if (mps_ap_trip(currentBuffer, o, sizeObj(type)))
+			return object;
+
+		// The allocation was lost. Try again through the usual path.
+		return alloc(type);
+	}
+
 	void *GcImpl::allocTypeObj(const GcType *type) {
 		assert(type->kind == GcType::tType, L"Wrong type for calling allocTypeObj().");
 		return allocStatic(type);
@@ -1022,15 +1118,71 @@ namespace storm {
 		atomicWrite(runningFinalizers, 0);
 	}
 
+	// Convert from MPS clock ticks to microseconds.
+	static nat64 clockToUs(mps_clock_t clock) {
+		nat64 perSec = nat64(mps_clocks_per_sec());
+		return nat64(clock / perSec) * 1000000 + nat64(clock % perSec) * 1000000 / perSec;
+	}
+
 	void GcImpl::checkFinalizersLocked() {
+		checkCollections();
+
 		mps_message_t message;
+		mps_clock_t start = 0;
+		bool any = false;
 		while (mps_message_get(&message, arena, mps_message_type_finalization())) {
+			if (!any)
+				start = mps_clock();
+			any = true;
+
 			mps_addr_t obj;
 			mps_message_finalization_ref(&obj, arena, message);
 			mps_message_discard(arena, message);
 
 			finalizeObject(obj);
 		}
+
+		if (any)
+			telemetry.finalized(clockToUs(mps_clock() - start));
+	}
+
+	void GcImpl::checkCollections() {
+		mps_message_t message;
+		while (mps_message_get(&message, arena, mps_message_type_gc_start())) {
+			gcStarts.push_back(mps_message_clock(arena, message));
+			mps_message_discard(arena, message);
+		}
+
+		while (mps_message_get(&message, arena, mps_message_type_gc())) {
+			mps_clock_t end = mps_message_clock(arena, message);
+			size_t live = mps_message_gc_live_size(arena, message);
+			size_t condemned = mps_message_gc_condemned_size(arena, message);
+			mps_message_discard(arena, message);
+
+			// MPS only tells us the size of the condemned set and how much of it survived. It does
+			// not tell us which generation was collected, how much was copied or promoted (objects
+			// referred to by ambiguous references stay in place), nor how many objects were
+			// pinned. These are left as zero.
+			// Collections are generally not overlapping, so the latest start before 'end' is the
+			// start of this collection. This also discards any starts whose end was lost.
+			size_t found = 0;
+			while (found < gcStarts.size() && gcStarts[found] <= end)
+				found++;
+
+			GcEvent event;
+			event.start = clockToUs(end);
+			if (found > 0) {
+				event.start = clockToUs(gcStarts[found - 1]);
+				gcStarts.erase(gcStarts.begin(), gcStarts.begin() + found);
+			}
+			event.duration = clockToUs(end) - event.start;
+			// Traces are incremental, so the mutator may have been running for most of
+			// 'duration'. MPS does not report how long the mutator was actually stopped.
+			event.pause = false;
+			event.scanned = condemned;
+			event.freed = condemned - min(condemned, live);
+			telemetry.collected(event);
+		}
 	}
 
 	// Allocation function used by the finalizer queue.
@@ -5,6 +5,9 @@
 
 #include "Lib.h"
 #include "Gc/MemorySummary.h"
+#include "Gc/Telemetry.h"
+#include "Gc/Goals.h"
+#include "Gc/InlineAlloc.h"
 #include "Gc/License.h"
 #include "Gc/Root.h"
 
@@ -28,7 +31,7 @@ namespace storm {
 	class GcImpl {
 	public:
 		// Create.
-		GcImpl(size_t initialArenaSize, Nat finalizationInterval);
+		GcImpl(size_t initialArenaSize, Nat finalizationInterval, bool nearCode);
 
 		// Destroy. This function is always called, but may be called twice.
 		void destroy();
@@ -36,6 +39,15 @@ namespace storm {
 		// Memory usage summary.
 		MemorySummary summary();
 
+		// History of recent collections.
+		GcHistory history();
+
+		// Set goals for the sizes of generations.
+		void setGoals(const GcGoals &goals);
+
+		// Set the number of additional threads used during collections. Returns the old value.
+		Nat setWorkers(Nat count);
+
 		// Do a full GC now.
 		void collect();
 
@@ -67,6 +79,14 @@ namespace storm {
 		// WeakArray with one pointer as elements.
 		void *allocWeakArray(const GcType *type, size_t count);
 
+		// Describe the thread-local allocation buffers used by 'alloc', so that generated code may
+		// allocate objects without calling 'alloc'. See GcInlineAlloc for details.
+		GcInlineAlloc inlineAlloc();
+
+		// Called when an inline allocation of 'type' at 'memory' failed to commit. Returns the
+		// client pointer of the object to use instead.
+		void *inlineTrapped(const GcType *type, void *object);
+
 		// See if an object is live, ie. not finalized.
 		static Bool liveObject(RootObject *obj);
 
@@ -165,6 +185,9 @@ namespace storm {
 		// Finalization interval (our copy).
 		nat finalizationInterval;
 
+		// Are we in the middle of an incremental collection started by 'collect(Nat)'?
+		bool stepping;
+
 		// Allocate an object in the Type pool.
 		void *allocTypeObj(const GcType *type);
 
@@ -187,6 +210,16 @@ namespace storm {
 		// Are we running finalizers at the moment? Used for synchronization.
 		volatile nat runningFinalizers;
 
+		// Recent collections. Updated from the messages posted by MPS, which are only checked
+		// together with finalizers.
+		GcTelemetry telemetry;
+
+		// Start times of collections we have not yet received the end of.
+		vector<mps_clock_t> gcStarts;
+
+		// Record any collections posted by MPS. Assumes exclusive access to the message stream.
+		void checkCollections();
+
 		// Struct used for GcTypes inside MPS. As it is not always possible to delete all GcType objects
 		// immediatly, we store the freed ones in an InlineSet until we can actually reclaim them.
 		struct MpsType : public os::SetMember<MpsType> {
@@ -0,0 +1,353 @@
+#include "stdafx.h"
+#include "PerfMap.h"
+#include "Gc.h"
+#include "Core/GcCode.h"
+
+#ifdef POSIX
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <time.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#endif
+
+namespace storm {
+
+#ifdef POSIX
+
+	/**
+	 * Records in the jitdump format, as described in 'tools/perf/Documentation/jitdump-specification.txt'
+	 * in the Linux source tree.
+	 */
+
+	static const nat jitMagic = 0x4A695444;
+	static const nat jitVersion = 1;
+
+	enum {
+		jitCodeLoad = 0,
+		jitCodeMove = 1,
+	};
+
+#if defined(X64)
+	static const nat jitMachine = 62; // EM_X86_64
+#elif defined(X86)
+	static const nat jitMachine = 3; // EM_386
+#else
+#error "Please specify the ELF machine type for your architecture!"
+#endif
+
+	struct JitHeader {
+		nat magic;
+		nat version;
+		nat totalSize;
+		nat elfMach;
+		nat pad1;
+		nat pid;
+		Word timestamp;
+		Word flags;
+	};
+
+	struct JitRecord {
+		nat id;
+		nat totalSize;
+		Word timestamp;
+	};
+
+	struct JitLoad {
+		JitRecord header;
+		nat pid;
+		nat tid;
+		Word vma;
+		Word codeAddr;
+		Word codeSize;
+		Word codeIndex;
+		// Followed by the name and the code.
+	};
+
+	struct JitMove {
+		JitRecord header;
+		nat pid;
+		nat tid;
+		Word vma;
+		Word oldCodeAddr;
+		Word newCodeAddr;
+		Word codeSize;
+		Word codeIndex;
+	};
+
+	// Perf expects the monotonic clock when 'perf record -k mono' is used.
+	static Word timestamp() {
+		struct timespec ts;
+		clock_gettime(CLOCK_MONOTONIC, &ts);
+		return Word(ts.tv_sec) * 1000000000 + Word(ts.tv_nsec);
+	}
+
+	static nat threadId() {
+		return nat(syscall(SYS_gettid));
+	}
+
+	// Write an entire buffer. Each call to 'write' with O_APPEND is atomic, so we only need to
+	// retry if we were interrupted.
+	static void writeAll(int fd, const void *data, size_t size) {
+		const byte *at = (const byte *)data;
+		while (size > 0) {
+			ssize_t r = ::write(fd, at, size);
+			if (r <= 0)
+				return;
+			at += r;
+			size -= r;
+		}
+	}
+
+	PerfMap::PerfMap() : moved(null), mapFd(-1), dumpFd(-1), dumpMap(null), nextIndex(0) {}
+
+	PerfMap::~PerfMap() {
+		if (dumpMap)
+			munmap(dumpMap, sysconf(_SC_PAGESIZE));
+		if (dumpFd >= 0)
+			close(dumpFd);
+		if (mapFd >= 0)
+			close(mapFd);
+	}
+
+	void PerfMap::open(bool jitdump) {
+		char map[64];
+		snprintf(map, sizeof(map), "/tmp/perf-%d.map", int(getpid()));
+		char dump[64];
+		snprintf(dump, sizeof(dump), "/tmp/jit-%d.dump", int(getpid()));
+
+		open(map, jitdump ? dump : null);
+	}
+
+	void PerfMap::open(const char *mapFile, const char *dumpFile) {
+		util::Lock::L z(lock);
+
+		if (mapFd >= 0)
+			return;
+
+		mapFd = ::open(mapFile, O_WRONLY | O_CREAT | O_TRUNC | O_APPEND, 0644);
+
+		if (!dumpFile)
+			return;
+
+		dumpFd = ::open(dumpFile, O_RDWR | O_CREAT | O_TRUNC | O_APPEND, 0644);
+		if (dumpFd < 0)
+			return;
+
+		JitHeader header = {
+			jitMagic,
+			jitVersion,
+			nat(sizeof(JitHeader)),
+			jitMachine,
+			0,
+			nat(getpid()),
+			timestamp(),
+			0,
+		};
+		writeAll(dumpFd, &header, sizeof(header));
+
+		// Perf finds the jitdump by looking for an executable mapping of it.
+		dumpMap = mmap(null, sysconf(_SC_PAGESIZE), PROT_READ | PROT_EXEC, MAP_PRIVATE, dumpFd, 0);
+		if (dumpMap == MAP_FAILED)
+			dumpMap = null;
+	}
+
+	PerfMap::Handle PerfMap::add(void *code, size_t size) {
+		util::Lock::L z(lock);
+
+		flushI();
+
+		Elem *e = new Elem;
+		e->code = code;
+		e->reported = code;
+		e->nextMoved = null;
+		e->queued = 0;
+		e->size = size;
+		e->index = nextIndex++;
+		e->name = null;
+		e->owner = this;
+		return e;
+	}
+
+	void PerfMap::name(void *code, const char *name) {
+		GcCode *refs = Gc::codeRefs(code);
+		Elem *e = null;
+		for (size_t i = 0; i < refs->refCount; i++)
+			if (refs->refs[i].kind == GcCodeRef::perfMap)
+				e = (Elem *)refs->refs[i].pointer;
+
+		if (!e)
+			return;
+
+		util::Lock::L z(lock);
+		flushI();
+
+		free(e->name);
+		e->name = strdup(name);
+		e->reported = atomicRead(e->code);
+
+		writeMap(e);
+		writeLoad(e);
+	}
+
+	void PerfMap::update(Handle handle, void *code) {
+		Elem *e = (Elem *)handle;
+		if (e->code == code)
+			return;
+
+		atomicWrite(e->code, code);
+
+		// Add it to the queue unless it is there already.
+		if (atomicCAS(e->queued, 0, 1) != 0)
+			return;
+
+		PerfMap *owner = e->owner;
+		Elem *head;
+		do {
+			head = atomicRead(owner->moved);
+			e->nextMoved = head;
+		} while (atomicCAS(owner->moved, head, e) != head);
+	}
+
+	void PerfMap::remove(Handle handle) {
+		util::Lock::L z(lock);
+
+		// The code is dead, so it will not be moved again. Make sure it is not in the queue.
+		flushI();
+
+		Elem *e = (Elem *)handle;
+		free(e->name);
+		delete e;
+	}
+
+	void PerfMap::flush() {
+		util::Lock::L z(lock);
+		flushI();
+	}
+
+	void PerfMap::flushI() {
+		Elem *e;
+		do {
+			e = atomicRead(moved);
+		} while (atomicCAS(moved, e, null) != e);
+
+		while (e) {
+			Elem *next = e->nextMoved;
+			e->nextMoved = null;
+			atomicWrite(e->queued, 0);
+
+			// Report the move. If the element is moved again after we read 'code', it is queued
+			// again, and reported in the next flush.
+			void *from = e->reported;
+			e->reported = atomicRead(e->code);
+			if (e->name && from != e->reported) {
+				writeMap(e);
+				writeMove(e, from);
+			}
+
+			e = next;
+		}
+	}
+
+	void PerfMap::writeMap(Elem *e) {
+		if (mapFd < 0)
+			return;
+
+		char line[512];
+		int len = snprintf(line, sizeof(line), "%zx %zx %s\n", size_t(e->reported), e->size, e->name);
+		if (len <= 0)
+			return;
+		if (size_t(len) >= sizeof(line)) {
+			// Truncated. Make sure the line ends properly.
+			len = sizeof(line);
+			line[len - 1] = '\n';
+		}
+
+		writeAll(mapFd, line, len);
+	}
+
+	void PerfMap::writeLoad(Elem *e) {
+		if (dumpFd < 0)
+			return;
+
+		size_t nameLen = strlen(e->name) + 1;
+		size_t total = sizeof(JitLoad) + nameLen + e->size;
+		byte *data = (byte *)malloc(total);
+		if (!data)
+			return;
+
+		JitLoad *load = (JitLoad *)data;
+		load->header.id = jitCodeLoad;
+		load->header.totalSize = nat(total);
+		load->header.timestamp = timestamp();
+		load->pid = nat(getpid());
+		load->tid = threadId();
+		load->vma = Word(e->reported);
+		load->codeAddr = Word(e->reported);
+		load->codeSize = e->size;
+		load->codeIndex = e->index;
+		memcpy(data + sizeof(JitLoad), e->name, nameLen);
+		memcpy(data + sizeof(JitLoad) + nameLen, e->reported, e->size);
+
+		writeAll(dumpFd, data, total);
+		free(data);
+	}
+
+	void PerfMap::writeMove(Elem *e, void *from) {
+		if (dumpFd < 0)
+			return;
+
+		JitMove move = {
+			{ jitCodeMove, nat(sizeof(JitMove)), timestamp() },
+			nat(getpid()),
+			threadId(),
+			Word(e->reported),
+			Word(from),
+			Word(e->reported),
+			e->size,
+			e->index,
+		};
+		writeAll(dumpFd, &move, sizeof(move));
+	}
+
+#else
+
+	PerfMap::PerfMap() : mapFd(-1), dumpFd(-1), dumpMap(null), nextIndex(0) {}
+
+	PerfMap::~PerfMap() {}
+
+	void PerfMap::open(bool jitdump) {}
+
+	void PerfMap::open(const char *mapFile, const char *dumpFile) {}
+
+	PerfMap::Handle PerfMap::add(void *code, size_t size) {
+		return null;
+	}
+
+	void PerfMap::name(void *code, const char *name) {}
+
+	void PerfMap::update(Handle handle, void *code) {}
+
+	void PerfMap::remove(Handle handle) {}
+
+	void PerfMap::flush() {}
+
+	void PerfMap::flushI() {}
+
+	void PerfMap::writeMap(Elem *e) {}
+
+	void PerfMap::writeLoad(Elem *e) {}
+
+	void PerfMap::writeMove(Elem *e, void *from) {}
+
+#endif
+
+	PerfMap &perfMap() {
+		static PerfMap t;
+		return t;
+	}
+
+}
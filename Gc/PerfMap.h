@@ -0,0 +1,115 @@
+#pragma once
+#include "Utils/Lock.h"
+
+namespace storm {
+
+	/**
+	 * Reports the location of generated code to the Linux profiler 'perf', so that samples in
+	 * generated code can be attributed to the function they belong to.
+	 *
+	 * Two formats are supported:
+	 * - perf map: a text file '/tmp/perf-<pid>.map' with one line "<start> <size> <name>" for each
+	 *   function. As the file is only read after profiling, code that has been moved by the GC
+	 *   appears multiple times. Perf only uses the last entry for each address.
+	 * - jitdump: a binary file '/tmp/jit-<pid>.dump' that also contains the code itself along with
+	 *   timestamps, so that moved code is properly accounted for. Use 'perf record -k mono' and
+	 *   'perf inject --jit' to use it.
+	 *
+	 * Each code allocation that is to be reported has an entry of type 'GcCodeRef::perfMap' that
+	 * contains a handle returned from 'add'. The GC calls 'update' whenever the code is moved, just
+	 * like for the CodeTable. Since that happens during collections, 'update' only queues the move,
+	 * and the queued moves are written by 'flush'. It is called by the other functions, and after
+	 * explicit collections. Code is not reported until it has been given a name.
+	 *
+	 * This is only implemented on POSIX systems. Elsewhere, 'open' does nothing.
+	 */
+	class PerfMap : NoCopy {
+	public:
+		// Create.
+		PerfMap();
+
+		// Destroy.
+		~PerfMap();
+
+		// Start writing the perf map, and the jitdump if 'jitdump' is true.
+		void open(bool jitdump);
+
+		// Start writing to the specified files. 'dumpFile' may be null. Mostly useful for testing.
+		void open(const char *mapFile, const char *dumpFile);
+
+		// Is the map enabled?
+		inline bool enabled() const { return mapFd >= 0; }
+
+		// A handle. Pointer-sized so that it fits inside 'GcCodeRef::pointer'.
+		typedef void *Handle;
+
+		// Start tracking a new piece of machine code. The code is not reported until 'name' is called.
+		Handle add(void *code, size_t size);
+
+		// Set the name of the code allocation 'code', and report it. Does nothing if 'code' does
+		// not contain a 'perfMap' entry.
+		void name(void *code, const char *name);
+
+		// Update the location of the handle. Called from inside the GC while other threads may be
+		// stopped, possibly while holding 'lock'. Therefore, this does not take the lock or make
+		// any system calls. Instead, the handle is queued until the next call to 'flush'.
+		static void update(Handle handle, void *code);
+
+		// Stop tracking a handle.
+		void remove(Handle handle);
+
+		// Report code that was moved since the last flush.
+		void flush();
+
+	private:
+		// An element.
+		struct Elem {
+			// Code allocation and size. 'code' is updated by 'update'.
+			void *volatile code;
+			size_t size;
+
+			// Location last reported to perf. Protected by 'lock'.
+			void *reported;
+
+			// Next element in the queue of moved elements, and whether we are in the queue.
+			Elem *nextMoved;
+			volatile nat queued;
+
+			// Unique index for jitdump.
+			size_t index;
+
+			// Name, or null if not yet reported.
+			char *name;
+
+			// Owner.
+			PerfMap *owner;
+		};
+
+		// Lock protecting 'add', 'name', 'remove' and 'flush'.
+		util::Lock lock;
+
+		// Elements moved since the last flush. Added to by 'update' without taking the lock.
+		Elem *volatile moved;
+
+		// Flush while holding the lock.
+		void flushI();
+
+		// Files. -1 if not open.
+		int mapFd;
+		int dumpFd;
+
+		// Mapping of the jitdump, so that perf finds it.
+		void *dumpMap;
+
+		// Next index.
+		size_t nextIndex;
+
+		// Write entries.
+		void writeMap(Elem *e);
+		void writeLoad(Elem *e);
+		void writeMove(Elem *e, void *from);
+	};
+
+	// Get a global instance of the perf map.
+	PerfMap &perfMap();
+}
@@ -44,6 +44,14 @@ namespace storm {
 			if (!into)
 				into = &owner;
 
+			// Very large objects get a chunk of their own, so that they don't need to be copied.
+			if (size >= largeObjectSize) {
+				Block *block = owner.arena.enter(*into, &Generation::largeBlock, size);
+				if (!block)
+					return PendingAlloc();
+				return PendingAlloc(block, size);
+			}
+
 			into->sharedBlockLock.lock();
 			Block *shared = owner.arena.enter(*into, &Generation::sharedBlock, size);
 			if (!shared)
@@ -142,7 +142,8 @@ namespace storm {
 			void fill(size_t desiredMin);
 			void fillI(ArenaTicket &entry, size_t desiredMin);
 
-			// Make a large allocation (in a higher-numbered generation).
+			// Make a large allocation (in a higher-numbered generation). Allocations larger than
+			// 'largeObjectSize' are placed in chunks of their own.
 			PendingAlloc allocLarge(size_t size);
 		};
 
@@ -11,13 +11,15 @@
 #include "Nonmoving.h"
 #include "ArenaTicket.h"
 #include "FinalizerPool.h"
+#include "WorkerPool.h"
+#include "Util.h"
 
 namespace storm {
 	namespace smm {
 
 		// TODO: Make the nursery generation size customizable.
-		Arena::Arena(size_t initialSize, const size_t *genSize, size_t generationCount)
-			: alloc(initialSize), entries(0), rampAttempts(0) {
+		Arena::Arena(size_t initialSize, const size_t *genSize, size_t generationCount, bool nearCode)
+			: alloc(initialSize, nearCode), entries(0), rampAttempts(0), incremental(0) {
 
 			// Check assumptions of the formatting code.
 			fmt::init();
@@ -33,6 +35,9 @@ namespace storm {
 			// Create the finalizer pool.
 			finalizers = new FinalizerPool(*this);
 
+			// Create the worker pool. Threads are started when they are first needed.
+			workers = new WorkerPool();
+
 			// Allocate the individual generations.
 			byte genId = firstFreeIdentifier;
 			generations = vector<Generation *>(generationCount + 1, null);
@@ -93,6 +98,9 @@ namespace storm {
 
 			delete nonmovingAllocs;
 			nonmovingAllocs = null;
+
+			delete workers;
+			workers = null;
 		}
 
 		Chunk Arena::allocChunk(size_t size, byte identifier) {
@@ -162,6 +170,53 @@ namespace storm {
 			}
 
 			swapLastGens();
+
+			// This finishes any incremental collection as well.
+			incremental = 0;
+		}
+
+		// Current time in ms, for measuring time spent collecting.
+		static size_t currentMs() {
+			return size_t(currentUs() / 1000);
+		}
+
+		bool Arena::collect(nat time) {
+			return enter(*this, &Arena::collectStepI, time);
+		}
+
+		bool Arena::collectStepI(ArenaTicket &entry, nat time) {
+			// Collect the generations in the same order as 'collectI' above. We check the time
+			// between each generation. Since generations are collected one at a time, the
+			// summaries and write barriers used to track references between generations keep
+			// working while the mutator runs between increments. Collections triggered by
+			// allocations in the meantime only cause the remaining steps to find less garbage.
+			size_t start = currentMs();
+			size_t last = generations.size() - 1;
+
+			// Nothing to split into steps.
+			if (last < 2) {
+				collectI(entry);
+				return false;
+			}
+
+			if (incremental == 0)
+				incremental = last;
+
+			do {
+				if (incremental == last) {
+					// The last two generations have to be collected together, followed by a
+					// swap. Otherwise they get out of sync (see 'collectI' with a GenSet).
+					generations[last - 1]->collect(entry);
+					generations[last - 2]->collect(entry);
+					swapLastGens();
+					incremental -= 2;
+				} else {
+					generations[incremental - 1]->collect(entry);
+					incremental--;
+				}
+			} while (incremental > 0 && currentMs() - start < time);
+
+			return incremental > 0;
 		}
 
 		// Collect the specified generation, but first see if there is enough free space in the
@@ -223,6 +278,32 @@ namespace storm {
 			generations[gens - 3]->next = generations[gens - 1];
 		}
 
+		nat Arena::generationNumber(const Generation *gen) const {
+			size_t last = generations.size() - 2;
+			for (size_t i = 0; i < last; i++)
+				if (generations[i] == gen)
+					return nat(i);
+			return nat(last);
+		}
+
+		bool Arena::lastGeneration(const Generation *gen) const {
+			size_t count = generations.size();
+			return gen == generations[count - 1] || gen == generations[count - 2];
+		}
+
+		void Arena::setGoals(const GcGoals &goals) {
+			util::Lock::L z(arenaLock);
+			this->goals = goals;
+		}
+
+		size_t Arena::setWorkers(size_t count) {
+			// The pool is only used while the arena lock is held.
+			util::Lock::L z(arenaLock);
+			size_t old = workers->threads() - 1;
+			workers->setWorkers(count);
+			return old;
+		}
+
 		MemorySummary Arena::summary() {
 			util::Lock::L z(arenaLock);
 
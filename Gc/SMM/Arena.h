@@ -8,6 +8,8 @@
 #include "GenSet.h"
 #include "History.h"
 #include "Gc/MemorySummary.h"
+#include "Gc/Telemetry.h"
+#include "Gc/Goals.h"
 #include "Utils/Templates.h"
 
 namespace storm {
@@ -21,6 +23,7 @@ namespace storm {
 		class LockTicket;
 		class ArenaTicket;
 		class FinalizerPool;
+		class WorkerPool;
 
 		/**
 		 * An Arena keeps track of all allocations made by the GC, and represents the entire world
@@ -46,7 +49,7 @@ namespace storm {
 			// Create the arena, initially try to reserve (but not commit) 'initialSize' bytes of
 			// memory for the arena. Also, create 'generationCount' generations, each with the
 			// specified size (in bytes).
-			Arena(size_t initialSize, const size_t *generations, size_t generationCount);
+			Arena(size_t initialSize, const size_t *generations, size_t generationCount, bool nearCode);
 
 			// Destroy.
 			~Arena();
@@ -92,6 +95,15 @@ namespace storm {
 			// Perform a full GC (API will most likely change).
 			void collect();
 
+			// Perform a full GC incrementally, spending approximately 'time' ms on it. Generations
+			// are collected one at a time, and the mutator runs between calls. Returns true if
+			// there are generations left to collect. Each generation is collected while the world
+			// is stopped, so pauses are not bounded by 'time'. In particular, the last two
+			// generations are collected in a single step.
+			// TODO: Split the collection of each generation into bounded slices of scanning and
+			// copying, and use the write barriers to find objects modified between slices.
+			bool collect(nat time);
+
 			// Begin/end ramp allocations.
 			void startRamp();
 			void endRamp();
@@ -102,6 +114,26 @@ namespace storm {
 			// Provide a memory summary. This traverses all objects, and is fairly expensive.
 			MemorySummary summary();
 
+			// Recent collections. Updated by the generations after each collection.
+			GcTelemetry telemetry;
+
+			// Get the number of a generation, as reported in GcEvent. Both copies of the last
+			// generation have the same number.
+			nat generationNumber(const Generation *gen) const;
+
+			// Is 'gen' one of the two copies of the last generation?
+			bool lastGeneration(const Generation *gen) const;
+
+			// Goals for the size of the generations. Read by the generations after each
+			// collection. Use 'setGoals' to change them.
+			GcGoals goals;
+
+			// Set the goals.
+			void setGoals(const GcGoals &goals);
+
+			// Set the number of additional threads used during collections. Returns the old value.
+			size_t setWorkers(size_t count);
+
 			// Check if an address is managed by this arena. Mostly useful for debugging.
 			// TODO: Should we lock the access to the VMAlloc instance?
 			inline bool has(void *addr) const { return alloc.has(addr); }
@@ -130,6 +162,10 @@ namespace storm {
 			// Remember which generations asked to be collected during the ramp mode.
 			size_t rampBlockedCollections;
 
+			// Progress of an incremental collection. The next generation to collect is the one
+			// before 'incremental', so zero means that no incremental collection is in progress.
+			size_t incremental;
+
 			// The generations in use. Objects are promoted from lower to higher numbered
 			// generations. Furthermore, we duplicate the last generation passed as a parameter to
 			// the constructor so that we can collect it more conveniently. Assuming two long-lived
@@ -143,6 +179,9 @@ namespace storm {
 			// Pool for storing objects that need finalization.
 			FinalizerPool *finalizers;
 
+			// Threads used to perform parts of collections in parallel.
+			WorkerPool *workers;
+
 			// Virtual memory allocations.
 			VMAlloc alloc;
 
@@ -158,6 +197,9 @@ namespace storm {
 			// Perform a garbage collection.
 			void collectI(ArenaTicket &e);
 
+			// Perform a step of an incremental garbage collection.
+			bool collectStepI(ArenaTicket &e, nat time);
+
 			// The ArenaTicket tells us we need to collect certain generations. Returns a GenSet
 			// describing the generations actually collected.
 			GenSet collectI(ArenaTicket &e, GenSet collect);
@@ -7,6 +7,7 @@
 #include "FinalizerPool.h"
 
 #include "Thread.h"
+#include "Util.h"
 
 namespace storm {
 	namespace smm {
@@ -129,6 +130,9 @@ namespace storm {
 			startThreads();
 			unlock();
 
+			// Only measure the time if we collected something, that is when finalizers are found.
+			nat64 start = gc ? currentUs() : 0;
+
 			{
 				FinalizerContext context;
 				// Note: Since references from finalizers keep nonmoving objects alive, but not the
@@ -136,6 +140,9 @@ namespace storm {
 				owner.nonmoving().runFinalizers(context);
 				owner.finalizers->finalize(context);
 			}
+
+			if (gc)
+				owner.telemetry.finalized(currentUs() - start);
 		}
 
 
@@ -107,6 +107,11 @@ namespace storm {
 				return owner.alloc.anyWrites(chunk);
 			}
 
+			// Move a chunk to another generation by changing its identifier.
+			inline void identifier(Chunk chunk, byte id) const {
+				owner.alloc.identifier(chunk, id);
+			}
+
 			// Note that objects have been moved from the specified range.
 			inline void objectsMovedFrom(const void *from, size_t size) {
 				objectsMoved = true;
@@ -138,6 +143,11 @@ namespace storm {
 				return *owner.finalizers;
 			}
 
+			// Get the threads used to perform parts of the collection in parallel.
+			inline WorkerPool &workers() const {
+				return *owner.workers;
+			}
+
 			// Get an addrset describing the full range currently reserved by the VM backend.
 			template <class AddrSet>
 			AddrSet reservedSet() const {
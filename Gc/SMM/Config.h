@@ -33,6 +33,31 @@ namespace storm {
 		static const size_t vmAllocBits = 16;
 		static const size_t vmAllocMinSize = 1 << vmAllocBits;
 
+		// Distance from the executable where we start looking for memory when we try to reserve
+		// memory within 2GiB of the executable (see 'nearCode' in VMAlloc). Leaves room for the
+		// heap of the C runtime, which is usually placed right after the executable.
+		static const size_t vmNearCodeGap = size_t(256) * 1024 * 1024;
+
+		// Objects at least this large (in bytes, including headers) are allocated in chunks of their
+		// own. These chunks are moved to the next generation as a whole when the object survives a
+		// collection, rather than copying the object. Should be at least 'vmAllocMinSize', as
+		// chunks are allocated in multiples of that size.
+		static const size_t largeObjectSize = vmAllocMinSize;
+
+		// Default maximum number of additional threads used to update references after a
+		// collection. Fewer threads are used if the system has fewer processors. Setting this to zero
+		// makes the collector single-threaded. Can be changed at runtime through 'Gc::setWorkers'.
+		static const size_t gcWorkers = 7;
+
+		// Generations are resized to meet the goals in GcGoals (see Gc/Goals.h), which are set at
+		// runtime through 'Gc::setGoals'.
+
+		// Limits for resizing generations, relative to the size they were created with. A
+		// generation is never smaller than 1/genShrinkLimit or larger than genGrowLimit times its
+		// initial size.
+		static const size_t genShrinkLimit = 4;
+		static const size_t genGrowLimit = 8;
+
 		// Maximum number of bits for use in generation identifiers. Enforced by VMAlloc.h.
 		static const size_t identifierBits = CHAR_BIT - 2;
 		static const byte identifierMaxVal = byte(1) << identifierBits;
@@ -17,14 +17,19 @@
 namespace storm {
 	namespace smm {
 
+		// Default block size for a generation of 'size' bytes.
 		// TODO: What is a reasonable block size here?
+		static size_t defaultBlockSize(size_t size) {
+			// Maximum of 32 KB blocks
+			return min(size_t(1024 * 1024 / 32), size / 32);
+		}
+
 		Generation::Generation(Arena &arena, size_t size, byte identifier)
-			: totalSize(size), blockSize(size / 32),
+			: totalSize(size), blockSize(defaultBlockSize(size)),
 			  next(null), arena(arena), identifier(identifier),
-			  lastChunk(0), totalAllocBytes(0), totalFreeBytes(0), shared(null) {
+			  lastChunk(0), totalAllocBytes(0), totalFreeBytes(0), shared(null),
+			  initialSize(size), survival(0), pause(0), rate(0), lastCollection(0), usedAfter(0) {
 
-			// Maximum of 32 KB blocks
-			blockSize = min(size_t(1024 * 1024 / 32), blockSize);
 			pinnedSets.push_back(PinnedSet(0, 1));
 		}
 
@@ -67,6 +72,9 @@ namespace storm {
 		bool Generation::isPinned(void *obj, void *end) {
 			ChunkList::iterator pos = std::lower_bound(chunks.begin(), chunks.end(), obj, PtrCompare());
 			if (pos != chunks.end()) {
+				// Large objects kept in place behave as if they were pinned.
+				if (pos->live && pos->memory.has(obj))
+					return true;
 				return pinnedSets[pos - chunks.begin()].has(obj, end);
 			} else {
 				// Should not happen...
@@ -74,6 +82,82 @@ namespace storm {
 			}
 		}
 
+		Generation::KeepLarge Generation::keepLarge(void *obj) {
+			ChunkList::iterator pos = std::lower_bound(chunks.begin(), chunks.end(), obj, PtrCompare());
+			if (pos == chunks.end() || !pos->large || !pos->memory.has(obj))
+				return largeMove;
+
+			if (pos->live)
+				return largeAlreadyKept;
+
+			pos->live = true;
+			return largeKept;
+		}
+
+		Block *Generation::largeBlock(ArenaTicket &ticket, size_t size) {
+			Chunk c = arena.allocChunk(size + sizeof(Block), identifier);
+			if (c.empty())
+				return null;
+
+			GenChunk chunk(c);
+			chunk.large = true;
+			chunk.freeBytes = 0;
+
+			// Reserve the memory right away, so that the chunk survives any collections until the
+			// object is committed.
+			Block *r = (Block *)c.at;
+			r->reserved(size);
+
+			insertSorted(chunks, chunk, ChunkCompare());
+			while (pinnedSets.size() < chunks.size() + 1)
+				pinnedSets.push_back(PinnedSet(0, 1));
+
+			totalAllocBytes += c.size;
+			if (totalAllocBytes > totalSize)
+				ticket.scheduleCollection(this);
+
+			return r;
+		}
+
+		size_t Generation::promoteLarge(ArenaTicket &ticket) {
+			size_t promoted = 0;
+			if (!next)
+				return promoted;
+
+			for (size_t i = 0; i < chunks.size(); i++) {
+				if (!chunks[i].live)
+					continue;
+
+				GenChunk chunk = chunks[i];
+				chunk.live = false;
+				chunks.erase(chunks.begin() + i);
+				pinnedSets.erase(pinnedSets.begin() + i);
+				totalAllocBytes -= chunk.memory.size;
+				totalFreeBytes -= chunk.freeBytes;
+				i--;
+
+				// Write barriers were removed at the start of the collection, so the next
+				// generation will re-scan the chunk and update the summary the next time it is
+				// scanned.
+				ticket.identifier(chunk.memory, next->identifier);
+				next->adoptChunk(ticket, chunk);
+				promoted += chunk.memory.size - chunk.freeBytes;
+			}
+
+			return promoted;
+		}
+
+		void Generation::adoptChunk(ArenaTicket &ticket, const GenChunk &chunk) {
+			insertSorted(chunks, chunk, ChunkCompare());
+			while (pinnedSets.size() < chunks.size() + 1)
+				pinnedSets.push_back(PinnedSet(0, 1));
+
+			totalAllocBytes += chunk.memory.size;
+			totalFreeBytes += chunk.freeBytes;
+			if (totalAllocBytes > totalSize)
+				ticket.scheduleCollection(this);
+		}
+
 		Block *Generation::sharedBlock(ArenaTicket &ticket, size_t size) {
 			if (shared && shared->remaining() < size) {
 				done(ticket, shared);
@@ -171,6 +255,10 @@ namespace storm {
 
 			ticket.gcRunning();
 
+			// For the statistics used to resize the generation.
+			nat64 start = currentUs();
+			size_t before = currentUsed();
+
 			// GenSet only containing us.
 			GenSet self;
 			self.add(identifier);
@@ -248,6 +336,9 @@ namespace storm {
 			for (Block *at = finalizerBlocks; at; at = at->next()) {
 				ChunkList::iterator pos = std::lower_bound(chunks.begin(), chunks.end(), at, PtrCompare());
 				dbg_assert(pos != chunks.end(), L"Could not find a pinned set!");
+				// Large objects that are kept in place are still reachable.
+				if (pos->live)
+					continue;
 				at->traverse(FinalizerPool::MoveFinalizers(pool, pinnedSets[pos - chunks.begin()]));
 			}
 
@@ -261,6 +352,11 @@ namespace storm {
 			// Recursively grab all dependencies of the objects we moved to the finalizer pool!
 			pool.scanNew(ticket, state);
 
+			// Move large objects that survived to the next generation. They are no longer a part
+			// of this generation, so the remaining steps will not consider them. References to them
+			// don't need to be updated, since they were not moved.
+			size_t survived = promoteLarge(ticket);
+
 			// Update any references to objects we just moved.
 
 			// Note: We don't need to scan objects we have moved. The ScanState makes sure to update
@@ -272,9 +368,14 @@ namespace storm {
 			// track of this for us, so this is fairly cheap.
 			scanState.scanWeak<UpdateWeakFwd>(state);
 
-			// We also need to scan any pinned weak objects. Otherwise they will contain stale references!
-			for (size_t i = 0; i < chunks.size(); i++)
-				scanPinned<OnlyWeak<UpdateWeakFwd>>(chunks[i], pinnedSets[i], state);
+			// We also need to scan any pinned weak objects. Otherwise they will contain stale
+			// references! Chunks are independent of each other here, so we scan them in parallel.
+			{
+				typedef OnlyWeak<UpdateWeakFwd> WeakScanner;
+				vector<WeakScanner::Result> results(chunks.size(), WeakScanner::Result());
+				ScanPinnedTask<WeakScanner> task(chunks, pinnedSets, state, results);
+				ticket.workers().run(task, chunks.size());
+			}
 
 			// Note: We try to not scan the objects we moved to a new generation immediately at this
 			// point. ScanState sets the flag fSkipScan on all blocks that were empty when they were
@@ -311,12 +412,21 @@ namespace storm {
 			//   time a similar situation occurs (even though it is fairly unlikely).
 			totalAllocBytes = 0;
 			totalFreeBytes = 0;
+			size_t pinnedChunks = 0;
 			size_t freeLast = chunks.size();
 			for (size_t i = 0; i < chunks.size(); i++) {
 				GenChunk &chunk = chunks[i];
 				PinnedSet &pinned = pinnedSets[i];
 
-				if (chunk.compact(ticket, pinned)) {
+				// Large objects that are still being allocated, or that were kept in place since there
+				// is no next generation, must not be touched.
+				bool keep = chunk.large && (chunk.live || chunk.pending());
+				chunk.live = false;
+
+				if (!keep && !pinned.empty())
+					pinnedChunks++;
+
+				if (!keep && chunk.compact(ticket, pinned)) {
 					// We know that the first few bytes inside the chunk is a Block header. As such,
 					// we can use that memory to create a linked list of chunk id:s to free later on.
 					*(size_t *)chunk.memory.at = freeLast;
@@ -340,6 +450,72 @@ namespace storm {
 				chunks.erase(chunks.begin() + id);
 				pinnedSets.erase(pinnedSets.begin() + id);
 			}
+
+			// Objects that survived were either moved to the next generation or kept in place.
+			size_t promoted = survived + scanState.movedBytes();
+			survived = promoted + currentUsed();
+			nat64 end = currentUs();
+
+			GcEvent event;
+			event.generation = arena.generationNumber(this);
+			event.start = start;
+			event.duration = end - start;
+			event.scanned = before;
+			event.copied = scanState.movedBytes();
+			event.promoted = promoted;
+			event.freed = before - min(before, survived);
+			event.pinnedChunks = pinnedChunks;
+			event.threads = nat(ticket.workers().takePeak());
+			arena.telemetry.collected(event);
+
+			adapt(before, survived, start, end);
+		}
+
+		void Generation::adapt(size_t before, size_t survived, nat64 start, nat64 end) {
+			size_t s = 1024;
+			if (survived < before)
+				s = size_t(nat64(survived) * 1024 / before);
+			nat64 p = end - start;
+			nat64 interval = 0;
+
+			if (lastCollection == 0) {
+				survival = s;
+				pause = p;
+			} else {
+				// Average with the previous values, so that a single unusual collection does not
+				// make us resize the generation too much.
+				survival = (survival * 3 + s) / 4;
+				pause = (pause * 3 + p) / 4;
+
+				interval = start - lastCollection;
+				if (interval > 0)
+					rate = size_t(nat64(before - min(before, usedAfter)) * 1000000 / interval);
+			}
+
+			lastCollection = end;
+			usedAfter = currentUsed();
+
+			GcGenState state;
+			state.size = totalSize;
+			state.initialSize = initialSize;
+			state.minSize = initialSize / genShrinkLimit;
+			state.maxSize = initialSize * genGrowLimit;
+			state.used = usedAfter;
+			state.survival = survival;
+			state.pause = pause;
+			state.interval = interval;
+			// The last two generations collect into each other, so their survivors are copied
+			// regardless of their size.
+			state.shrinkForPause = !arena.lastGeneration(this);
+			totalSize = adaptGenerationSize(arena.goals, state);
+
+			// Block sizes may not decrease along the chain of generations (ScanState relies on
+			// that), so we only ever grow the block size, and never beyond the block size of any
+			// later generation.
+			size_t block = defaultBlockSize(totalSize);
+			for (Generation *g = next; g; g = g->next)
+				block = min(block, g->blockSize);
+			blockSize = max(blockSize, block);
 		}
 
 		void Generation::runAllFinalizers(FinalizerContext &context) {
@@ -391,7 +567,7 @@ namespace storm {
 		 * A chunk.
 		 */
 
-		Generation::GenChunk::GenChunk(Chunk chunk) : memory(chunk) {
+		Generation::GenChunk::GenChunk(Chunk chunk) : memory(chunk), large(false), live(false) {
 			lastAlloc = new (memory.at) Block(memory.size - sizeof(Block));
 			freeBytes = memory.size - sizeof(Block);
 
@@ -412,7 +588,7 @@ namespace storm {
 
 		Block *Generation::GenChunk::allocBlock(size_t minSize, size_t maxSize, size_t minFragment) {
 			// We will definitely fail to find a suitable allocation spot...
-			if (freeBytes < minSize)
+			if (freeBytes < minSize || large)
 				return null;
 
 			// Visit all elements in turn, starting at 'lastAlloc' and try to find something good!
@@ -765,7 +941,7 @@ namespace storm {
 			while ((byte *)at < (byte *)memory.end()) {
 				assert(memory.has(at), L"Invalid block size detected. Leads to outside the specified chunk!");
 
-				if (!at->hasFlag(Block::fUsed))
+				if (!at->hasFlag(Block::fUsed) && !large)
 					free += at->remaining();
 
 				at->dbg_verify(arena);
@@ -773,7 +949,7 @@ namespace storm {
 			}
 
 			assert(at == memory.end(), L"A chunk is overfilled!");
-			assert(free == freeBytes, L"The number of free bytes is not correct. "
+			assert(large || free == freeBytes, L"The number of free bytes is not correct. "
 				L"Stored: " + ::toS(freeBytes) + L", actual: " + ::toS(free));
 		}
 
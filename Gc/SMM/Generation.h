@@ -9,6 +9,7 @@
 #include "Arena.h"
 #include "Predicates.h"
 #include "FinalizerContext.h"
+#include "WorkerPool.h"
 
 namespace storm {
 	namespace smm {
@@ -59,6 +60,20 @@ namespace storm {
 			// limit. Returns zero if the limit has already been broken.
 			size_t currentGrace() const { return totalSize - min(totalSize, totalAllocBytes) + totalFreeBytes; }
 
+			// Statistics from recent collections of this generation, averaged over the last few
+			// collections. These are used to adapt 'totalSize' and 'blockSize' after each collection
+			// (see 'adapt').
+
+			// Fraction of the used bytes that survived a collection, in 1/1024:ths.
+			size_t survivalRate() const { return survival; }
+
+			// Time spent collecting, in microseconds.
+			nat64 pauseTime() const { return pause; }
+
+			// Number of bytes allocated in (or promoted to) this generation per second between
+			// collections.
+			size_t allocRate() const { return rate; }
+
 			// Allocate a new block in this generation. When the block is full, it should be
 			// finished by calling 'done'. The size of the returned block has at least 'minSize'
 			// free memory. Allocations where 'minSize' is much larger than 'blockSize' may not be
@@ -72,6 +87,12 @@ namespace storm {
 			// Lock for accessing the shared block returned by 'sharedBlock'.
 			util::Lock sharedBlockLock;
 
+			// Allocate a block for a single large object of 'size' bytes, in a chunk of its own. The
+			// block is reserved for the object until it is committed, and it is never used for other
+			// allocations. If the object survives a collection, the entire chunk is moved to the
+			// next generation instead of copying the object.
+			Block *largeBlock(ArenaTicket &ticket, size_t size);
+
 			// Access a shared block that is considered to be at the "end of the generation", where
 			// anyone may add objects to this generation. When using this block, the lock needs to
 			// be held while the filling is in progress. The parameter indicates how much free
@@ -94,6 +115,9 @@ namespace storm {
 
 			// Scan all blocks that may contain references to anything in the provided GenSet,
 			// possibly raising write barriers since a garbage collection sycle is almost over.
+			// Chunks are scanned in parallel using the worker pool in the arena, so the scanner
+			// may not modify anything but the scanned objects, and 'source' must be safe to use
+			// from multiple threads at once.
 			template <class Scanner>
 			typename Scanner::Result scanFinal(ArenaTicket &ticket,
 											GenSet refsTo,
@@ -103,6 +127,19 @@ namespace storm {
 			// destroyed, so no need for efficiency.
 			void runAllFinalizers(FinalizerContext &context);
 
+			// Result from 'keepLarge'.
+			enum KeepLarge {
+				// The object is not in a chunk of its own, and needs to be moved.
+				largeMove,
+
+				// The object was found reachable for the first time in this collection. It needs
+				// to be scanned.
+				largeKept,
+
+				// The object was already found reachable earlier in this collection.
+				largeAlreadyKept,
+			};
+
 
 			/**
 			 * Class that is handed out to give additional information during a collection.
@@ -122,11 +159,17 @@ namespace storm {
 					return gen.identifier;
 				}
 
-				// Get information on pinned objects in this generation.
+				// Get information on pinned objects in this generation. Large objects that are kept
+				// in place are also considered pinned.
 				inline bool isPinned(void *obj, void *end) const {
 					return gen.isPinned(obj, end);
 				}
 
+				// Keep a large object in place rather than copying it. See 'largeBlock'.
+				inline KeepLarge keepLarge(void *obj) const {
+					return gen.keepLarge(obj);
+				}
+
 				// Get the arena.
 				inline Arena &arena() const {
 					return gen.arena;
@@ -178,6 +221,20 @@ namespace storm {
 				// chunks marked as 'used'.
 				size_t freeBytes;
 
+				// Does this chunk contain a single large object (see 'largeBlock')? No other
+				// objects are allocated in these chunks.
+				bool large;
+
+				// Was the large object in this chunk found to be reachable during the current
+				// collection?
+				bool live;
+
+				// Is the allocation of the large object in this chunk still in progress?
+				inline bool pending() const {
+					Block *first = (Block *)memory.at;
+					return first->reserved() > first->committed();
+				}
+
 				// Allocate a block inside this chunk. Returns null on failure. 'minFragment' states
 				// how small fragments that are acceptable when splitting blocks. Marks the returned
 				// block as 'in use'. Call 'releaseBlock' to remove the mark.
@@ -313,6 +370,26 @@ namespace storm {
 			// The shared block.
 			Block *shared;
 
+			// Size of this generation when it was created. Resizing is limited relative to this size.
+			const size_t initialSize;
+
+			// Statistics. See 'survivalRate', 'pauseTime' and 'allocRate'.
+			size_t survival;
+			nat64 pause;
+			size_t rate;
+
+			// Time when the last collection finished, as reported by 'currentUs'. Zero if we have
+			// not been collected yet.
+			nat64 lastCollection;
+
+			// Number of used bytes after the last collection.
+			size_t usedAfter;
+
+			// Update the statistics after a collection that started at 'start' and ended at 'end',
+			// where 'survived' out of 'before' used bytes survived. Then resize the generation
+			// towards the goals in the arena.
+			void adapt(size_t before, size_t survived, nat64 start, nat64 end);
+
 			// Allocate a block with a (usable) size in the specified range. For internal use.
 			Block *allocBlock(ArenaTicket &ticket, size_t minSize, size_t maxSize);
 
@@ -323,6 +400,17 @@ namespace storm {
 			// Check if a particular object is pinned. Only reasonable to call during an ongoing scan.
 			bool isPinned(void *obj, void *end);
 
+			// Mark a large object as reachable during a collection. Returns 'largeMove' if 'obj' is
+			// not in a chunk created by 'largeBlock'.
+			KeepLarge keepLarge(void *obj);
+
+			// Move chunks with large objects that were found reachable to the next generation. Returns
+			// the number of bytes used by the moved objects.
+			size_t promoteLarge(ArenaTicket &ticket);
+
+			// Add a chunk from another generation to this generation.
+			void adoptChunk(ArenaTicket &ticket, const GenChunk &chunk);
+
 
 			/**
 			 * Scan a particular GenChunk.
@@ -386,6 +474,56 @@ namespace storm {
 																	typename Scanner::Source &source,
 																	Block *&finalizers);
 
+			/**
+			 * Tasks for scanning chunks in parallel using the WorkerPool. Each task scans one
+			 * chunk, and stores the result in 'results'.
+			 */
+			template <class Scanner>
+			class ScanFinalTask : public WorkerPool::Task {
+			public:
+				ScanFinalTask(ArenaTicket &ticket, ChunkList &chunks, GenSet toScan,
+							typename Scanner::Source &source, vector<typename Scanner::Result> &results)
+					: ticket(ticket), chunks(chunks), toScan(toScan), source(source), results(results) {}
+
+				virtual void run(size_t id) {
+					results[id] = scanFinal<Scanner>(ticket, chunks[id], toScan, source);
+				}
+
+			private:
+				ArenaTicket &ticket;
+				ChunkList &chunks;
+				GenSet toScan;
+				typename Scanner::Source &source;
+				vector<typename Scanner::Result> &results;
+			};
+
+			template <class Scanner>
+			class ScanPinnedTask : public WorkerPool::Task {
+			public:
+				ScanPinnedTask(ChunkList &chunks, vector<PinnedSet> &pinned,
+							typename Scanner::Source &source, vector<typename Scanner::Result> &results)
+					: chunks(chunks), pinned(pinned), source(source), results(results) {}
+
+				virtual void run(size_t id) {
+					results[id] = scanPinned<Scanner>(chunks[id], pinned[id], source);
+				}
+
+			private:
+				ChunkList &chunks;
+				vector<PinnedSet> &pinned;
+				typename Scanner::Source &source;
+				vector<typename Scanner::Result> &results;
+			};
+
+			// Find the first failed result, if any.
+			template <class Result>
+			static Result firstResult(const vector<Result> &results) {
+				for (size_t i = 0; i < results.size(); i++)
+					if (results[i] != Result())
+						return results[i];
+				return Result();
+			}
+
 		};
 
 
@@ -417,13 +555,10 @@ namespace storm {
 		typename Scanner::Result Generation::scanFinal(ArenaTicket &ticket,
 													GenSet toScan,
 													typename Scanner::Source &source) {
-			typename Scanner::Result r = typename Scanner::Result();
-			for (size_t i = 0; i < chunks.size(); i++) {
-				scanFinal<Scanner>(ticket, chunks[i], toScan, source);
-				if (r != typename Scanner::Result())
-					return r;
-			}
-			return r;
+			vector<typename Scanner::Result> results(chunks.size(), typename Scanner::Result());
+			ScanFinalTask<Scanner> task(ticket, chunks, toScan, source, results);
+			ticket.workers().run(task, chunks.size());
+			return firstResult(results);
 		}
 
 
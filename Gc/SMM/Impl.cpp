@@ -23,8 +23,8 @@ namespace storm {
 		MB(100), // Persistent generation.
 	};
 
-	GcImpl::GcImpl(size_t initialArenaSize, Nat finalizationInterval)
-		: arena(initialArenaSize, generations, ARRAY_COUNT(generations)) {}
+	GcImpl::GcImpl(size_t initialArenaSize, Nat finalizationInterval, bool nearCode)
+		: arena(initialArenaSize, generations, ARRAY_COUNT(generations), nearCode) {}
 
 	void GcImpl::destroy() {
 		arena.destroy();
@@ -34,12 +34,24 @@ namespace storm {
 		return arena.summary();
 	}
 
+	GcHistory GcImpl::history() {
+		return arena.telemetry.history();
+	}
+
+	void GcImpl::setGoals(const GcGoals &goals) {
+		arena.setGoals(goals);
+	}
+
+	Nat GcImpl::setWorkers(Nat count) {
+		return Nat(arena.setWorkers(count));
+	}
+
 	void GcImpl::collect() {
 		arena.collect();
 	}
 
 	Bool GcImpl::collect(Nat time) {
-		return false;
+		return arena.collect(time);
 	}
 
 	static THREAD smm::Thread *currThread = null;
@@ -146,6 +158,17 @@ namespace storm {
 		return result;
 	}
 
+	GcInlineAlloc GcImpl::inlineAlloc() {
+		// Not supported. Allocations are committed with a CAS to detect collections that happened
+		// in between (see PendingAlloc::commit), which is not easily expressed in generated code.
+		return GcInlineAlloc();
+	}
+
+	void *GcImpl::inlineTrapped(const GcType *type, void *object) {
+		assert(false, L"Inline allocations are not supported.");
+		return alloc(type);
+	}
+
 	Bool GcImpl::liveObject(RootObject *obj) {
 		// All objects are destroyed promptly by us, so we don't need this functionality.
 		return true;
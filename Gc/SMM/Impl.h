@@ -6,6 +6,7 @@
 #include "Arena.h"
 #include "Allocator.h"
 #include "Gc/License.h"
+#include "Gc/InlineAlloc.h"
 
 namespace storm {
 
@@ -19,7 +20,7 @@ namespace storm {
 	class GcImpl {
 	public:
 		// Create.
-		GcImpl(size_t initialArenaSize, Nat finalizationInterval);
+		GcImpl(size_t initialArenaSize, Nat finalizationInterval, bool nearCode);
 
 		// Destroy. This function is always called, but may be called twice.
 		void destroy();
@@ -27,6 +28,15 @@ namespace storm {
 		// Get a memory summary.
 		MemorySummary summary();
 
+		// History of recent collections.
+		GcHistory history();
+
+		// Set goals for the sizes of generations.
+		void setGoals(const GcGoals &goals);
+
+		// Set the number of additional threads used during collections. Returns the old value.
+		Nat setWorkers(Nat count);
+
 		// Do a full GC now.
 		void collect();
 
@@ -58,6 +68,14 @@ namespace storm {
 		// WeakArray with one pointer as elements.
 		void *allocWeakArray(const GcType *type, size_t count);
 
+		// Describe the thread-local allocation buffers used by 'alloc', so that generated code may
+		// allocate objects without calling 'alloc'. See GcInlineAlloc for details.
+		GcInlineAlloc inlineAlloc();
+
+		// Called when an inline allocation of 'type' at 'memory' failed to commit. Returns the
+		// client pointer of the object to use instead.
+		void *inlineTrapped(const GcType *type, void *object);
+
 		// See if an object is live, ie. not finalized.
 		static Bool liveObject(RootObject *obj);
 
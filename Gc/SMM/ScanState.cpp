@@ -10,7 +10,7 @@ namespace storm {
 
 		ScanState::ScanState(ArenaTicket &ticket, const Generation::State &from, Generation *to) :
 			sourceGen(from),
-			target(to, ticket), weak(to, ticket) {
+			target(to, ticket), weak(to, ticket), moved(0) {
 
 			// This could cause 'alloc' below to fail!
 			assert(from.gen.blockSize <= to->blockSize,
@@ -50,6 +50,7 @@ namespace storm {
 			fmt::Obj *target = (fmt::Obj *)tail->mem(off);
 			memcpy(target, obj, size);
 			tail->reserved(off + size);
+			moved += size;
 
 			// Check if the object is registered for finalization, and update the target block accordingly.
 			if (fmt::objHasFinalizer(target))
@@ -61,12 +62,49 @@ namespace storm {
 			return clientTarget;
 		}
 
+		bool ScanState::keepLarge(void *obj) {
+			switch (sourceGen.keepLarge(obj)) {
+			case Generation::largeMove:
+				return false;
+			case Generation::largeKept:
+				// Only scan each object once, regardless of the number of references to it.
+				large.push_back(obj);
+				return true;
+			default:
+				return true;
+			}
+		}
+
 		void ScanState::scanNew() {
 			int error = 0;
 			typedef ScanNonmoving<NoWeak<Move>, true> Scanner;
-			while (target.scanStep<Scanner>(*this, error)) {
+
+			// Scanning large objects may copy more objects, and vice versa.
+			do {
+				while (target.scanStep<Scanner>(*this, error)) {
+					dbg_assert(error == 0, L"TODO: We need to handle allocation errors while scanning!");
+				}
+			} while (scanLarge());
+		}
+
+		bool ScanState::scanLarge() {
+			int error = 0;
+			typedef ScanNonmoving<NoWeak<Move>, true> Scanner;
+
+			if (large.empty())
+				return false;
+
+			while (!large.empty()) {
+				void *obj = large.back();
+				large.pop_back();
+
+				// Weak references in these objects are updated when the next generation is scanned
+				// at the end of the collection, since they are not put in the weak queue.
+				error = fmt::Scan<Scanner>::objects(*this, obj, fmt::skip(obj));
 				dbg_assert(error == 0, L"TODO: We need to handle allocation errors while scanning!");
 			}
+
+			return true;
 		}
 
 
@@ -33,9 +33,16 @@ namespace storm {
 			// replaced with a forwarding object, and the address to the new object is returned.
 			void *move(void *obj);
 
+			// Keep a large object in place if possible. If so, it is scanned later by 'scanNew'
+			// instead of being copied. Returns 'false' if the object needs to be moved.
+			bool keepLarge(void *obj);
+
 			// Scan all recently copied objects and recursively move reachable objects to the 'to' generation.
 			void scanNew();
 
+			// Number of bytes moved to the 'to' generation so far.
+			size_t movedBytes() const { return moved; }
+
 			// Scan all weak objects. This will mark the weak objects as scanned, and will only be possible once.
 			template <class Scanner>
 			typename Scanner::Result scanWeak(typename Scanner::Source &source) {
@@ -135,6 +142,15 @@ namespace storm {
 
 			// Queue for objects with weak references. These are scanned once at the end of the process.
 			Queue weak;
+
+			// Large objects that were kept in place, but not yet scanned.
+			vector<void *> large;
+
+			// Number of bytes moved so far.
+			size_t moved;
+
+			// Scan all large objects in 'large'. Returns 'true' if any objects were scanned.
+			bool scanLarge();
 		};
 
 
@@ -177,6 +193,11 @@ namespace storm {
 				if (fmt::isFwd(obj, ptr))
 					return 0;
 
+				// Large objects are not copied if they are alone in their chunk.
+				if (size_t((char *)end - (char *)obj) + fmt::headerSize >= largeObjectSize)
+					if (state.keepLarge(obj))
+						return 0;
+
 				// TODO: Forward any errors!
 				*ptr = state.move(obj);
 				return 0;
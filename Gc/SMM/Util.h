@@ -36,6 +36,26 @@ namespace storm {
 			return insertSorted(into, insert, std::less<T>());
 		}
 
+		// Current time in microseconds from a monotonic clock. Used to measure the time spent
+		// collecting.
+		inline nat64 currentUs() {
+#if defined(WINDOWS)
+			LARGE_INTEGER freq, now;
+			QueryPerformanceFrequency(&freq);
+			QueryPerformanceCounter(&now);
+			// Split the division to avoid overflows when 'now' is large.
+			nat64 s = nat64(now.QuadPart / freq.QuadPart);
+			nat64 rest = nat64(now.QuadPart % freq.QuadPart);
+			return s * 1000000 + rest * 1000000 / nat64(freq.QuadPart);
+#elif defined(POSIX)
+			struct timespec ts;
+			clock_gettime(CLOCK_MONOTONIC, &ts);
+			return nat64(ts.tv_sec) * 1000000 + nat64(ts.tv_nsec) / 1000;
+#else
+#error "Implement 'currentUs' for your platform!"
+#endif
+		}
+
 	}
 }
 
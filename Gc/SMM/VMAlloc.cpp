@@ -15,8 +15,64 @@ namespace storm {
 			}
 		};
 
-		VMAlloc::VMAlloc(size_t initSize) :
-			vm(VM::create(this)), pageSize(vm->pageSize),
+#ifdef X64
+
+		// Some address inside the executable.
+		static size_t executableAddr() {
+			return size_t(&executableAddr);
+		}
+
+		// Limit of 32-bit displacements.
+		static const size_t nearLimit = size_t(1) << 31;
+
+		// Is all of the memory in 'mem' reachable from the executable using 32-bit displacements?
+		static bool nearExecutable(void *mem, size_t size) {
+			size_t exe = executableAddr();
+			size_t from = min(size_t(mem), exe);
+			size_t to = max(size_t(mem) + size, exe);
+			return to - from < nearLimit;
+		}
+
+		// Attempt to reserve memory close to the executable. Returns null on failure.
+		static void *reserveNearCode(VM *vm, size_t size) {
+			if (size >= nearLimit - vmNearCodeGap)
+				return null;
+
+			size_t exe = roundUp(executableAddr(), vm->allocGranularity);
+			for (size_t offset = vmNearCodeGap; offset + size < nearLimit; offset *= 2) {
+				// After the executable.
+				if (void *mem = vm->reserve((void *)(exe + offset), size)) {
+					if (nearExecutable(mem, size))
+						return mem;
+					vm->free(mem, size);
+				}
+
+				// Before the executable.
+				if (exe > offset + size) {
+					if (void *mem = vm->reserve((void *)(exe - offset - size), size)) {
+						if (nearExecutable(mem, size))
+							return mem;
+						vm->free(mem, size);
+					}
+				}
+			}
+
+			return null;
+		}
+
+#else
+
+		// All memory is within reach on 32-bit systems.
+		static void *reserveNearCode(VM *vm, size_t size) {
+			(void)vm;
+			(void)size;
+			return null;
+		}
+
+#endif
+
+		VMAlloc::VMAlloc(size_t initSize, bool nearCode) :
+			vm(VM::create(this)), nearCode(nearCode), pageSize(vm->pageSize),
 			minAddr(0), maxAddr(1),
 			info(null), lastAlloc(0) {
 
@@ -26,7 +82,9 @@ namespace storm {
 
 			// Try to allocate the initial block!
 			initSize = roundUp(initSize, granularity);
-			void *mem = vm->reserve(null, initSize);
+			void *mem = nearCode ? reserveNearCode(vm, initSize) : null;
+			if (!mem)
+				mem = vm->reserve(null, initSize);
 			while (!mem) {
 				initSize /= 2;
 				if (initSize < granularity)
@@ -266,6 +324,12 @@ namespace storm {
 			if (void *mem = vm->reserve((byte *)reserved.front().at - bytes, bytes))
 				return Chunk(mem, bytes);
 
+			// Close to the executable.
+			if (nearCode) {
+				if (void *mem = reserveNearCode(vm, bytes))
+					return Chunk(mem, bytes);
+			}
+
 			// Anywhere.
 			if (void *mem = vm->reserve(null, bytes))
 				return Chunk(mem, bytes);
@@ -360,6 +424,16 @@ namespace storm {
 			vm->decommit(chunk.at, chunk.size);
 		}
 
+		void VMAlloc::identifier(Chunk chunk, byte identifier) {
+			byte packedIdentifier = (identifier & 0x3F) << 2;
+			dbg_assert(infoData(packedIdentifier) == identifier, L"Identifier too large!");
+
+			size_t first = infoOffset(chunk.at);
+			size_t pieces = chunk.size / vmAllocMinSize;
+			for (size_t i = first; i < first + pieces; i++)
+				info[i] = (info[i] & 0x03) | packedIdentifier;
+		}
+
 		void VMAlloc::watchWrites(Chunk chunk) {
 			size_t first = infoOffset(chunk.at);
 			size_t pieces = (size_t(chunk.end()) - size_t(infoPtr(first)) + vmAllocMinSize - 1) / vmAllocMinSize;
@@ -25,8 +25,11 @@ namespace storm {
 		 */
 		class VMAlloc {
 		public:
-			// Create. Making an initial reservation of approx. 'init' bytes.
-			VMAlloc(size_t initialSize);
+			// Create. Making an initial reservation of approx. 'init' bytes. If 'nearCode' is true,
+			// we attempt to reserve memory within 2GiB of the executable on 64-bit systems. Code
+			// allocated in the arena is then able to call functions in the executable (and other
+			// code in the arena) using 32-bit displacements rather than through a pointer in memory.
+			VMAlloc(size_t initialSize, bool nearCode);
 
 			// Destroy.
 			~VMAlloc();
@@ -50,6 +53,10 @@ namespace storm {
 				return infoData(info[infoOffset(addr)]);
 			}
 
+			// Change the identifier of an allocated chunk. Used to move memory between generations
+			// without copying it. Keeps the memory protection as it is.
+			void identifier(Chunk chunk, byte id);
+
 			// Get the identifier for an allocation safely. Returns 0xFF on failure.
 			inline byte safeIdentifier(void *addr) const {
 				size_t a = size_t(addr);
@@ -143,6 +150,9 @@ namespace storm {
 			// VM backend.
 			VM *vm;
 
+			// Try to reserve memory close to the executable?
+			bool nearCode;
+
 			// Keep track of all reserved memory. We strive to keep this array small. Otherwise, the
 			// "contains pointer" query will be expensive. Elements are sorted by their starting
 			// address, and not overlapping with each other.
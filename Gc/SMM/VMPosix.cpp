@@ -63,7 +63,10 @@ namespace storm {
 		VMPosix::VMPosix(VMAlloc *alloc, size_t pageSize) : VM(alloc, pageSize, pageSize) {}
 
 		void *VMPosix::reserve(void *at, size_t size) {
-			return mmap(at, size, PROT_NONE, flags, -1, 0);
+			void *result = mmap(at, size, PROT_NONE, flags, -1, 0);
+			if (result == MAP_FAILED)
+				return null;
+			return result;
 		}
 
 		void VMPosix::commit(void *at, size_t size) {
@@ -0,0 +1,146 @@
+#include "stdafx.h"
+#include "WorkerPool.h"
+
+#if STORM_GC == STORM_GC_SMM
+
+#include "Utils/Bitwise.h"
+#include "Config.h"
+#include "Utils/InlineAtomics.h"
+
+namespace storm {
+	namespace smm {
+
+		static size_t processors() {
+#if defined(WINDOWS)
+			SYSTEM_INFO info;
+			GetSystemInfo(&info);
+			return size_t(info.dwNumberOfProcessors);
+#elif defined(POSIX)
+			long count = sysconf(_SC_NPROCESSORS_ONLN);
+			return count > 0 ? size_t(count) : 1;
+#else
+			return 1;
+#endif
+		}
+
+		WorkerPool::WorkerPool()
+			: workerCount(min(processors() - 1, gcWorkers)), started(0), peak(0),
+			  task(null), taskCount(0), nextTask(0), quit(false),
+			  startSema(0), doneSema(0) {}
+
+		WorkerPool::~WorkerPool() {
+			quit = true;
+			for (size_t i = 0; i < started; i++)
+				startSema.up();
+
+			for (size_t i = 0; i < handles.size(); i++) {
+#if defined(WINDOWS)
+				WaitForSingleObject(handles[i], INFINITE);
+				CloseHandle(handles[i]);
+#elif defined(POSIX)
+				pthread_join(handles[i], NULL);
+#endif
+			}
+		}
+
+		void WorkerPool::run(Task &task, size_t count) {
+			if (count == 0)
+				return;
+
+			// Not worth waking the other threads.
+			if (count == 1 || workerCount == 0) {
+				peak = max(peak, size_t(1));
+				for (size_t i = 0; i < count; i++)
+					task.run(i);
+				return;
+			}
+
+			start();
+
+			// No need to wake more threads than we have work for.
+			size_t wake = min(workerCount, count - 1);
+			peak = max(peak, wake + 1);
+
+			this->task = &task;
+			this->taskCount = count;
+			atomicWrite(nextTask, 0);
+
+			for (size_t i = 0; i < wake; i++)
+				startSema.up();
+
+			work();
+
+			for (size_t i = 0; i < wake; i++)
+				doneSema.down();
+
+			this->task = null;
+			this->taskCount = 0;
+		}
+
+		void WorkerPool::setWorkers(size_t count) {
+			workerCount = count;
+		}
+
+		size_t WorkerPool::takePeak() {
+			size_t r = peak;
+			peak = 0;
+			return r;
+		}
+
+		void WorkerPool::start() {
+			while (started < workerCount) {
+#if defined(WINDOWS)
+				HANDLE h = CreateThread(NULL, 0, &threadMain, this, 0, NULL);
+				if (h == NULL)
+					break;
+				handles.push_back(h);
+#elif defined(POSIX)
+				pthread_t h;
+				if (pthread_create(&h, NULL, &threadMain, this) != 0)
+					break;
+				handles.push_back(h);
+#endif
+				started++;
+			}
+
+			// If we failed to create some threads, we simply use fewer of them.
+			workerCount = min(workerCount, started);
+		}
+
+		void WorkerPool::work() {
+			size_t id;
+			while ((id = atomicIncrement(nextTask) - 1) < taskCount)
+				task->run(id);
+		}
+
+		void WorkerPool::main() {
+			while (true) {
+				startSema.down();
+				if (quit)
+					return;
+
+				work();
+				doneSema.up();
+			}
+		}
+
+#if defined(WINDOWS)
+
+		DWORD WINAPI WorkerPool::threadMain(void *param) {
+			((WorkerPool *)param)->main();
+			return 0;
+		}
+
+#elif defined(POSIX)
+
+		void *WorkerPool::threadMain(void *param) {
+			((WorkerPool *)param)->main();
+			return NULL;
+		}
+
+#endif
+
+	}
+}
+
+#endif
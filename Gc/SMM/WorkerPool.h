@@ -0,0 +1,117 @@
+#pragma once
+
+#if STORM_GC == STORM_GC_SMM
+
+#include "Utils/Semaphore.h"
+
+namespace storm {
+	namespace smm {
+
+		/**
+		 * A pool of threads used to perform parts of a collection in parallel.
+		 *
+		 * The threads are plain OS threads that are never attached to the arena. Since they are
+		 * only ever running while the arena lock is held and the mutator threads are stopped, they
+		 * must not allocate memory from the arena, and they do not need to be stopped during
+		 * collections. The threads are created the first time they are needed.
+		 *
+		 * Work is described as a number of independent tasks, numbered from zero. Threads pick the
+		 * next task from a shared counter whenever they are done with the previous one, so that
+		 * uneven task sizes (e.g. chunks with different amounts of live objects) are balanced
+		 * between the threads. The thread calling 'run' also participates.
+		 *
+		 * Currently, only the passes that update references after objects have been moved are
+		 * executed in parallel. Copying objects is still done by a single thread.
+		 */
+		class WorkerPool {
+		public:
+			// Create. Does not start any threads.
+			WorkerPool();
+
+			// Destroy, waits for all threads to terminate.
+			~WorkerPool();
+
+			/**
+			 * A set of tasks to execute.
+			 */
+			class Task {
+			public:
+				// Run task number 'id'. Called from multiple threads at the same time, but only
+				// once for each 'id'.
+				virtual void run(size_t id) = 0;
+			};
+
+			// Run tasks 0 to 'count' on the pool, and wait for all of them to finish.
+			void run(Task &task, size_t count);
+
+			// Number of threads used, including the calling thread.
+			size_t threads() const { return workerCount + 1; }
+
+			// Set the number of additional threads to use. Must not be called while 'run' is
+			// executing. Threads that are already started are kept, but not used.
+			void setWorkers(size_t count);
+
+			// Get the largest number of threads that executed a single call to 'run' since the
+			// last call to 'takePeak', including the calling thread. Zero if 'run' was not called.
+			size_t takePeak();
+
+		private:
+			// No copy.
+			WorkerPool(const WorkerPool &o);
+			WorkerPool &operator =(const WorkerPool &o);
+
+			// Number of additional threads to use.
+			size_t workerCount;
+
+			// Number of threads started so far.
+			size_t started;
+
+			// Largest number of threads used in 'run'.
+			size_t peak;
+
+			// Current task set.
+			Task *task;
+
+			// Number of tasks in the current set.
+			size_t taskCount;
+
+			// Next task to execute.
+			volatile size_t nextTask;
+
+			// Shall the threads terminate?
+			bool quit;
+
+			// Signaled once for each thread that shall execute the current task set.
+			Semaphore startSema;
+
+			// Signaled by each thread when it is done with the current task set.
+			Semaphore doneSema;
+
+			// Start the threads.
+			void start();
+
+			// Execute tasks until there are no more left.
+			void work();
+
+			// Main function of the threads.
+			void main();
+
+#if defined(WINDOWS)
+			// Thread handles.
+			vector<HANDLE> handles;
+
+			static DWORD WINAPI threadMain(void *param);
+#elif defined(POSIX)
+			// Thread handles.
+			vector<pthread_t> handles;
+
+			static void *threadMain(void *param);
+#else
+#error "Implement the WorkerPool for your platform!"
+#endif
+		};
+
+	}
+}
+
+#endif
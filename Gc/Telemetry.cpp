@@ -0,0 +1,69 @@
+#include "stdafx.h"
+#include "Telemetry.h"
+
+namespace storm {
+
+	GcEvent::GcEvent()
+		: generation(0), start(0), duration(0), pause(true),
+		  scanned(0), copied(0), promoted(0), freed(0), pinnedChunks(0), threads(0) {}
+
+	wostream &operator <<(wostream &to, const GcEvent &o) {
+		to << L"Generation " << o.generation << L": " << o.duration << L" us";
+		to << (o.pause ? L", " : L" (incremental), ");
+		to << o.scanned << L" scanned, " << o.copied << L" copied, ";
+		to << o.promoted << L" promoted, " << o.freed << L" freed, ";
+		to << o.pinnedChunks << L" pinned chunks";
+		if (o.threads > 1)
+			to << L", " << o.threads << L" threads";
+		return to;
+	}
+
+	GcHistory::GcHistory()
+		: tracked(false), collections(0), collectTime(0), finalizations(0), finalizeTime(0) {}
+
+	wostream &operator <<(wostream &to, const GcHistory &o) {
+		to << L"Collection history:\n";
+		to << L"Collections     : " << std::setw(10) << o.collections << L"\n";
+		to << L"Collect time    : " << std::setw(10) << o.collectTime << L" us\n";
+		to << L"Finalizations   : " << std::setw(10) << o.finalizations << L"\n";
+		to << L"Finalize time   : " << std::setw(10) << o.finalizeTime << L" us\n";
+		for (size_t i = 0; i < o.recent.size(); i++)
+			to << o.recent[i] << L"\n";
+		return to;
+	}
+
+	GcTelemetry::GcTelemetry()
+		: collections(0), collectTime(0), finalizations(0), finalizeTime(0) {}
+
+	void GcTelemetry::collected(const GcEvent &event) {
+		util::Lock::L z(lock);
+		events[collections % capacity] = event;
+		collections++;
+		collectTime += event.duration;
+	}
+
+	void GcTelemetry::finalized(nat64 time) {
+		util::Lock::L z(lock);
+		finalizations++;
+		finalizeTime += time;
+	}
+
+	GcHistory GcTelemetry::history() {
+		util::Lock::L z(lock);
+
+		GcHistory result;
+		result.tracked = true;
+		result.collections = collections;
+		result.collectTime = collectTime;
+		result.finalizations = finalizations;
+		result.finalizeTime = finalizeTime;
+
+		nat64 first = collections > capacity ? collections - capacity : 0;
+		result.recent.reserve(size_t(collections - first));
+		for (nat64 i = first; i < collections; i++)
+			result.recent.push_back(events[i % capacity]);
+
+		return result;
+	}
+
+}
@@ -0,0 +1,129 @@
+#pragma once
+#include "Utils/Lock.h"
+
+namespace storm {
+
+	/**
+	 * Information about a single collection, provided by GC implementations that keep track of
+	 * their collections.
+	 */
+	class GcEvent {
+	public:
+		GcEvent();
+
+		// Generation that was collected. Zero is the youngest generation. Implementations that do
+		// not know which generation was collected use zero.
+		nat generation;
+
+		// Time when the collection started, in microseconds from some arbitrary point in time.
+		nat64 start;
+
+		// Duration of the collection, in microseconds.
+		nat64 duration;
+
+		// Was the mutator stopped during the entire collection, so that 'duration' is the length
+		// of a pause? Incremental collectors report the time from the start to the end of the
+		// collection instead, which includes time when the mutator was running. MPS does not
+		// report its pauses, so its collections always have 'pause' set to false.
+		bool pause;
+
+		// Number of bytes in the collected generation at the start of the collection.
+		size_t scanned;
+
+		// Number of bytes copied to a new location.
+		size_t copied;
+
+		// Number of bytes that now belong to an older generation.
+		size_t promoted;
+
+		// Number of bytes reclaimed.
+		size_t freed;
+
+		// Number of chunks (the regions of memory the GC allocates from the system) that contained
+		// pinned objects. These chunks are kept and compacted around the pinned objects rather than
+		// being freed.
+		size_t pinnedChunks;
+
+		// Largest number of threads that worked on a single phase of the collection. Zero if not
+		// known.
+		nat threads;
+	};
+
+	// Output.
+	wostream &operator <<(wostream &to, const GcEvent &o);
+
+
+	/**
+	 * History of collections, provided by GC implementations.
+	 */
+	class GcHistory {
+	public:
+		GcHistory();
+
+		// Does the implementation keep track of its collections? If not, everything else is zero.
+		bool tracked;
+
+		// Number of collections since the GC was created.
+		nat64 collections;
+
+		// Total time spent collecting, in microseconds. This is the sum of the durations of all
+		// collections, so it includes time when the mutator was running in incremental collectors.
+		nat64 collectTime;
+
+		// Number of times finalizers were executed after a collection.
+		nat64 finalizations;
+
+		// Total time spent executing finalizers, in microseconds.
+		nat64 finalizeTime;
+
+		// The most recent collections, oldest first. Older collections are only included in the
+		// totals above.
+		vector<GcEvent> recent;
+	};
+
+	// Output.
+	wostream &operator <<(wostream &to, const GcHistory &o);
+
+
+	/**
+	 * Ring buffer of recent collections. Used by GC implementations to implement 'history'. All
+	 * members are safe to call from multiple threads.
+	 */
+	class GcTelemetry {
+	public:
+		// Create.
+		GcTelemetry();
+
+		// Number of events kept.
+		enum {
+			capacity = 256
+		};
+
+		// Record a collection.
+		void collected(const GcEvent &event);
+
+		// Record that finalizers were executed for 'time' microseconds.
+		void finalized(nat64 time);
+
+		// Get the recorded history.
+		GcHistory history();
+
+	private:
+		// No copy.
+		GcTelemetry(const GcTelemetry &o);
+		GcTelemetry &operator =(const GcTelemetry &o);
+
+		// Lock for the data below.
+		util::Lock lock;
+
+		// Events. 'collections % capacity' is the next one to be written.
+		GcEvent events[capacity];
+
+		// Totals.
+		nat64 collections;
+		nat64 collectTime;
+		nat64 finalizations;
+		nat64 finalizeTime;
+	};
+
+}
@@ -47,7 +47,7 @@ namespace storm {
 		return result;
 	}
 
-	GcImpl::GcImpl(size_t, nat) : allocStart(null), allocEnd(null) {}
+	GcImpl::GcImpl(size_t, nat, bool) : allocStart(null), allocEnd(null) {}
 
 	void GcImpl::destroy() {}
 
@@ -58,6 +58,17 @@ namespace storm {
 		return s;
 	}
 
+	GcHistory GcImpl::history() {
+		// We never collect anything.
+		return GcHistory();
+	}
+
+	void GcImpl::setGoals(const GcGoals &goals) {}
+
+	Nat GcImpl::setWorkers(Nat count) {
+		return 0;
+	}
+
 	void GcImpl::collect() {}
 
 	Bool GcImpl::collect(Nat time) {
@@ -116,6 +127,16 @@ namespace storm {
 		return start;
 	}
 
+	GcInlineAlloc GcImpl::inlineAlloc() {
+		// Not supported. We do not have any buffers.
+		return GcInlineAlloc();
+	}
+
+	void *GcImpl::inlineTrapped(const GcType *type, void *object) {
+		assert(false, L"Inline allocations are not supported.");
+		return alloc(type);
+	}
+
 	Bool GcImpl::liveObject(RootObject *obj) {
 		return true;
 	}
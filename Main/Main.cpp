@@ -4,12 +4,15 @@
 #include "Compiler/Server/Main.h"
 #include "Compiler/Exception.h"
 #include "Compiler/Engine.h"
+#include "Code/Arena.h"
 #include "Compiler/Package.h"
 #include "Compiler/Repl.h"
 #include "Compiler/Version.h"
+#include "Compiler/CodeCache.h"
 #include "Core/Timing.h"
 #include "Core/Io/StdStream.h"
 #include "Core/Io/Text.h"
+#include "Gc/PerfMap.h"
 
 void runRepl(Engine &e, const wchar_t *lang, Repl *repl) {
 	TextInput *input = e.stdIn();
@@ -210,6 +213,10 @@ int stormMain(int argc, const wchar_t *argv[]) {
 		return 1;
 	}
 
+	// Enable the perf map before starting the Engine, so that all code is reported.
+	if (p.perfMap)
+		storm::perfMap().open(p.jitdump);
+
 	Moment start;
 
 	// Start an Engine. TODO: Do not depend on 'Path'.
@@ -224,9 +231,21 @@ int stormMain(int argc, const wchar_t *argv[]) {
 			root = Path::cwd() + root;
 	}
 
-	Engine e(root, Engine::reuseMain, &argv);
+	Engine::Options options;
+	options.peephole = p.peephole;
+	options.optimize = p.optimize;
+	options.nearCode = p.nearCode;
+
+	Engine e(root, Engine::reuseMain, &argv, options);
 	Moment end;
 
+	if (p.codeCache) {
+		Url *dir = parsePath(new (e) Str(p.codeCache));
+		if (!dir->absolute())
+			dir = cwdUrl(e)->push(dir);
+		e.codeCache()->open(dir);
+	}
+
 	importPkgs(e, p);
 
 	int result = 1;
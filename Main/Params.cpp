@@ -52,6 +52,12 @@ static StatePtr root(const wchar_t *arg, Params &result) {
 	return &start;
 }
 
+static StatePtr codeCache(const wchar_t *arg, Params &result) {
+	EXPECT_MORE(L"Missing code cache path.");
+	result.codeCache = arg;
+	return &start;
+}
+
 static StatePtr importPath(const wchar_t *arg, Params &result) {
 	EXPECT_MORE(L"Missing import path.");
 	result.import.back().path = arg;
@@ -93,6 +99,24 @@ static StatePtr start(const wchar_t *arg, Params &result) {
 	} else if (wcscmp(arg, L"--version") == 0) {
 		result.mode = Params::modeVersion;
 		return StatePtr();
+	} else if (wcscmp(arg, L"--no-peephole") == 0) {
+		result.peephole = false;
+		return &start;
+	} else if (wcscmp(arg, L"--no-optimize") == 0) {
+		result.optimize = false;
+		return &start;
+	} else if (wcscmp(arg, L"--no-near-code") == 0) {
+		result.nearCode = false;
+		return &start;
+	} else if (wcscmp(arg, L"--perf-map") == 0) {
+		result.perfMap = true;
+		return &start;
+	} else if (wcscmp(arg, L"--perf-jitdump") == 0) {
+		result.perfMap = true;
+		result.jitdump = true;
+		return &start;
+	} else if (wcscmp(arg, L"--code-cache") == 0) {
+		return &codeCache;
 	} else if (wcscmp(arg, L"--server") == 0) {
 		result.mode = Params::modeServer;
 		return StatePtr();
@@ -108,7 +132,13 @@ Params::Params(int argc, const wchar_t *argv[])
 	  root(null),
 	  modeParam(L"bs"),
 	  modeParam2(null),
-	  import() {
+	  import(),
+	  peephole(true),
+	  optimize(true),
+	  nearCode(true),
+	  perfMap(false),
+	  jitdump(false),
+	  codeCache(null) {
 
 	StatePtr state = &start;
 
@@ -141,4 +171,10 @@ void help(const wchar_t *cmd) {
 	wcout << cmd << L" -r <path>        - use <path> as the root path." << endl;
 	wcout << cmd << L" --version        - print the current version and exit." << endl;
 	wcout << cmd << L" --server         - start the language server." << endl;
+	wcout << cmd << L" --no-peephole    - disable peephole optimizations of generated code." << endl;
+	wcout << cmd << L" --no-optimize    - disable backend-independent optimizations of generated code." << endl;
+	wcout << cmd << L" --no-near-code   - do not try to place generated code close to the executable." << endl;
+	wcout << cmd << L" --perf-map       - write /tmp/perf-<pid>.map for profiling generated code with perf." << endl;
+	wcout << cmd << L" --perf-jitdump   - like --perf-map, but also write /tmp/jit-<pid>.dump for 'perf inject --jit'." << endl;
+	wcout << cmd << L" --code-cache <path> - store compiled code in <path> and reuse it on the next start." << endl;
 }
@@ -44,6 +44,22 @@ public:
 
 	// Import additional packages.
 	vector<Import> import;
+
+	// Use peephole optimizations when generating code?
+	bool peephole;
+
+	// Use backend-independent optimizations when generating code?
+	bool optimize;
+
+	// Try to place generated code close to the executable?
+	bool nearCode;
+
+	// Report generated code to 'perf'? 'jitdump' also writes a jitdump file.
+	bool perfMap;
+	bool jitdump;
+
+	// Directory for the code cache (null if disabled).
+	const wchar_t *codeCache;
 };
 
 void help(const wchar_t *cmd);
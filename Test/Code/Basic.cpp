@@ -2,6 +2,7 @@
 #include "Code/Listing.h"
 #include "Code/Binary.h"
 #include "Code/Exception.h"
+#include "Code/Layout.h"
 #include "Code/X64/Layout.h"
 
 using namespace code;
@@ -100,6 +101,41 @@ BEGIN_TEST(CodeScopeTest3, CodeBasic) {
 
 } END_TEST
 
+BEGIN_TEST(CodeZeroVars, CodeBasic) {
+	Engine &e = gEngine();
+	Arena *arena = code::arena(e);
+
+	Listing *l = new (e) Listing();
+
+	Block b0 = l->createBlock(l->root());
+	Var written = l->createIntVar(b0);
+	Var unused = l->createIntVar(b0);
+	Block b1 = l->createBlock(l->root());
+	Var read = l->createIntVar(b1);
+
+	*l << prolog();
+	*l << begin(b0);
+	*l << mov(written, intConst(10));
+	*l << end(b0);
+	*l << begin(b1);
+	*l << mov(eax, read);
+	*l << end(b1);
+	l->result = intDesc(e);
+	*l << fnRet(eax);
+
+	Array<Bool> *zero = zeroVars(l);
+	CHECK(!zero->at(written.key()));
+	CHECK(!zero->at(unused.key()));
+	CHECK(zero->at(read.key()));
+
+	// 'read' shares its slot with 'written', but is still zero.
+	Binary *b = new (e) Binary(arena, l);
+	typedef Int (*Fn)();
+	Fn fn = (Fn)b->address();
+	CHECK_EQ((*fn)(), 0);
+
+} END_TEST
+
 BEGIN_TEST(CodeTest, CodeBasic) {
 	Engine &e = gEngine();
 	Arena *arena = code::arena(e);
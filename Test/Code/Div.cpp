@@ -185,6 +185,48 @@ BEGIN_TEST(ModIConst, Code) {
 } END_TEST
 
 
+
+static Listing *constDiv(Engine &e, op::OpCode op, Size size, Word divisor) {
+	Listing *l = new (e) Listing();
+	Var p1 = l->createIntParam();
+
+	*l << prolog();
+
+	*l << instrDestSrc(e, op, p1, xConst(size, divisor));
+	*l << mov(eax, p1);
+
+	l->result = intDesc(e);
+	*l << fnRet(eax);
+	return l;
+}
+
+BEGIN_TEST(DivConstRange, Code) {
+	Engine &e = gEngine();
+	Arena *arena = code::arena(e);
+	typedef Int (*Fn)(Int);
+
+	// Divisors that are replaced by multiplications, including ones needing a 33-bit multiplier.
+	Int divisors[] = { 3, 7, 10, -7, 641, 0x7FFFFFFF, -0x7FFFFFFF - 1 };
+	Int values[] = { 0, 1, -1, 6, -6, 100, -100, 12345678, -12345678, 0x7FFFFFFF, -0x7FFFFFFF - 1 };
+
+	for (Nat i = 0; i < ARRAY_COUNT(divisors); i++) {
+		Int d = divisors[i];
+		Fn idivFn = (Fn)(new (e) Binary(arena, constDiv(e, op::idiv, Size::sInt, Word(Nat(d)))))->address();
+		Fn imodFn = (Fn)(new (e) Binary(arena, constDiv(e, op::imod, Size::sInt, Word(Nat(d)))))->address();
+		Fn udivFn = (Fn)(new (e) Binary(arena, constDiv(e, op::udiv, Size::sInt, Word(Nat(d)))))->address();
+		Fn umodFn = (Fn)(new (e) Binary(arena, constDiv(e, op::umod, Size::sInt, Word(Nat(d)))))->address();
+
+		for (Nat j = 0; j < ARRAY_COUNT(values); j++) {
+			Int v = values[j];
+			CHECK_EQ((*idivFn)(v), v / d);
+			CHECK_EQ((*imodFn)(v), v % d);
+			CHECK_EQ(Nat((*udivFn)(v)), Nat(v) / Nat(d));
+			CHECK_EQ(Nat((*umodFn)(v)), Nat(v) % Nat(d));
+		}
+	}
+
+} END_TEST
+
 BEGIN_TEST(DivByte, Code) {
 	Engine &e = gEngine();
 	Arena *arena = code::arena(e);
@@ -1,6 +1,7 @@
 #include "stdafx.h"
 #include "Code/Binary.h"
 #include "Code/Listing.h"
+#include "Code/Layout.h"
 #include "Compiler/Debug.h"
 
 using namespace code;
@@ -87,6 +88,69 @@ BEGIN_TEST(CodeExceptionTest, Code) {
 } END_TEST
 
 
+BEGIN_TEST(CodeExceptionPlainBlockTest, Code) {
+	Engine &e = gEngine();
+	Arena *arena = code::arena(e);
+
+	Ref intCleanup = arena->external(S("intCleanup"), address(&::intCleanup));
+	Ref errorFn = arena->external(S("errorFn"), address(&::throwError));
+
+	// 'plain' does not affect exception handling, so it is not recorded anywhere. Make sure that
+	// 'inner' is still cleaned up properly when it is entered and left inside 'plain'.
+	Listing *l = new (e) Listing();
+	Block plain = l->createBlock(l->root());
+	Block inner = l->createBlock(plain);
+	Var v = l->createVar(l->root(), Size::sInt, intCleanup, freeOnException);
+	Var p = l->createIntVar(plain);
+	Var w = l->createVar(inner, Size::sInt, intCleanup, freeOnException);
+
+	CHECK(!exceptionBlock(l, plain));
+	CHECK(exceptionBlock(l, inner));
+
+	*l << prolog();
+
+	*l << mov(v, intConst(10));
+
+	*l << begin(plain);
+	*l << mov(p, intConst(1));
+	*l << fnParam(intDesc(e), p);
+	*l << fnCall(errorFn, false);
+
+	*l << begin(inner);
+	*l << mov(w, intConst(20));
+	*l << fnParam(intDesc(e), intConst(2));
+	*l << fnCall(errorFn, false);
+	*l << end(inner);
+
+	*l << fnParam(intDesc(e), intConst(3));
+	*l << fnCall(errorFn, false);
+	*l << end(plain);
+
+	l->result = intDesc(e);
+	*l << fnRet(eax);
+
+	Binary *b = new (e) Binary(arena, l);
+	typedef Int (*Fn)();
+	Fn fn = (Fn)b->address();
+
+	throwAt = 1;
+	destroyed = 0;
+	CHECK_ERROR((*fn)(), Error);
+	CHECK_EQ(destroyed, 10);
+
+	throwAt = 2;
+	destroyed = 0;
+	CHECK_ERROR((*fn)(), Error);
+	CHECK_EQ(destroyed, 30);
+
+	throwAt = 3;
+	destroyed = 0;
+	CHECK_ERROR((*fn)(), Error);
+	CHECK_EQ(destroyed, 10);
+
+} END_TEST
+
+
 BEGIN_TEST(CodeCleanupTest, Code) {
 	Engine &e = gEngine();
 	Arena *arena = code::arena(e);
@@ -54,3 +54,89 @@ BEGIN_TEST(FloatConstTest, Code) {
 
 	CHECK_EQ((*fn)(), 10.2f);
 } END_TEST
+
+BEGIN_TEST(FloatScalarTest, Code) {
+	Engine &e = gEngine();
+	Arena *arena = code::arena(e);
+
+	Listing *l = new (e) Listing();
+	Var p1 = l->createFloatParam();
+	Var p2 = l->createFloatParam();
+	Var v1 = l->createFloatVar(l->root());
+	Var v2 = l->createIntVar(l->root());
+
+	*l << prolog();
+
+	// (p1 * p2 - p1) / 2 + 10
+	*l << mov(v1, p1);
+	*l << fmul(v1, p2);
+	*l << fsub(v1, p1);
+	*l << fdiv(v1, floatConst(2.0f));
+	*l << mov(v2, intConst(10));
+	*l << icastf(p2, v2);
+	*l << fadd(v1, p2);
+	*l << fneg(v1, v1);
+	*l << fcasti(v2, v1);
+
+	l->result = intDesc(e);
+	*l << fnRet(v2);
+
+	Binary *b = new (e) Binary(arena, l);
+	typedef Int (*Fn)(Float, Float);
+	Fn fn = (Fn)b->address();
+	CHECK_EQ((*fn)(4.0f, 2.5f), -13);
+	CHECK_EQ((*fn)(-1.0f, 5.0f), -8);
+
+} END_TEST
+
+BEGIN_TEST(DoubleScalarTest, Code) {
+	Engine &e = gEngine();
+	Arena *arena = code::arena(e);
+
+	Listing *l = new (e) Listing();
+	Var p1 = l->createParam(doubleDesc(e));
+	Var p2 = l->createFloatParam();
+	Var v1 = l->createVar(l->root(), Size::sDouble);
+
+	*l << prolog();
+
+	*l << fcast(v1, p2);
+	*l << fmul(v1, p1);
+	*l << fadd(v1, doubleConst(0.5));
+
+	l->result = doubleDesc(e);
+	*l << fnRet(v1);
+
+	Binary *b = new (e) Binary(arena, l);
+	typedef Double (*Fn)(Double, Float);
+	Fn fn = (Fn)b->address();
+	CHECK_EQ((*fn)(1.5, 3.0f), 5.0);
+	CHECK_EQ((*fn)(-2.0, 0.25f), 0.0);
+
+} END_TEST
+
+BEGIN_TEST(FloatCmpTest, Code) {
+	Engine &e = gEngine();
+	Arena *arena = code::arena(e);
+
+	Listing *l = new (e) Listing();
+	Var p1 = l->createParam(doubleDesc(e));
+	Var p2 = l->createParam(doubleDesc(e));
+	Var r = l->createByteVar(l->root());
+
+	*l << prolog();
+
+	*l << fcmp(p1, p2);
+	*l << setCond(r, ifFBelow);
+
+	l->result = byteDesc(e);
+	*l << fnRet(r);
+
+	Binary *b = new (e) Binary(arena, l);
+	typedef Byte (*Fn)(Double, Double);
+	Fn fn = (Fn)b->address();
+	CHECK_EQ((*fn)(1.0, 2.0), 1);
+	CHECK_EQ((*fn)(2.0, 1.0), 0);
+	CHECK_EQ((*fn)(2.0, 2.0), 0);
+
+} END_TEST
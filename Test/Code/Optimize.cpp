@@ -0,0 +1,157 @@
+#include "stdafx.h"
+#include "Code/Binary.h"
+#include "Code/Listing.h"
+#include "Code/Optimize.h"
+
+using namespace code;
+
+static Listing *optimizeFold(Engine &e) {
+	Listing *l = new (e) Listing();
+	l->result = intDesc(e);
+	Var p = l->createIntParam();
+	Var a = l->createIntVar(l->root());
+	Var b = l->createIntVar(l->root());
+	Label lbl = l->label();
+
+	*l << prolog();
+
+	*l << mov(a, intConst(10));
+	*l << add(a, intConst(2));
+	*l << mov(b, a);
+	*l << mul(b, intConst(3));
+	*l << cmp(b, intConst(36));
+	*l << jmp(lbl, ifEqual);
+	*l << fnRet(intConst(0));
+
+	*l << lbl;
+	*l << add(b, p);
+	*l << fnRet(b);
+
+	return l;
+}
+
+BEGIN_TEST(OptimizeFold, Code) {
+	Engine &e = gEngine();
+	Arena *arena = code::arena(e);
+
+	Listing *r = code::transform(optimizeFold(e), arena, new (e) Optimize());
+	// The computations of 'a' are removed, and so is the unreachable 'fnRet'.
+	CHECK_EQ(r->count(), Nat(7));
+
+	Binary *b = new (e) Binary(arena, optimizeFold(e));
+	typedef Int (*Fn)(Int);
+	Fn fn = (Fn)b->address();
+
+	CHECK_EQ((*fn)(0), 36);
+	CHECK_EQ((*fn)(1), 37);
+	CHECK_EQ((*fn)(-40), -4);
+
+} END_TEST
+
+BEGIN_TEST(OptimizeCond, Code) {
+	Engine &e = gEngine();
+	Arena *arena = code::arena(e);
+
+	Listing *l = new (e) Listing();
+	l->result = intDesc(e);
+	Var a = l->createIntVar(l->root());
+	Var t = l->createByteVar(l->root());
+	Var r = l->createIntVar(l->root());
+	Label unsignedLbl = l->label();
+	Label signedLbl = l->label();
+
+	*l << prolog();
+
+	// -1 is less than 1, but 0xFFFFFFFF is not below 1.
+	*l << mov(a, intConst(-1));
+	*l << cmp(a, intConst(1));
+	*l << jmp(unsignedLbl, ifBelow);
+	*l << cmp(a, intConst(1));
+	*l << jmp(signedLbl, ifLess);
+	*l << fnRet(intConst(1));
+
+	*l << unsignedLbl;
+	*l << fnRet(intConst(2));
+
+	*l << signedLbl;
+	*l << mov(a, intConst(-8));
+	*l << sar(a, byteConst(1));
+	*l << cmp(a, intConst(-4));
+	*l << setCond(t, ifEqual);
+	*l << ucast(r, t);
+	*l << add(r, a);
+	*l << fnRet(r);
+
+	Binary *b = new (e) Binary(arena, l);
+	typedef Int (*Fn)();
+	Fn fn = (Fn)b->address();
+
+	CHECK_EQ((*fn)(), -3);
+
+} END_TEST
+
+BEGIN_TEST(OptimizeUnusedVars, Code) {
+	Engine &e = gEngine();
+	Arena *arena = code::arena(e);
+
+	Listing *l = new (e) Listing();
+	l->result = intDesc(e);
+	Var p = l->createIntParam();
+	Var a = l->createLongVar(l->root());
+	Var b = l->createIntVar(l->root());
+
+	*l << prolog();
+
+	// 'a' is never read, so the store is removed, and then 'a' is not needed anymore.
+	*l << mov(a, longConst(3));
+	*l << mov(b, p);
+	*l << add(b, intConst(1));
+	*l << fnRet(b);
+
+	Listing *r = code::transform(l, arena, new (e) Optimize());
+	CHECK_EQ(r->allVars()->at(a.key()).size(), Size());
+	CHECK_EQ(r->allVars()->at(b.key()).size(), Size::sInt);
+	CHECK_EQ(r->allVars()->at(p.key()).size(), Size::sInt);
+
+	Binary *bin = new (e) Binary(arena, l);
+	typedef Int (*Fn)(Int);
+	Fn fn = (Fn)bin->address();
+
+	CHECK_EQ((*fn)(1), 2);
+	CHECK_EQ((*fn)(-8), -7);
+
+} END_TEST
+
+// If this is static, it seems the compiler optimizes it away, which breaks stuff.
+Int CODECALL optimizeCallee(Int v) {
+	return v * 2;
+}
+
+BEGIN_TEST(OptimizeCallResult, Code) {
+	Engine &e = gEngine();
+	Arena *arena = code::arena(e);
+
+	Ref callee = arena->external(S("optimizeCallee"), address(&optimizeCallee));
+
+	Listing *l = new (e) Listing();
+	l->result = intDesc(e);
+	Var p = l->createIntParam();
+	Var r = l->createIntVar(l->root());
+
+	*l << prolog();
+
+	// The value of 'r' is not known after the call, even though it was known before.
+	*l << mov(r, intConst(5));
+	*l << fnParam(intDesc(e), p);
+	*l << fnCall(callee, false, intDesc(e), r);
+	*l << add(r, intConst(1));
+	*l << fnRet(r);
+
+	Binary *b = new (e) Binary(arena, l);
+	typedef Int (*Fn)(Int);
+	Fn fn = (Fn)b->address();
+
+	CHECK_EQ((*fn)(10), 21);
+	CHECK_EQ((*fn)(-3), -5);
+
+} END_TEST
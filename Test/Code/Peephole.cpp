@@ -0,0 +1,110 @@
+#include "stdafx.h"
+#include "Code/Binary.h"
+#include "Code/Listing.h"
+#include "Code/X64/Peephole.h"
+
+using namespace code;
+
+BEGIN_TEST(PeepholeArith, Code) {
+	Engine &e = gEngine();
+	Arena *arena = code::arena(e);
+
+	Listing *l = new (e) Listing();
+	l->result = intDesc(e);
+	Var p = l->createIntParam();
+	Var x = l->createIntVar(l->root());
+	Var y = l->createIntVar(l->root());
+	Var z = l->createIntVar(l->root());
+
+	*l << prolog();
+
+	*l << mov(x, p);
+	*l << mul(x, natConst(8));
+	*l << mov(y, p);
+	*l << udiv(y, natConst(4));
+	*l << mov(z, p);
+	*l << umod(z, natConst(16));
+	*l << add(x, y);
+	*l << add(x, z);
+
+	// Moving a value back and forth again.
+	*l << mov(ecx, x);
+	*l << mov(x, ecx);
+
+	*l << fnRet(x);
+
+	Binary *b = new (e) Binary(arena, l);
+	typedef Nat (*Fn)(Nat);
+	Fn fn = (Fn)b->address();
+
+	CHECK_EQ((*fn)(0), 0);
+	CHECK_EQ((*fn)(5), 40 + 1 + 5);
+	CHECK_EQ((*fn)(100), 800 + 25 + 4);
+	CHECK_EQ((*fn)(0x80000001), 8 + 0x20000000 + 1);
+
+} END_TEST
+
+BEGIN_TEST(PeepholeCondJmp, Code) {
+	Engine &e = gEngine();
+	Arena *arena = code::arena(e);
+
+	Listing *l = new (e) Listing();
+	l->result = intDesc(e);
+	Var p = l->createIntParam();
+	Var t = l->createByteVar(l->root());
+
+	Label small = l->label();
+
+	*l << prolog();
+
+	*l << cmp(p, intConst(10));
+	*l << setCond(t, ifLess);
+	*l << cmp(t, byteConst(0));
+	*l << jmp(small, ifNotEqual);
+
+	*l << fnRet(intConst(1));
+
+	*l << small;
+	*l << fnRet(intConst(0));
+
+	Binary *b = new (e) Binary(arena, l);
+	typedef Int (*Fn)(Int);
+	Fn fn = (Fn)b->address();
+
+	CHECK_EQ((*fn)(-5), 0);
+	CHECK_EQ((*fn)(9), 0);
+	CHECK_EQ((*fn)(10), 1);
+	CHECK_EQ((*fn)(20), 1);
+
+} END_TEST
+
+#ifdef X64
+
+BEGIN_TEST(PeepholeRemove, Code) {
+	Engine &e = gEngine();
+	Arena *arena = code::arena(e);
+
+	Listing *l = new (e) Listing();
+	Var v = l->createIntVar(l->root());
+	Var t = l->createByteVar(l->root());
+	Label lbl = l->label();
+
+	*l << prolog();
+	*l << mov(eax, v);
+	*l << mov(v, eax);
+	*l << mov(eax, v);
+	*l << mul(eax, intConst(1));
+	*l << jmp(lbl);
+	*l << lbl;
+	*l << setCond(t, ifEqual);
+	*l << cmp(t, byteConst(0));
+	*l << jmp(lbl, ifEqual);
+	*l << epilog();
+	*l << ret(Size::sInt);
+
+	Listing *r = code::transform(l, arena, new (e) x64::Peephole());
+	CHECK_EQ(r->count(), Nat(6));
+
+} END_TEST
+
+#endif
@@ -2,6 +2,7 @@
 #include "Code/Binary.h"
 #include "Code/Listing.h"
 #include "Code/Reference.h"
+#include "Code/Recording.h"
 
 using namespace code;
 
@@ -96,3 +97,57 @@ BEGIN_TEST(ReplaceTest, Code) {
 
 	CHECK_EQ((*f)(), 148);
 } END_TEST
+
+// Record code, and re-create it with other RefSources.
+BEGIN_TEST(RecordTest, Code) {
+	Engine &e = gEngine();
+	Arena *arena = code::arena(e);
+
+	RefSource *fn = new (e) StrRefSource(S("fnA"));
+	fn->setPtr(address(&fnA));
+
+	Listing *l = new (e) Listing();
+	Var p = l->createIntParam();
+	Var v = l->createIntVar(l->root());
+
+	*l << prolog();
+
+	*l << mov(v, p);
+	*l << fnParam(intDesc(e), v);
+	*l << fnCall(Ref(fn), false, intDesc(e), eax);
+
+	l->result = intDesc(e);
+	*l << fnRet(eax);
+
+	Recording *r = new (e) Recording();
+	Binary *b = Binary::detached(arena, l, false, r);
+	b->attach();
+	CHECK(r->portable);
+	CHECK_EQ(r->sources->count(), 1);
+
+	typedef Int (*Fn)(Int);
+	CHECK_EQ((*(Fn)b->address())(10), 20);
+
+	// Replay it, referring to another function.
+	RefSource *other = new (e) StrRefSource(S("fnB"));
+	other->setPtr(address(&fnB));
+	r->sources->at(0) = other;
+
+	Binary *c = new (e) Binary(arena, r);
+	CHECK_EQ((*(Fn)c->address())(10), 30);
+
+	// References are still updated.
+	other->setPtr(address(&fnA));
+	CHECK_EQ((*(Fn)c->address())(10), 20);
+
+	// Pointers to objects can not be recorded.
+	l = new (e) Listing();
+	*l << prolog();
+	*l << mov(ptrA, objPtr(fn));
+	l->result = ptrDesc(e);
+	*l << fnRet(ptrA);
+
+	r = new (e) Recording();
+	Binary::detached(arena, l, false, r)->attach();
+	CHECK(!r->portable);
+} END_TEST
@@ -0,0 +1,178 @@
+#include "stdafx.h"
+#include "Code/Binary.h"
+#include "Code/Listing.h"
+#include "Code/X64/RemoveInvalid.h"
+#include "Code/X64/RegAlloc.h"
+
+using namespace code;
+
+// Does any instruction in 'l' refer to 'v'?
+static bool refersTo(Listing *l, Var v) {
+	for (Nat i = 0; i < l->count(); i++) {
+		Instr *instr = l->at(i);
+		if (instr->src().type() == opVariable && instr->src().var() == v)
+			return true;
+		if (instr->dest().type() == opVariable && instr->dest().var() == v)
+			return true;
+	}
+	return false;
+}
+
+Int CODECALL regAllocAddTwice(Int a, Int b) {
+	return a + b + b;
+}
+
+BEGIN_TEST(RegAllocLoop, Code) {
+	Engine &e = gEngine();
+	Arena *arena = code::arena(e);
+
+	Listing *l = new (e) Listing();
+	l->result = intDesc(e);
+	Var p = l->createIntParam();
+	Var sum = l->createIntVar(l->root());
+	Var i = l->createIntVar(l->root());
+	Var a = l->createIntVar(l->root());
+	Var b = l->createIntVar(l->root());
+	Var tmp = l->createIntVar(l->root());
+
+	Label loop = l->label();
+	Label done = l->label();
+
+	*l << prolog();
+
+	*l << loop;
+	*l << cmp(i, p);
+	*l << jmp(done, ifGreaterEqual);
+
+	// The values of 'sum' and 'i' need to survive the function call. They are copied to 'a' and
+	// 'b' first, since parameters to 'fnParam' are never kept in registers.
+	*l << mov(a, sum);
+	*l << mov(b, i);
+	*l << fnParam(intDesc(e), a);
+	*l << fnParam(intDesc(e), b);
+	*l << fnCall(arena->external(S("addTwice"), address(&regAllocAddTwice)), false, intDesc(e), tmp);
+	*l << mov(sum, tmp);
+	*l << add(i, intConst(1));
+	*l << jmp(loop);
+
+	*l << done;
+	*l << fnRet(sum);
+
+#ifdef X64
+	// Both 'sum' and 'i' shall be kept in (preserved) registers.
+	Listing *r = code::transform(l, arena, new (e) x64::RemoveInvalid());
+	r = code::transform(r, arena, new (e) x64::RegAlloc());
+	CHECK(!refersTo(r, sum));
+	CHECK(!refersTo(r, i));
+#endif
+
+	Binary *bin = new (e) Binary(arena, l);
+	typedef Int (*Fn)(Int);
+	Fn fn = (Fn)bin->address();
+
+	CHECK_EQ((*fn)(0), 0);
+	CHECK_EQ((*fn)(1), 0);
+	CHECK_EQ((*fn)(4), 12);
+	CHECK_EQ((*fn)(10), 90);
+
+} END_TEST
+
+BEGIN_TEST(RegAllocBlocks, Code) {
+	Engine &e = gEngine();
+	Arena *arena = code::arena(e);
+
+	Listing *l = new (e) Listing();
+	l->result = intDesc(e);
+	Var p = l->createIntParam();
+	Var sum = l->createIntVar(l->root());
+	Block inner = l->createBlock(l->root());
+	Var counter = l->createIntVar(inner);
+
+	Label loop = l->label();
+	Label done = l->label();
+
+	*l << prolog();
+
+	*l << loop;
+	*l << cmp(p, intConst(0));
+	*l << jmp(done, ifEqual);
+
+	// 'counter' shall be zero each time the block is entered.
+	*l << begin(inner);
+	*l << add(counter, intConst(2));
+	*l << add(sum, counter);
+	*l << add(counter, intConst(1));
+	*l << end(inner);
+
+	*l << sub(p, intConst(1));
+	*l << jmp(loop);
+
+	*l << done;
+	*l << fnRet(sum);
+
+	Binary *b = new (e) Binary(arena, l);
+	typedef Int (*Fn)(Int);
+	Fn fn = (Fn)b->address();
+
+	CHECK_EQ((*fn)(0), 0);
+	CHECK_EQ((*fn)(1), 2);
+	CHECK_EQ((*fn)(7), 14);
+
+} END_TEST
+
+#ifdef X64
+
+BEGIN_TEST(RegAllocVector, Code) {
+	Engine &e = gEngine();
+	Arena *arena = code::arena(e);
+
+	Listing *l = new (e) Listing();
+	Var out = l->createParam(ptrDesc(e));
+	Var src = l->createParam(ptrDesc(e));
+	Var count = l->createIntParam();
+	Var sum = l->createVar(l->root(), Size::sVec);
+
+	Label loop = l->label();
+	Label done = l->label();
+
+	*l << prolog();
+
+	// Sum 'count' vectors in 'src'. 'sum' is zero-initialized.
+	*l << loop;
+	*l << cmp(count, intConst(0));
+	*l << jmp(done, ifEqual);
+	*l << mov(ptrA, src);
+	*l << vadd(sum, xRel(Size::sVec, ptrA, Offset()));
+	*l << add(src, ptrConst(16));
+	*l << sub(count, intConst(1));
+	*l << jmp(loop);
+
+	*l << done;
+	*l << mov(ptrA, out);
+	*l << mov(xRel(Size::sVec, ptrA, Offset()), sum);
+	*l << fnRet();
+
+	// 'sum' shall be kept in an xmm register.
+	Listing *r = code::transform(l, arena, new (e) x64::RemoveInvalid());
+	r = code::transform(r, arena, new (e) x64::RegAlloc());
+	CHECK(!refersTo(r, sum));
+
+	Binary *b = new (e) Binary(arena, l);
+	typedef void (*Fn)(Int *, Int *, Int);
+	Fn fn = (Fn)b->address();
+
+	Int data[12] = { 1, 2, 3, 4, 10, 20, 30, 40, -5, 5, -5, 5 };
+	Int result[4] = { 7, 7, 7, 7 };
+	(*fn)(result, data, 3);
+	CHECK_EQ(result[0], 6);
+	CHECK_EQ(result[1], 27);
+	CHECK_EQ(result[2], 28);
+	CHECK_EQ(result[3], 49);
+
+	(*fn)(result, data, 0);
+	CHECK_EQ(result[0], 0);
+	CHECK_EQ(result[3], 0);
+
+} END_TEST
+
+#endif
@@ -0,0 +1,50 @@
+#include "stdafx.h"
+#include "Code/Binary.h"
+#include "Code/Listing.h"
+
+using namespace code;
+
+#if defined(X64) && defined(POSIX)
+
+static THREAD Int threadValue = 0;
+
+// Offset of 'threadValue' relative to the thread pointer.
+static Int threadValueOffset() {
+	const byte *tp;
+	__asm__("movq %%fs:0, %0" : "=r" (tp));
+	return Int((const byte *)&threadValue - tp);
+}
+
+BEGIN_TEST(ThreadLocalTest, Code) {
+	Engine &e = gEngine();
+	Arena *arena = code::arena(e);
+
+	Listing *l = new (e) Listing();
+	l->result = intDesc(e);
+	Var p = l->createIntParam();
+	Var v = l->createIntVar(l->root());
+	Operand tls = intRel(noReg, Offset(threadValueOffset()));
+
+	*l << prolog();
+
+	// Return the old value, and replace it with 'p'.
+	*l << threadLocal();
+	*l << mov(eax, tls);
+	*l << mov(v, eax);
+	*l << mov(eax, p);
+	*l << threadLocal();
+	*l << mov(tls, eax);
+	*l << fnRet(v);
+
+	Binary *b = new (e) Binary(arena, l);
+	typedef Int (*Fn)(Int);
+	Fn fn = (Fn)b->address();
+
+	threadValue = 10;
+	CHECK_EQ((*fn)(20), 10);
+	CHECK_EQ(threadValue, 20);
+	CHECK_EQ((*fn)(30), 20);
+
+} END_TEST
+
+#endif
@@ -0,0 +1,142 @@
+#include "stdafx.h"
+#include "Code/Binary.h"
+#include "Code/Listing.h"
+
+using namespace code;
+
+#ifdef X64
+
+BEGIN_TEST(VectorIntTest, Code) {
+	Engine &e = gEngine();
+	Arena *arena = code::arena(e);
+
+	Listing *l = new (e) Listing();
+	Var a = l->createParam(ptrDesc(e));
+	Var b = l->createParam(ptrDesc(e));
+	Var v1 = l->createVar(l->root(), Size::sVec);
+	Var v2 = l->createVar(l->root(), Size::sVec);
+
+	*l << prolog();
+
+	*l << mov(ptrA, a);
+	*l << mov(v1, xRel(Size::sVec, ptrA, Offset()));
+	*l << mov(ptrC, b);
+	*l << mov(v2, xRel(Size::sVec, ptrC, Offset()));
+
+	// Reverse the sum.
+	*l << vadd(v1, v2);
+	*l << vshuffle(v1, 0x1B);
+	*l << vcmpgt(v2, v1);
+
+	*l << mov(xRel(Size::sVec, ptrA, Offset()), v1);
+	*l << mov(xRel(Size::sVec, ptrC, Offset()), v2);
+	*l << fnRet();
+
+	Binary *bin = new (e) Binary(arena, l);
+	typedef void (*Fn)(Int *, Int *);
+	Fn fn = (Fn)bin->address();
+
+	Int x[4] = { 1, 2, 3, 4 };
+	Int y[4] = { 10, -20, 30, 40 };
+	(*fn)(x, y);
+
+	CHECK_EQ(x[0], 44);
+	CHECK_EQ(x[1], 33);
+	CHECK_EQ(x[2], -18);
+	CHECK_EQ(x[3], 11);
+
+	CHECK_EQ(y[0], 0);
+	CHECK_EQ(y[1], 0);
+	CHECK_EQ(y[2], -1);
+	CHECK_EQ(y[3], -1);
+} END_TEST
+
+BEGIN_TEST(VectorFloatTest, Code) {
+	Engine &e = gEngine();
+	Arena *arena = code::arena(e);
+
+	Listing *l = new (e) Listing();
+	Var a = l->createParam(ptrDesc(e));
+	Var b = l->createParam(ptrDesc(e));
+	Var v1 = l->createVar(l->root(), Size::sVec);
+	Var v2 = l->createVar(l->root(), Size::sVec);
+
+	*l << prolog();
+
+	*l << mov(ptrA, a);
+	*l << mov(ptrC, b);
+	*l << mov(v1, xRel(Size::sVec, ptrA, Offset()));
+	*l << mov(v2, xRel(Size::sVec, ptrC, Offset()));
+
+	// max(a * b + b, b)
+	*l << vfmul(v1, xRel(Size::sVec, ptrC, Offset()));
+	*l << vfadd(v1, v2);
+	*l << vfmax(v1, v2);
+	*l << vfcmplt(v2, v1);
+
+	*l << mov(xRel(Size::sVec, ptrA, Offset()), v1);
+	*l << mov(xRel(Size::sVec, ptrC, Offset()), v2);
+	*l << fnRet();
+
+	Binary *bin = new (e) Binary(arena, l);
+	typedef void (*Fn)(Float *, Float *);
+	Fn fn = (Fn)bin->address();
+
+	Float x[4] = { 1.5f, -2.0f, 4.0f, 0.5f };
+	Float y[4] = { 2.0f, 3.0f, -1.0f, 8.0f };
+	(*fn)(x, y);
+
+	CHECK_EQ(x[0], 5.0f);
+	CHECK_EQ(x[1], 3.0f);
+	CHECK_EQ(x[2], -1.0f);
+	CHECK_EQ(x[3], 12.0f);
+
+	Int mask[4];
+	memcpy(mask, y, sizeof(mask));
+	CHECK_EQ(mask[0], -1);
+	CHECK_EQ(mask[1], 0);
+	CHECK_EQ(mask[2], 0);
+	CHECK_EQ(mask[3], -1);
+} END_TEST
+
+BEGIN_TEST(VectorUnalignedTest, Code) {
+	Engine &e = gEngine();
+	Arena *arena = code::arena(e);
+
+	Listing *l = new (e) Listing();
+	Var a = l->createParam(ptrDesc(e));
+	Var b = l->createParam(ptrDesc(e));
+	Var v1 = l->createVar(l->root(), Size::sVec);
+
+	*l << prolog();
+
+	*l << mov(ptrA, a);
+	*l << mov(ptrC, b);
+	*l << mov(v1, xRel(Size::sVec, ptrA, Offset()));
+
+	// The source operands are not aligned to 16 bytes.
+	*l << vfmul(v1, xRel(Size::sVec, ptrC, Offset()));
+	*l << vfadd(v1, xRel(Size::sVec, ptrC, Offset()));
+
+	*l << mov(xRel(Size::sVec, ptrA, Offset()), v1);
+	*l << fnRet();
+
+	Binary *bin = new (e) Binary(arena, l);
+	typedef void (*Fn)(Float *, Float *);
+	Fn fn = (Fn)bin->address();
+
+	// Place 'y' at an address that is 8 mod 16.
+	Float storage[12];
+	Float *y = (Float *)((size_t(storage) + 15) & ~size_t(15)) + 2;
+	y[0] = 2.0f; y[1] = 3.0f; y[2] = -1.0f; y[3] = 8.0f;
+
+	Float x[4] = { 1.5f, -2.0f, 4.0f, 0.5f };
+	(*fn)(x, y);
+
+	CHECK_EQ(x[0], 5.0f);
+	CHECK_EQ(x[1], -3.0f);
+	CHECK_EQ(x[2], -5.0f);
+	CHECK_EQ(x[3], 12.0f);
+} END_TEST
+
+#endif
@@ -1,6 +1,12 @@
 #include "stdafx.h"
 #include "Compiler/Debug.h"
 #include "Utils/Bitwise.h"
+#include "Gc/PerfMap.h"
+
+#ifdef POSIX
+#include <unistd.h>
+#include <fstream>
+#endif
 
 using namespace storm::debug;
 
@@ -85,3 +91,85 @@ BEGIN_TEST(CodeRelPtr, GcObjects) {
 	}
 
 } END_TEST;
+
+#if defined(X64) && STORM_GC == STORM_GC_SMM
+
+// Some function in the executable.
+static void nearCodeTarget() {}
+
+BEGIN_TEST(CodeNearExecutable, GcObjects) {
+	Engine &e = gEngine();
+
+	// The tests use the default options, so code allocated by SMM should be reachable from the
+	// executable using 32-bit displacements.
+	const size_t nearLimit = size_t(1) << 31;
+	size_t target = size_t(&nearCodeTarget);
+	for (nat i = 0; i < 100; i++) {
+		size_t code = size_t(runtime::allocCode(e, 64, 0));
+		size_t distance = code > target ? code - target : target - code;
+		CHECK_LT(distance, nearLimit);
+	}
+
+} END_TEST
+
+#endif
+
+#ifdef POSIX
+
+// Read the lines of a file.
+static vector<std::string> readLines(const char *file) {
+	std::ifstream in(file);
+	vector<std::string> r;
+	std::string line;
+	while (std::getline(in, line))
+		r.push_back(line);
+	return r;
+}
+
+// Expected start of a line in a perf map.
+static std::string mapLine(void *code, size_t size) {
+	char buf[64];
+	snprintf(buf, sizeof(buf), "%zx %zx ", size_t(code), size);
+	return buf;
+}
+
+BEGIN_TEST(PerfMapTest, GcObjects) {
+	Engine &e = gEngine();
+
+	char file[64];
+	snprintf(file, sizeof(file), "/tmp/storm-test-%d.map", int(getpid()));
+
+	PerfMap map;
+	map.open(file, null);
+
+	size_t size = sizeof(void *) * 2;
+	void *code = runtime::allocCode(e, size, 1);
+	void *other = runtime::allocCode(e, size, 1);
+	GcCode *refs = runtime::codeRefs(code);
+	refs->refs[0].offset = 0;
+	refs->refs[0].kind = GcCodeRef::perfMap;
+	PerfMap::Handle h = map.add(code, size);
+	atomicWrite(refs->refs[0].pointer, h);
+
+	map.name(code, "test");
+	vector<std::string> lines = readLines(file);
+	VERIFY(lines.size() == 1);
+	CHECK(lines[0] == mapLine(code, size) + "test");
+
+	// Moves are not written until the next flush, since the GC may be in the middle of a collection.
+	PerfMap::update(h, other);
+	CHECK_EQ(readLines(file).size(), size_t(1));
+
+	map.flush();
+	lines = readLines(file);
+	VERIFY(lines.size() == 2);
+	CHECK(lines[1] == mapLine(other, size) + "test");
+
+	// Don't let the finalizer of 'code' remove 'h' from the global map.
+	atomicWrite(refs->refs[0].pointer, null);
+	map.remove(h);
+	unlink(file);
+
+} END_TEST
+
+#endif
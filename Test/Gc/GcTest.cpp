@@ -1,5 +1,6 @@
 #include "stdafx.h"
 #include "Compiler/Debug.h"
+#include "Compiler/GcInfo.h"
 #include "Utils/Bitwise.h"
 #include "Storm/Fn.h"
 
@@ -22,6 +23,334 @@ BEGIN_TEST(GcTest2, GcObjects) {
 
 } END_TEST
 
+BEGIN_TEST(GcIncremental, GcObjects) {
+	Engine &e = gEngine();
+
+	const nat count = 10000;
+	Link *start = createList(e, count);
+
+	// Collect in small steps, allocating between them. Each call does at least one step, so all
+	// but the last one report that there is more to do.
+	nat steps = 0;
+	while (e.gc.collect(0) && steps < 100) {
+		createList(e, 100);
+		CHECK(checkList(start, count));
+		steps++;
+	}
+
+	CHECK(checkList(start, count));
+
+#if STORM_GC == STORM_GC_MPS || STORM_GC == STORM_GC_SMM
+	// Make sure that the mutator actually ran between steps.
+	CHECK_GT(steps, nat(0));
+#endif
+
+} END_TEST
+
+BEGIN_TEST(GcLargeObjects, GcObjects) {
+	Engine &e = gEngine();
+
+	// The data in the array is large enough to be allocated separately, and it is only reachable
+	// through the array.
+	const nat count = 20000;
+	Array<Link *> *large = new (e) Array<Link *>();
+	large->reserve(count);
+	for (nat i = 0; i < count; i++) {
+		Link *l = new (e) Link();
+		l->value = i;
+		large->push(l);
+	}
+
+	for (nat step = 0; step < 3; step++) {
+		e.gc.collect();
+
+		bool ok = true;
+		for (nat i = 0; i < count; i++)
+			ok &= large->at(i)->value == i;
+		CHECK(ok);
+	}
+
+} END_TEST
+
+BEGIN_TEST(GcLargeCycle, GcObjects) {
+	Engine &e = gEngine();
+
+	// Two large arrays that refer to each other and to themselves. Each of them shall only be
+	// scanned once per collection.
+	const nat count = 20000;
+	GcArray<void *> *a = runtime::allocArray<void *>(e, &pointerArrayType, count);
+	GcArray<void *> *b = runtime::allocArray<void *>(e, &pointerArrayType, count);
+	for (nat i = 0; i < count; i++) {
+		a->v[i] = (i % 2) ? (void *)a : (void *)b;
+		b->v[i] = (i % 2) ? (void *)b : (void *)a;
+	}
+
+	for (nat step = 0; step < 3; step++) {
+		e.gc.collect();
+
+		bool ok = true;
+		for (nat i = 0; i < count; i++) {
+			ok &= a->v[i] == ((i % 2) ? (void *)a : (void *)b);
+			ok &= b->v[i] == ((i % 2) ? (void *)b : (void *)a);
+		}
+		CHECK(ok);
+	}
+
+} END_TEST
+
+BEGIN_TEST(GcParallel, GcObjects) {
+	Engine &e = gEngine();
+
+	// Use more than one thread, even on systems with a single processor.
+	Nat oldWorkers = e.gc.setWorkers(3);
+
+	// Each array is allocated in a chunk of its own, so that there are several chunks to process
+	// in parallel.
+	const nat arrays = 4;
+	const nat count = 20000;
+	Array<Array<Link *> *> *all = new (e) Array<Array<Link *> *>();
+	for (nat a = 0; a < arrays; a++) {
+		Array<Link *> *large = new (e) Array<Link *>();
+		large->reserve(count);
+		for (nat i = 0; i < count; i++) {
+			Link *l = new (e) Link();
+			l->value = a * count + i;
+			large->push(l);
+		}
+		all->push(large);
+	}
+
+	e.gc.collect();
+
+	bool ok = true;
+	for (nat a = 0; a < arrays; a++)
+		for (nat i = 0; i < count; i++)
+			ok &= all->at(a)->at(i)->value == a * count + i;
+	CHECK(ok);
+
+#if STORM_GC == STORM_GC_SMM
+	// Make sure the collection actually used several threads.
+	GcHistory history = e.gc.history();
+	nat threads = 0;
+	for (size_t i = 0; i < history.recent.size(); i++)
+		threads = max(threads, history.recent[i].threads);
+	CHECK_GT(threads, nat(1));
+#endif
+
+	e.gc.setWorkers(oldWorkers);
+
+} END_TEST
+
+BEGIN_TEST(GcHistoryTest, GcObjects) {
+	Engine &e = gEngine();
+
+	createList(e, 10000);
+	e.gc.collect();
+
+	// Reading the history also records collections the GC has not told us about yet.
+	GcInfo *info = gcInfo(e);
+
+	// Not all GC implementations keep track of their collections. Those that do shall have seen
+	// the collection above.
+	if (info->tracked) {
+		CHECK_GT(info->collections, Word(0));
+		CHECK(info->recent->any());
+	}
+	CHECK_LTE(Word(info->recent->count()), info->collections);
+
+	// Only collections that stopped the program are pauses.
+	Nat stopped = 0;
+	for (Nat i = 0; i < info->recent->count(); i++)
+		if (info->recent->at(i).pause)
+			stopped++;
+	CHECK_EQ(info->pauses()->total(), stopped);
+
+	Nat perGen = 0;
+	for (Nat i = 0; i < 4; i++)
+		perGen += info->pauses(i)->total();
+	CHECK_EQ(perGen, stopped);
+
+	GcHistogram *h = new (e) GcHistogram();
+	h->add(time::us(10));
+	h->add(time::us(100));
+	h->add(time::ms(100));
+	CHECK_EQ(h->total(), 3);
+	CHECK_EQ(h->at(0), 1);
+	CHECK_EQ(h->at(1), 1);
+	CHECK_EQ(h->longest(), time::ms(100));
+	CHECK_EQ(h->percentile(0.5f), time::us(128));
+
+} END_TEST
+
+BEGIN_TEST(GcAllocSampling, GcObjects) {
+	Engine &e = gEngine();
+
+	sampleAllocations(e, 1024);
+	createList(e, 10000);
+	sampleAllocations(e, 0);
+
+	// Stopping keeps the samples.
+	vector<AllocSampler::Site> sites = e.gc.allocSamples();
+	CHECK(!sites.empty());
+
+	size_t bytes = 0;
+	for (size_t i = 0; i < sites.size(); i++) {
+		CHECK_EQ(sites[i].bytes, sites[i].samples * 1024);
+		bytes += sites[i].bytes;
+	}
+	CHECK_GTE(bytes, size_t(1024));
+
+	CHECK(!allocationProfile(e, true)->empty());
+
+} END_TEST
+
+BEGIN_TEST(GcInlineAllocKey, GcObjects) {
+	Engine &e = gEngine();
+
+	GcInlineAlloc a = e.gc.inlineAlloc();
+	if (a.supported) {
+		// Allocations need to reach the GC while they are sampled.
+		CHECK_EQ(*a.key, a.owner);
+		sampleAllocations(e, 1024);
+		CHECK_NEQ(*a.key, a.owner);
+		sampleAllocations(e, 0);
+		CHECK_EQ(*a.key, a.owner);
+	}
+
+} END_TEST
+
+BEGIN_TEST(GcAdaptTest, GcObjects) {
+	const size_t mb = 1024 * 1024;
+	GcGoals goals(10, 5);
+
+	GcGenState s;
+	s.size = 8*mb;
+	s.initialSize = 8*mb;
+	s.minSize = 2*mb;
+	s.maxSize = 64*mb;
+	s.used = 1*mb;
+	s.survival = 512;
+	s.interval = 1000000;
+
+	// Pauses are too long: shrink, but not to less than half at once.
+	s.pause = 40000;
+	CHECK_EQ(adaptGenerationSize(goals, s), 4*mb);
+	s.pause = 16000;
+	CHECK_EQ(adaptGenerationSize(goals, s), 5*mb);
+
+	// Never below twice the used memory.
+	s.used = 3*mb;
+	CHECK_EQ(adaptGenerationSize(goals, s), 6*mb);
+	s.used = 5*mb;
+	CHECK_EQ(adaptGenerationSize(goals, s), 8*mb);
+	s.used = 1*mb;
+
+	// ...nor below the limit.
+	s.size = 3*mb;
+	s.pause = 40000;
+	CHECK_EQ(adaptGenerationSize(goals, s), 2*mb);
+	s.size = 8*mb;
+
+	// The last generations are not shrunk due to long pauses.
+	s.shrinkForPause = false;
+	CHECK_EQ(adaptGenerationSize(goals, s), 8*mb);
+	s.shrinkForPause = true;
+
+	// Collected often, with short pauses: grow, but not beyond the limit.
+	s.pause = 1000;
+	s.interval = 10000;
+	CHECK_EQ(adaptGenerationSize(goals, s), 16*mb);
+	s.size = 64*mb;
+	CHECK_EQ(adaptGenerationSize(goals, s), 64*mb);
+
+	// ...unless the expected pause is too long.
+	s.size = 8*mb;
+	s.pause = 8000;
+	s.interval = 100000;
+	CHECK_EQ(adaptGenerationSize(goals, s), 8*mb);
+
+	// With a higher goal, we grow.
+	CHECK_EQ(adaptGenerationSize(GcGoals(20, 5), s), 16*mb);
+
+	// Collected rarely: shrink towards the initial size, but not below it.
+	s.pause = 1000;
+	s.interval = 10000000;
+	s.size = 16*mb;
+	CHECK_EQ(adaptGenerationSize(goals, s), 12*mb);
+	s.size = 9*mb;
+	CHECK_EQ(adaptGenerationSize(goals, s), 8*mb);
+	s.size = 8*mb;
+	CHECK_EQ(adaptGenerationSize(goals, s), 8*mb);
+
+	// Nothing is known about the interval yet.
+	s.interval = 0;
+	s.size = 16*mb;
+	CHECK_EQ(adaptGenerationSize(goals, s), 16*mb);
+
+} END_TEST
+
+#if defined(X64) && defined(POSIX)
+
+// Get the buffer of this thread, as described by 'a'.
+static byte *inlineBuffer(const GcInlineAlloc &a) {
+	byte *tp;
+	__asm__("movq %%fs:0, %0" : "=r" (tp));
+	return *(byte **)(tp + a.bufferTls);
+}
+
+BEGIN_TEST(GcInlineAllocPath, GcObjects) {
+	Engine &e = gEngine();
+
+	GcInlineAlloc a = e.gc.inlineAlloc();
+	if (a.supported) {
+		// Make sure the code is compiled, and that this thread has a buffer.
+		Object *first = runFn<Object *>(S("tests.bs.createInlineAlloc"), 0);
+		Type *type = runtime::typeOf(first);
+		const GcType *gcType = type->gcType();
+
+		// The object is placed where 'alloc' was in the buffer. The buffer is refilled every now
+		// and then, so try a few times.
+		Bool inlined = false;
+		for (Int i = 0; i < 10 && !inlined; i++) {
+			byte *alloc = *(byte **)(inlineBuffer(a) + a.allocOffset);
+			Object *o = runFn<Object *>(S("tests.bs.createInlineAlloc"), i);
+			inlined = (byte *)o == alloc + a.headerSize;
+		}
+		CHECK(inlined);
+
+		// Reserve memory in the same way as generated code, but let the GC interfere before the
+		// allocation is committed. 'inlineTrapped' shall give us a valid object anyway.
+		size_t size = (a.headerSize + gcType->stride + a.align - 1) & ~(a.align - 1);
+		byte *buffer = inlineBuffer(a);
+		if (*(byte **)(buffer + a.allocOffset) + size > *(byte **)(buffer + a.limitOffset)) {
+			// Make the GC refill the buffer.
+			runFn<Object *>(S("tests.bs.createInlineAlloc"), 0);
+			buffer = inlineBuffer(a);
+		}
+
+		byte **init = (byte **)(buffer + a.initOffset);
+		byte **alloc = (byte **)(buffer + a.allocOffset);
+		byte **limit = (byte **)(buffer + a.limitOffset);
+		byte *start = *alloc;
+		CHECK(start + size <= *limit);
+		*alloc = start + size;
+		memset(start, 0, size);
+		*(const GcType **)start = gcType;
+
+		e.gc.collect();
+
+		*init = *alloc;
+		void *obj = start + a.headerSize;
+		CHECK_EQ(*limit, (byte *)null);
+		if (*limit == null)
+			obj = e.gc.inlineTrapped(gcType, obj);
+		CHECK_EQ(runtime::typeOf((RootObject *)obj), type);
+	}
+
+} END_TEST
+
+#endif
+
 /**
  * Long-running stresstest of the GC logic. Too slow for regular use, but good when debugging.
  */
@@ -0,0 +1,108 @@
+#include "stdafx.h"
+#include "Fn.h"
+#include "Compiler/CodeCache.h"
+#include "Code/Listing.h"
+#include "Code/Binary.h"
+#include "Code/Recording.h"
+#include "Core/Io/Url.h"
+#include "Core/Io/Stream.h"
+
+#ifdef POSIX
+
+#include <unistd.h>
+
+using namespace code;
+
+// Remove a directory and everything in it.
+static void removeAll(Url *url) {
+	if (url->dir()) {
+		Array<Url *> *children = url->children();
+		for (Nat i = 0; i < children->count(); i++)
+			removeAll(children->at(i));
+		rmdir(url->format()->utf8_str());
+	} else {
+		unlink(url->format()->utf8_str());
+	}
+}
+
+// Create a file with some contents.
+static void writeFile(Url *file, const char *contents) {
+	OStream *out = file->write();
+	out->write(buffer(file->engine(), (const Byte *)contents, Nat(strlen(contents))));
+	out->close();
+}
+
+// Generate code for a function that adds 'amount' to its parameter, and record it.
+static Recording *recordAdd(Engine &e, Int amount) {
+	Listing *l = new (e) Listing();
+	l->result = intDesc(e);
+	Var p = l->createIntParam();
+
+	*l << prolog();
+	*l << mov(eax, p);
+	*l << add(eax, intConst(amount));
+	*l << fnRet(eax);
+
+	Recording *r = new (e) Recording();
+	Binary::detached(e.arena(), l, false, r)->attach();
+	return r;
+}
+
+// Create a cache in 'dir', as it would be created at startup after loading 'files'.
+static CodeCache *openCache(Url *dir, Array<Url *> *files) {
+	CodeCache *cache = new (dir->engine()) CodeCache();
+	cache->open(dir);
+	cache->loaded(files);
+	return cache;
+}
+
+BEGIN_TEST(CodeCacheTest, SimpleBS) {
+	Engine &e = gEngine();
+	Function *fn = findFn<Int>(S("tests.bs-simple.inlineCaller"));
+
+	Url *root = parsePath(new (e) Str(S("/tmp")))->pushDir(TO_S(e, S("storm-cache-test-") << Nat(getpid())));
+	removeAll(root);
+	VERIFY(root->createDir());
+
+	Url *cacheDir = root->pushDir(new (e) Str(S("cache")));
+	Url *srcDir = root->pushDir(new (e) Str(S("src")));
+	VERIFY(cacheDir->createDir());
+	VERIFY(srcDir->createDir());
+
+	Url *source = srcDir->push(new (e) Str(S("a.bs")));
+	writeFile(source, "// Source.");
+	Array<Url *> *files = new (e) Array<Url *>();
+	files->push(source);
+
+	Recording *record = recordAdd(e, 5);
+	VERIFY(record->portable);
+
+	CodeCache *cache = openCache(cacheDir, files);
+	CHECK(!cache->load(fn));
+	cache->save(fn, record);
+
+	// Load the code again, as if the system was restarted.
+	typedef Int (*Fn)(Int);
+	cache = openCache(cacheDir, files);
+	Binary *loaded = cache->load(fn);
+	VERIFY(loaded);
+	CHECK_EQ((*(Fn)loaded->address())(10), 15);
+
+	// Adding a file to the directory invalidates the entry, even if it is not loaded.
+	writeFile(srcDir->push(new (e) Str(S("b.bs"))), "// Another source.");
+	cache = openCache(cacheDir, files);
+	CHECK(!cache->load(fn));
+
+	// ...and so does modifying a file that was loaded.
+	cache->save(fn, record);
+	cache = openCache(cacheDir, files);
+	CHECK(cache->load(fn));
+	writeFile(source, "// Modified source.");
+	cache = openCache(cacheDir, files);
+	CHECK(!cache->load(fn));
+
+	removeAll(root);
+
+} END_TEST
+
+#endif
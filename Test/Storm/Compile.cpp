@@ -1,4 +1,5 @@
 #include "stdafx.h"
+#include "Fn.h"
 #include "Compiler/Package.h"
 
 /**
@@ -44,3 +45,11 @@ BEGIN_TEST(Progvis, Compile) {
 	Engine &e = gEngine();
 	CHECK_RUNS(e.package(S("progvis"))->compile());
 } END_TEST
+
+BEGIN_TEST(Parallel, Compile) {
+	// Machine code is produced by the CompilePool here. Make sure it works.
+	Engine &e = gEngine();
+	CHECK_RUNS(e.package(S("tests.bs-simple"))->compile());
+	CHECK_EQ(runFn<Int>(S("tests.bs-simple.loop1")), 1024);
+	CHECK_EQ(runFn<Int>(S("tests.bs-simple.inlineCaller"), 2), 20);
+} END_TEST
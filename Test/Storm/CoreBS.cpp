@@ -3,6 +3,7 @@
 #include "Compiler/Debug.h"
 #include "Compiler/Exception.h"
 #include "Compiler/Package.h"
+#include "Compiler/InlineCache.h"
 #include "Core/Timing.h"
 #include "Core/Set.h"
 #include "Core/Variant.h"
@@ -72,6 +73,28 @@ BEGIN_TEST(InheritanceTest, BS) {
 	CHECK_EQ(runFn<Int>(S("tests.bs.testInner")), 25);
 } END_TEST
 
+BEGIN_TEST(InlineCacheTest, BS) {
+	// Make 'testInlineCache' optimized. The first call sees a 'Base', the second a 'Derived'.
+	CHECK_EQ(runFn<Int>(S("tests.bs.testInlineCache"), 1500, 0), 10 + 1500*20);
+
+	Function *fn = findFn<Int, Int>(S("tests.bs.testInlineCache"));
+	VERIFY(waitOptimized(fn));
+
+	Array<InlineCache *> *caches = as<LazyCode>(fn->getCode())->inlineCaches();
+	VERIFY(caches->count() == 2);
+	Nat hits0 = caches->at(0)->hits(), misses0 = caches->at(0)->misses();
+	Nat hits1 = caches->at(1)->hits(), misses1 = caches->at(1)->misses();
+
+	CHECK_EQ(runFn<Int>(S("tests.bs.testInlineCache"), 10, 0), 10 + 10*20);
+	CHECK_EQ(runFn<Int>(S("tests.bs.testInlineCache"), 10, 1), 20 + 10*20);
+
+	// The first call site sees both types, the second one only sees 'Derived'.
+	CHECK(caches->at(0)->hits() > hits0);
+	CHECK(caches->at(0)->misses() > misses0);
+	CHECK(caches->at(1)->hits() > hits1);
+	CHECK_EQ(caches->at(1)->misses(), misses1);
+} END_TEST
+
 BEGIN_TEST(AbstractTest, BS) {
 	CHECK_EQ(runFn<Int>(S("tests.bs.createNoAbstract")), 10);
 	CHECK_ERROR(runFn<Int>(S("tests.bs.createAbstract")), InstantiationError);
@@ -1,6 +1,9 @@
 #pragma once
 #include "Compiler/Engine.h"
+#include "Compiler/Function.h"
+#include "Compiler/Code.h"
 #include "OS/FnCall.h"
+#include "OS/UThread.h"
 
 template <class Res>
 inline Res runFn(const wchar *name) {
@@ -62,3 +65,41 @@ inline Res runFnUnsafe(const wchar *name) {
 	os::FnCall<Res> c = os::fnCall();
 	return c.call(f->ref().address(), false);
 }
+
+
+template <class T>
+inline Function *findFn(const wchar *name) {
+	Engine &e = gEngine();
+	SimpleName *sName = parseSimpleName(e, name);
+	sName->last()->params->push(storm::Value(StormInfo<T>::type(e)));
+	Function *f = as<Function>(e.scope().find(sName));
+	assert(f, L"Function " + ::toS(sName) + L" not found!");
+	return f;
+}
+
+template <class T, class U>
+inline Function *findFn(const wchar *name) {
+	Engine &e = gEngine();
+	SimpleName *sName = parseSimpleName(e, name);
+	sName->last()->params->push(storm::Value(StormInfo<T>::type(e)));
+	sName->last()->params->push(storm::Value(StormInfo<U>::type(e)));
+	Function *f = as<Function>(e.scope().find(sName));
+	assert(f, L"Function " + ::toS(sName) + L" not found!");
+	return f;
+}
+
+// Wait until 'f' uses optimized code. The optimized code is compiled on the Compiler thread in the
+// background, so we let it run until it is done. Returns false if that does not happen within a
+// few seconds.
+inline bool waitOptimized(Function *f) {
+	LazyCode *code = as<LazyCode>(f->getCode());
+	if (!code)
+		return false;
+
+	for (nat i = 0; i < 5000 && !code->optimized(); i++) {
+		os::UThread::leave();
+		if (!code->optimized())
+			os::UThread::sleep(1);
+	}
+	return code->optimized();
+}
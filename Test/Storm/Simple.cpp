@@ -1,6 +1,9 @@
 #include "stdafx.h"
 #include "Fn.h"
 #include "Compiler/Exception.h"
+#include "Compiler/Inline.h"
+#include "Code/Listing.h"
+#include "Code/Binary.h"
 
 BEGIN_TEST(BasicSyntax, SimpleBS) {
 	CHECK_RUNS(runFn<void>(S("tests.bs-simple.voidFn")));
@@ -42,3 +45,73 @@ BEGIN_TEST(LoopTest, SimpleBS) {
 	CHECK_EQ(runFn<Int>(S("tests.bs-simple.loop5")), 27);
 } END_TEST
 
+
+BEGIN_TEST(InlineTest, SimpleBS) {
+	// Compile 'inlineAdd' first, so that it is inlined into 'inlineCaller'.
+	CHECK_EQ(runFn<Int>(S("tests.bs-simple.inlineAdd"), 1, 2), 3);
+	CHECK_EQ(runFn<Int>(S("tests.bs-simple.inlineCaller"), 2), 20);
+	CHECK_EQ(runFn<Int>(S("tests.bs-simple.inlineCaller"), -3), 0);
+} END_TEST
+
+BEGIN_TEST(InlineRegisterTest, SimpleBS) {
+	using namespace code;
+	Engine &e = gEngine();
+
+	// Compile 'inlineAdd' so that it can be inlined.
+	CHECK_EQ(runFn<Int>(S("tests.bs-simple.inlineAdd"), 1, 2), 3);
+
+	Function *callee = findFn<Int, Int>(S("tests.bs-simple.inlineAdd"));
+	Function *owner = findFn<Int>(S("tests.bs-simple.inlineCaller"));
+
+	// Call 'inlineAdd' with a parameter in a register. 'begin' does not preserve registers, so the
+	// inliner needs to take care of that.
+	Listing *l = new (e) Listing();
+	l->result = intDesc(e);
+	Var p = l->createIntParam();
+	*l << prolog();
+	*l << mov(eax, p);
+	*l << add(eax, intConst(10));
+	*l << fnParam(intDesc(e), eax);
+	*l << fnParam(intDesc(e), intConst(2));
+	*l << fnCall(callee->ref(), false, intDesc(e), eax);
+	*l << fnRet(eax);
+
+	Array<Function *> *inlined = new (e) Array<Function *>();
+	Listing *r = inlineCalls(owner, l, inlined);
+	CHECK_NEQ(r, l);
+	CHECK_EQ(inlined->count(), Nat(1));
+
+	Binary *b = new (e) Binary(e.arena(), r);
+	typedef Int (*Fn)(Int);
+	Fn fn = (Fn)b->address();
+	CHECK_EQ((*fn)(5), 17);
+} END_TEST
+
+BEGIN_TEST(TierTest, SimpleBS) {
+	// Call functions enough times to make them optimized, and make sure they still work.
+	Int sum = 0;
+	for (Int i = 0; i < 1500; i++)
+		sum += runFn<Int>(S("tests.bs-simple.inlineCaller"), i % 3);
+	CHECK_EQ(sum, 500*6 + 500*12 + 500*20);
+	CHECK(waitOptimized(findFn<Int>(S("tests.bs-simple.inlineCaller"))));
+
+	CHECK_EQ(runFn<Int>(S("tests.bs-simple.inlineCaller"), 2), 20);
+	CHECK_EQ(runFn<Int>(S("tests.bs-simple.loop1")), 1024);
+	CHECK_EQ(runFn<Int>(S("tests.bs-simple.while"), 10), 1024);
+} END_TEST
+
+BEGIN_TEST(TailCallTest, SimpleBS) {
+	// Recurse deep enough to make the functions optimized.
+	CHECK_EQ(runFn<Int>(S("tests.bs-simple.tailSum"), 2000, 0), 2001000);
+	CHECK_EQ(runFn<Int>(S("tests.bs-simple.tailCount"), 2000, 0), 2000);
+
+	// The optimized code needs to be in use for the deep recursion below to work.
+	CHECK(waitOptimized(findFn<Int, Int>(S("tests.bs-simple.tailSum"))));
+	VERIFY(waitOptimized(findFn<Int, Int>(S("tests.bs-simple.tailCount"))));
+
+	CHECK_EQ(runFn<Int>(S("tests.bs-simple.tailSum"), 10000, 0), 50005000);
+	CHECK_EQ(runFn<Int>(S("tests.bs-simple.tailSum"), 0, 7), 7);
+
+	// This overflows the stack unless the recursion is turned into a loop.
+	CHECK_EQ(runFn<Int>(S("tests.bs-simple.tailCount"), 10000000, 0), 10000000);
+} END_TEST
@@ -2,6 +2,7 @@
 #include "Fn.h"
 #include "Compiler/Debug.h"
 #include "Compiler/Exception.h"
+#include "Compiler/CodeGen.h"
 
 BEGIN_TEST(BSThread, BS) {
 	using namespace storm::debug;
@@ -46,3 +47,24 @@ BEGIN_TEST(BSThread, BS) {
 	CHECK_EQ(runFn<Int>(S("tests.bs.threadVarAccess")), 6); // 1 copy, 1 deep copy. Starts at 4.
 	CHECK_ERROR(runFn<void>(S("tests.bs.threadVarAssign")), SyntaxError);
 } END_TEST
+
+BEGIN_TEST(SharedThunk, BS) {
+	Engine &e = gEngine();
+
+	Value intVal(StormInfo<Int>::type(e));
+	Value strVal(StormInfo<Str>::type(e));
+
+	Array<Value> *a = new (e) Array<Value>();
+	a->push(intVal);
+	a->push(strVal);
+	Array<Value> *b = new (e) Array<Value>(*a);
+
+	// Signatures with the same layout share the thunk.
+	code::RefSource *thunk = sharedCallThunk(intVal, a);
+	CHECK(thunk);
+	CHECK_EQ(thunk, sharedCallThunk(intVal, b));
+
+	// Different signatures do not.
+	b->push(intVal);
+	CHECK_NEQ(thunk, sharedCallThunk(intVal, b));
+} END_TEST
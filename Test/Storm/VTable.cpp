@@ -348,3 +348,42 @@ BEGIN_TEST(VTableCppOnly, Storm) {
 	CHECK_RUNS(fnParams.call(call->pointer(), true));
 
 } END_TEST;
+
+static Int callDevirtLoop(Function *fn, RootObject *o, Int times) {
+	os::FnCall<Int> c = os::fnCall().add(o).add(times);
+	return c.call(fn->ref().address(), false);
+}
+
+// Check that calls to functions without overrides are direct and may be inlined, and that callers
+// are updated when an override is added.
+BEGIN_TEST(VTableDevirtTest, Storm) {
+	Engine &e = gEngine();
+
+	Package *pkg = as<Package>(e.scope().find(parseSimpleName(e, S("tests.bs"))));
+	VERIFY(pkg);
+	Type *devirt = as<Type>(pkg->find(S("Devirt"), new (e) Array<Value>(), Scope()));
+	VERIFY(devirt);
+	Function *value = as<Function>(devirt->find(S("value"), Value(devirt), Scope()));
+	VERIFY(value);
+
+	Array<Value> *params = new (e) Array<Value>(1, Value(devirt));
+	params->push(Value(StormInfo<Int>::type(e)));
+	Function *loop = as<Function>(pkg->find(S("devirtLoop"), params, Scope()));
+	VERIFY(loop);
+
+	RootObject *base = alloc(devirt);
+	CHECK(!usesVTable(value));
+
+	// Make 'devirtLoop' optimized, so that 'value' is inlined.
+	CHECK_EQ(callDevirtLoop(loop, base, 1500), 15000);
+	os::UThread::leave();
+	CHECK_EQ(callDevirtLoop(loop, base, 10), 100);
+
+	// Override 'value'. 'devirtLoop' needs to use the vtable now.
+	Type *sub = addSubclass(pkg, devirt, S("value"), address(&extendReplace));
+	CHECK(usesVTable(value));
+
+	RootObject *derived = alloc(sub);
+	CHECK_EQ(callDevirtLoop(loop, derived, 10), 200);
+	CHECK_EQ(callDevirtLoop(loop, base, 10), 100);
+} END_TEST